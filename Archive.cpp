@@ -0,0 +1,337 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the compressed block archive of the SPHINX chain.
+
+// Frames:
+    // Blocks are encoded as in the block file (hash + CBOR block) and packed into frames of about ArchiveOptions::frameBytes, each compressed on its own with the LZ4-format compressor of Compress.hpp.
+    // Compressing many blocks together lets the repeated field names, keys and hash prefixes of neighbouring blocks compress against each other, which a per-block record cannot do.
+
+// Index:
+    // The index at the end of the file lists every frame (offset, sizes, CRC-32, block count) and every block hash, and the fixed-size footer points to it.
+    // Opening an archive reads the footer and the index only; block hashes are views into the mapping, so getBlockHash never decompresses anything.
+
+// Random Access:
+    // decodeBlock finds the frame by binary search over the first block of every frame, decompresses it (checking its CRC) and walks the length prefixes to the block.
+    // A few recently used frames stay decompressed, so reading neighbouring blocks costs one decompression per frame.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Archive.hpp"
+#include "Compress.hpp"
+
+namespace SPHINXStore {
+
+    namespace {
+        constexpr char INDEX_MAGIC[4] = {'S', 'P', 'X', 'I'};
+        constexpr size_t FRAME_ENTRY_SIZE = 24;
+
+        void putU16(std::vector<uint8_t>& out, uint16_t value) {
+            out.push_back(static_cast<uint8_t>(value));
+            out.push_back(static_cast<uint8_t>(value >> 8));
+        }
+
+        void putU32(std::vector<uint8_t>& out, uint32_t value) {
+            for (int shift = 0; shift < 32; shift += 8) {
+                out.push_back(static_cast<uint8_t>(value >> shift));
+            }
+        }
+
+        void putU64(std::vector<uint8_t>& out, uint64_t value) {
+            for (int shift = 0; shift < 64; shift += 8) {
+                out.push_back(static_cast<uint8_t>(value >> shift));
+            }
+        }
+
+        uint16_t getU16(const uint8_t* in) {
+            return static_cast<uint16_t>(in[0] | (in[1] << 8));
+        }
+
+        uint32_t getU32(const uint8_t* in) {
+            return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+                   (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+        }
+
+        uint64_t getU64(const uint8_t* in) {
+            return static_cast<uint64_t>(getU32(in)) | (static_cast<uint64_t>(getU32(in + 4)) << 32);
+        }
+    } // namespace
+
+    ArchiveWriter::ArchiveWriter(const std::string& filename, const nlohmann::json& metadata, ArchiveOptions options)
+        : filename_(filename), tempFilename_(filename + ".tmp"), options_(options) {
+        file_ = std::fopen(tempFilename_.c_str(), "wb");
+        if (file_ == nullptr) {
+            throw std::runtime_error("Failed to create block archive: " + tempFilename_);
+        }
+        const std::vector<uint8_t> encodedMetadata = nlohmann::json::to_cbor(metadata);
+        std::vector<uint8_t> header(ARCHIVE_MAGIC, ARCHIVE_MAGIC + sizeof(ARCHIVE_MAGIC));
+        putU32(header, static_cast<uint32_t>(encodedMetadata.size()));
+        header.insert(header.end(), encodedMetadata.begin(), encodedMetadata.end());
+        write(header);
+    }
+
+    ArchiveWriter::~ArchiveWriter() {
+        if (file_ != nullptr) {
+            std::fclose(file_);  // finish() was never called, leave the real file untouched
+            std::remove(tempFilename_.c_str());
+        }
+    }
+
+    void ArchiveWriter::write(const std::vector<uint8_t>& bytes) {
+        if (std::fwrite(bytes.data(), 1, bytes.size(), file_) != bytes.size()) {
+            throw std::runtime_error("Failed to write block archive: " + tempFilename_);
+        }
+        offset_ += bytes.size();
+    }
+
+    // Add a block to the current frame
+    void ArchiveWriter::append(const SPHINXBlock::Block& block) {
+        const std::vector<uint8_t> record = encodeRecord(block);  // u32 body length | u32 crc | body
+        const uint8_t* body = record.data() + RECORD_HEADER_SIZE;
+        const size_t bodyLength = record.size() - RECORD_HEADER_SIZE;
+        putU32(frame_, static_cast<uint32_t>(bodyLength));
+        frame_.insert(frame_.end(), body, body + bodyLength);
+        ++frameBlocks_;
+
+        const std::string hash = block.getBlockHash();  // Length already checked by encodeRecord
+        putU16(hashes_, static_cast<uint16_t>(hash.size()));
+        hashes_.insert(hashes_.end(), hash.begin(), hash.end());
+        ++blockCount_;
+
+        if (frame_.size() >= options_.frameBytes) {
+            flushFrame();
+        }
+    }
+
+    // Compress and write the current frame
+    void ArchiveWriter::flushFrame() {
+        if (frameBlocks_ == 0) {
+            return;
+        }
+        if (frame_.size() > UINT32_MAX) {
+            throw std::runtime_error("Frame too large for the block archive format");
+        }
+        const std::vector<uint8_t> compressed = SPHINXCompress::compress(frame_.data(), frame_.size());
+        frames_.push_back(Frame{offset_, static_cast<uint32_t>(compressed.size()), static_cast<uint32_t>(frame_.size()),
+                                crc32(frame_.data(), frame_.size()), frameBlocks_});
+        write(compressed);
+        rawBytes_ += frame_.size();
+        compressedBytes_ += compressed.size();
+        frame_.clear();
+        frameBlocks_ = 0;
+    }
+
+    // Write the index and footer, sync and rename the temporary file over the real one
+    void ArchiveWriter::finish() {
+        flushFrame();
+
+        std::vector<uint8_t> index;
+        index.reserve(8 + frames_.size() * FRAME_ENTRY_SIZE + hashes_.size());
+        putU32(index, static_cast<uint32_t>(frames_.size()));
+        for (const Frame& frame : frames_) {
+            putU64(index, frame.offset);
+            putU32(index, frame.compressedLength);
+            putU32(index, frame.rawLength);
+            putU32(index, frame.crc);
+            putU32(index, frame.blockCount);
+        }
+        putU32(index, blockCount_);
+        index.insert(index.end(), hashes_.begin(), hashes_.end());
+
+        std::vector<uint8_t> footer;
+        putU64(footer, offset_);
+        putU32(footer, crc32(index.data(), index.size()));
+        footer.insert(footer.end(), INDEX_MAGIC, INDEX_MAGIC + sizeof(INDEX_MAGIC));
+        write(index);
+        write(footer);
+
+        if (std::fflush(file_) != 0 || ::fsync(::fileno(file_)) != 0) {
+            throw std::runtime_error("Failed to sync block archive: " + tempFilename_);
+        }
+        std::fclose(file_);
+        file_ = nullptr;
+        if (std::rename(tempFilename_.c_str(), filename_.c_str()) != 0) {
+            throw std::runtime_error("Failed to move block archive into place: " + filename_);
+        }
+    }
+
+    BlockArchive::~BlockArchive() {
+        if (data_ != nullptr) {
+            ::munmap(const_cast<uint8_t*>(data_), mappedSize_);
+        }
+    }
+
+    // Map the archive and read its index
+    std::shared_ptr<BlockArchive> BlockArchive::open(const std::string& filename) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open block archive: " + filename);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Failed to stat block archive: " + filename);
+        }
+
+        std::shared_ptr<BlockArchive> archive(new BlockArchive());
+        archive->mappedSize_ = static_cast<size_t>(info.st_size);
+        if (archive->mappedSize_ < sizeof(ARCHIVE_MAGIC) + 4 + ARCHIVE_FOOTER_SIZE) {
+            ::close(fd);
+            throw std::runtime_error("Not a SPHINX block archive: " + filename);
+        }
+        void* mapping = ::mmap(nullptr, archive->mappedSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);  // The mapping keeps the file alive
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error("Failed to map block archive: " + filename);
+        }
+        archive->data_ = static_cast<const uint8_t*>(mapping);
+        ::madvise(mapping, archive->mappedSize_, MADV_RANDOM);  // Frames are read on demand, not streamed
+
+        const uint8_t* data = archive->data_;
+        const size_t size = archive->mappedSize_;
+        if (std::memcmp(data, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0) {
+            throw std::runtime_error("Not a SPHINX block archive: " + filename);
+        }
+        const size_t metadataLength = getU32(data + sizeof(ARCHIVE_MAGIC));
+        const size_t framesStart = sizeof(ARCHIVE_MAGIC) + 4 + metadataLength;
+        if (framesStart > size - ARCHIVE_FOOTER_SIZE) {
+            throw std::runtime_error("Corrupt block archive header: " + filename);
+        }
+        if (metadataLength > 0) {
+            archive->metadata_ = nlohmann::json::from_cbor(data + sizeof(ARCHIVE_MAGIC) + 4, data + framesStart);
+        }
+
+        // Footer -> index, checked before anything in it is trusted
+        const uint8_t* footer = data + size - ARCHIVE_FOOTER_SIZE;
+        if (std::memcmp(footer + 12, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) {
+            throw std::runtime_error("Block archive has no index (incomplete write?): " + filename);
+        }
+        const uint64_t indexOffset = getU64(footer);
+        if (indexOffset < framesStart || indexOffset > size - ARCHIVE_FOOTER_SIZE) {
+            throw std::runtime_error("Corrupt block archive footer: " + filename);
+        }
+        const uint8_t* index = data + indexOffset;
+        const size_t indexLength = size - ARCHIVE_FOOTER_SIZE - indexOffset;
+        if (crc32(index, indexLength) != getU32(footer + 8)) {
+            throw std::runtime_error("Block archive index checksum mismatch: " + filename);
+        }
+
+        auto corrupt = [&filename]() { return std::runtime_error("Corrupt block archive index: " + filename); };
+        size_t position = 0;
+        if (indexLength < 4) {
+            throw corrupt();
+        }
+        const size_t frameCount = getU32(index);
+        position += 4;
+        if (frameCount > (indexLength - position) / FRAME_ENTRY_SIZE) {
+            throw corrupt();
+        }
+        archive->frames_.reserve(frameCount);
+        uint32_t firstBlock = 0;
+        for (size_t i = 0; i < frameCount; ++i, position += FRAME_ENTRY_SIZE) {
+            const uint8_t* entry = index + position;
+            Frame frame{getU64(entry), getU32(entry + 8), getU32(entry + 12), getU32(entry + 16), firstBlock};
+            if (frame.offset < framesStart || frame.offset + frame.compressedLength > indexOffset) {
+                throw corrupt();
+            }
+            firstBlock += getU32(entry + 20);
+            archive->frames_.push_back(frame);
+        }
+
+        if (indexLength - position < 4) {
+            throw corrupt();
+        }
+        const size_t blockCount = getU32(index + position);
+        position += 4;
+        if (blockCount != firstBlock) {
+            throw corrupt();
+        }
+        archive->hashes_.reserve(blockCount);
+        for (size_t i = 0; i < blockCount; ++i) {
+            if (indexLength - position < 2 || indexLength - position - 2 < getU16(index + position)) {
+                throw corrupt();
+            }
+            const size_t hashLength = getU16(index + position);
+            archive->hashes_.emplace_back(reinterpret_cast<const char*>(index + position + 2), hashLength);
+            position += 2 + hashLength;
+        }
+        return archive;
+    }
+
+    std::string_view BlockArchive::blockHash(size_t index) const {
+        if (index >= hashes_.size()) {
+            throw std::out_of_range("Block index out of range");
+        }
+        return hashes_[index];
+    }
+
+    // Get a decompressed frame, from the cache or by decompressing it
+    std::shared_ptr<const std::vector<uint8_t>> BlockArchive::loadFrame(size_t frameIndex) const {
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex_);
+            for (size_t i = 0; i < cache_.size(); ++i) {
+                if (cache_[i].first == frameIndex) {
+                    std::rotate(cache_.begin(), cache_.begin() + static_cast<std::ptrdiff_t>(i), cache_.begin() + static_cast<std::ptrdiff_t>(i) + 1);
+                    return cache_.front().second;
+                }
+            }
+        }
+
+        // Decompress outside the lock so readers of other frames are not held up
+        const Frame& frame = frames_[frameIndex];
+        auto raw = std::make_shared<const std::vector<uint8_t>>(SPHINXCompress::decompress(data_ + frame.offset, frame.compressedLength, frame.rawLength));
+        if (crc32(raw->data(), raw->size()) != frame.crc) {
+            throw std::runtime_error("Block archive frame checksum mismatch at frame " + std::to_string(frameIndex));
+        }
+
+        std::lock_guard<std::mutex> lock(cacheMutex_);
+        cache_.insert(cache_.begin(), {frameIndex, raw});
+        if (cache_.size() > CACHED_FRAMES) {
+            cache_.pop_back();
+        }
+        return raw;
+    }
+
+    // Decode one block by decompressing only its frame
+    SPHINXBlock::Block BlockArchive::decodeBlock(size_t index) const {
+        if (index >= hashes_.size()) {
+            throw std::out_of_range("Block index out of range");
+        }
+        auto it = std::upper_bound(frames_.begin(), frames_.end(), index, [](size_t block, const Frame& frame) { return block < frame.firstBlock; });
+        const size_t frameIndex = static_cast<size_t>(it - frames_.begin()) - 1;
+        const std::shared_ptr<const std::vector<uint8_t>> raw = loadFrame(frameIndex);
+
+        size_t position = 0;
+        for (size_t block = frames_[frameIndex].firstBlock;; ++block) {
+            if (raw->size() - position < 4 || raw->size() - position - 4 < getU32(raw->data() + position)) {
+                throw std::runtime_error("Corrupt block archive frame " + std::to_string(frameIndex));
+            }
+            const size_t bodyLength = getU32(raw->data() + position);
+            if (block == index) {
+                return decodeRecordBody(raw->data() + position + 4, bodyLength);
+            }
+            position += 4 + bodyLength;
+        }
+    }
+} // namespace SPHINXStore
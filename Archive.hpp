@@ -0,0 +1,146 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXARCHIVE_HPP
+#define SPHINXARCHIVE_HPP
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "json.hpp"
+#include "Block.hpp"
+#include "BlockStore.hpp"
+
+namespace SPHINXStore {
+
+    // Magic bytes at the start of every block archive.
+    constexpr char ARCHIVE_MAGIC[8] = {'S', 'P', 'X', 'A', 'R', 'C', '0', '1'};
+
+    // Size of the archive footer: u64 index offset + u32 CRC-32 of the index + 4 magic bytes.
+    constexpr size_t ARCHIVE_FOOTER_SIZE = 16;
+
+    // Layout of an archive.
+    struct ArchiveOptions {
+        size_t frameBytes = 64 * 1024;  // Uncompressed bytes per frame: larger frames compress better, smaller ones read faster
+    };
+
+    // Writer for block archives. Blocks are grouped into frames that are compressed independently (Compress.hpp), and
+    // a frame index plus every block hash is written at the end, so a reader can serve any block by decompressing one frame:
+    //   magic | u32 metadata length | CBOR metadata | frames | index | footer
+    //   frame = compressed (u32 body length | record body) per block
+    //   index = u32 frame count | per frame: u64 offset, u32 compressed length, u32 raw length, u32 crc32(raw), u32 block count
+    //           | u32 block count | per block: u16 hash length | hash
+    // Writes go to "<filename>.tmp" and are renamed into place by finish().
+    class ArchiveWriter {
+    public:
+        ArchiveWriter(const std::string& filename, const nlohmann::json& metadata, ArchiveOptions options = {});
+        ~ArchiveWriter();
+
+        ArchiveWriter(const ArchiveWriter&) = delete;
+        ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+        // Append one block; a frame is compressed and written once it is full.
+        void append(const SPHINXBlock::Block& block);
+
+        // Write the last frame and the index, sync and move the file into place.
+        void finish();
+
+        // Frame bytes before and after compression so far, to report the compression ratio.
+        uint64_t rawBytes() const { return rawBytes_; }
+        uint64_t compressedBytes() const { return compressedBytes_; }
+
+    private:
+        struct Frame {
+            uint64_t offset;
+            uint32_t compressedLength;
+            uint32_t rawLength;
+            uint32_t crc;
+            uint32_t blockCount;
+        };
+
+        void write(const std::vector<uint8_t>& bytes);
+        void flushFrame();
+
+        std::string filename_;  // Final file name
+        std::string tempFilename_;  // File being written
+        std::FILE* file_ = nullptr;
+        ArchiveOptions options_;
+        uint64_t offset_ = 0;  // Bytes written so far
+        std::vector<uint8_t> frame_;  // Records of the frame being filled
+        uint32_t frameBlocks_ = 0;
+        std::vector<Frame> frames_;
+        std::vector<uint8_t> hashes_;  // Hash table of the index, built as blocks arrive
+        uint32_t blockCount_ = 0;
+        uint64_t rawBytes_ = 0;
+        uint64_t compressedBytes_ = 0;
+    };
+
+    // Read-only block archive opened through mmap. Opening reads only the index; a block is served by decompressing
+    // its frame, and the most recently used frames are kept decompressed so neighbouring blocks cost no extra work.
+    class BlockArchive : public BlockSource {
+    public:
+        ~BlockArchive() override;
+
+        BlockArchive(const BlockArchive&) = delete;
+        BlockArchive& operator=(const BlockArchive&) = delete;
+
+        // Map an archive and read its index; throws std::runtime_error if the file is not a complete archive.
+        static std::shared_ptr<BlockArchive> open(const std::string& filename);
+
+        size_t size() const override { return hashes_.size(); }
+        std::string_view blockHash(size_t index) const override;
+        SPHINXBlock::Block decodeBlock(size_t index) const override;
+
+        // Chain metadata stored in the archive header (public key etc.).
+        const nlohmann::json& metadata() const { return metadata_; }
+
+        // Number of frames in the archive.
+        size_t frameCount() const { return frames_.size(); }
+
+    private:
+        struct Frame {
+            uint64_t offset;
+            uint32_t compressedLength;
+            uint32_t rawLength;
+            uint32_t crc;
+            uint32_t firstBlock;
+        };
+
+        static constexpr size_t CACHED_FRAMES = 4;
+
+        BlockArchive() = default;
+
+        std::shared_ptr<const std::vector<uint8_t>> loadFrame(size_t frameIndex) const;
+
+        const uint8_t* data_ = nullptr;  // Start of the mapping
+        size_t mappedSize_ = 0;  // Length of the mapping
+        std::vector<Frame> frames_;
+        std::vector<std::string_view> hashes_;  // Block hashes, viewing the index in the mapping
+        nlohmann::json metadata_;
+
+        mutable std::mutex cacheMutex_;
+        mutable std::vector<std::pair<size_t, std::shared_ptr<const std::vector<uint8_t>>>> cache_;  // Decompressed frames, most recently used first
+    };
+} // namespace SPHINXStore
+
+#endif // SPHINXARCHIVE_HPP
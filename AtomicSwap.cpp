@@ -0,0 +1,462 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the non-blocking atomic swap engine used by the SPHINX chain.
+
+// State Machine:
+    // A swap moves Created -> Broadcast -> Confirmed -> Settled. A failure or a missed deadline moves it to Refunded instead; no balance is touched before settlement, so a refund has nothing to undo.
+    // The caller gets a std::shared_future that resolves with the final state, so no thread waits for confirmations.
+
+// Events and Timers:
+    // confirmTransaction marks a leg as confirmed as soon as the network reports it.
+    // Legs that can only be polled are checked by poll timers, and every swap has a deadline timer. All timers live in one hashed timer wheel driven by a single thread, so thousands of swaps cost one thread plus short tasks on the shared pool.
+
+// Persistence:
+    // Every transition is appended to the swap journal as one JSON line and synced with fdatasync before the swap moves on; on restart recover replays the journal and resumes the swaps that have not finished.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "AtomicSwap.hpp"
+#include "ThreadPool.hpp"
+
+namespace SPHINXSwap {
+
+    namespace {
+        int64_t unixNow() {
+            return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        SwapState stateFromString(const std::string& name) {
+            for (SwapState state : {SwapState::Created, SwapState::Broadcast, SwapState::Confirmed, SwapState::Settled, SwapState::Refunded}) {
+                if (name == toString(state)) {
+                    return state;
+                }
+            }
+            throw std::invalid_argument("Unknown swap state: " + name);
+        }
+
+        bool isTerminal(SwapState state) {
+            return state == SwapState::Settled || state == SwapState::Refunded;
+        }
+    } // namespace
+
+    // Get the name of a swap state
+    const char* toString(SwapState state) {
+        switch (state) {
+            case SwapState::Created: return "created";
+            case SwapState::Broadcast: return "broadcast";
+            case SwapState::Confirmed: return "confirmed";
+            case SwapState::Settled: return "settled";
+            case SwapState::Refunded: return "refunded";
+        }
+        return "unknown";
+    }
+
+    // Convert a swap record to JSON
+    nlohmann::json SwapRecord::toJson() const {
+        nlohmann::json swapJson;
+        swapJson["id"] = id;
+        swapJson["state"] = toString(state);
+        swapJson["senderAddress"] = senderAddress;
+        swapJson["receiverAddress"] = receiverAddress;
+        swapJson["amount"] = amount;
+        swapJson["senderTransactionId"] = senderTransactionId;
+        swapJson["receiverTransactionId"] = receiverTransactionId;
+        swapJson["senderConfirmed"] = senderConfirmed;
+        swapJson["receiverConfirmed"] = receiverConfirmed;
+        swapJson["deadline"] = deadline;
+        swapJson["failureReason"] = failureReason;
+        return swapJson;
+    }
+
+    // Load a swap record from JSON
+    SwapRecord SwapRecord::fromJson(const nlohmann::json& swapJson) {
+        SwapRecord record;
+        record.id = swapJson.at("id").get<uint64_t>();
+        record.state = stateFromString(swapJson.at("state").get<std::string>());
+        record.senderAddress = swapJson.at("senderAddress").get<std::string>();
+        record.receiverAddress = swapJson.at("receiverAddress").get<std::string>();
+        record.amount = swapJson.at("amount").get<SPHINXLedger::Amount>();
+        record.senderTransactionId = swapJson.at("senderTransactionId").get<std::string>();
+        record.receiverTransactionId = swapJson.at("receiverTransactionId").get<std::string>();
+        record.senderConfirmed = swapJson.at("senderConfirmed").get<bool>();
+        record.receiverConfirmed = swapJson.at("receiverConfirmed").get<bool>();
+        record.deadline = swapJson.at("deadline").get<int64_t>();
+        record.failureReason = swapJson.value("failureReason", "");
+        return record;
+    }
+
+    // Place a timer in the slot it expires in
+    void TimerWheel::schedule(uint64_t ticks, Timer timer) {
+        ticks = std::max<uint64_t>(1, ticks);
+        const size_t slot = (cursor_ + ticks) % slots_.size();
+        slots_[slot].push_back(Entry{(ticks - 1) / slots_.size(), timer});
+    }
+
+    // Move to the next slot and collect its expired timers
+    std::vector<TimerWheel::Timer> TimerWheel::advance() {
+        cursor_ = (cursor_ + 1) % slots_.size();
+        std::vector<Entry>& slot = slots_[cursor_];
+        std::vector<Timer> expired;
+        size_t kept = 0;
+        for (Entry& entry : slot) {
+            if (entry.rounds == 0) {
+                expired.push_back(entry.timer);
+            } else {
+                --entry.rounds;
+                slot[kept++] = entry;
+            }
+        }
+        slot.resize(kept);
+        return expired;
+    }
+
+    SwapEngine::SwapEngine(const std::string& journalFilename, SwapOptions options)
+        : options_(options), journalFilename_(journalFilename) {
+        if (!journalFilename_.empty()) {
+            journalFd_ = ::open(journalFilename_.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+            if (journalFd_ < 0) {
+                throw std::runtime_error("Failed to open swap journal: " + journalFilename_ + ": " + std::strerror(errno));
+            }
+        }
+        timerThread_ = std::thread([this] { timerLoop(); });
+    }
+
+    SwapEngine::~SwapEngine() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stopping_ = true;
+        stopSignal_.notify_all();
+        lock.unlock();
+        timerThread_.join();
+        lock.lock();
+        tasksDone_.wait(lock, [this] { return activeTasks_ == 0; });  // Pool tasks still reference the engine
+        if (journalFd_ >= 0) {
+            ::close(journalFd_);
+        }
+    }
+
+    // Register a swap and create its future
+    std::shared_future<SwapState> SwapEngine::admit(SwapRecord record, SwapCallbacks callbacks) {
+        std::shared_ptr<Swap> swap = std::make_shared<Swap>();
+        swap->record = std::move(record);
+        swap->callbacks = std::move(callbacks);
+        swap->future = swap->promise.get_future().share();
+        swaps_[swap->record.id] = swap;
+        if (!swap->record.senderTransactionId.empty()) {
+            byTransaction_[swap->record.senderTransactionId] = swap->record.id;
+        }
+        if (!swap->record.receiverTransactionId.empty()) {
+            byTransaction_[swap->record.receiverTransactionId] = swap->record.id;
+        }
+        return swap->future;
+    }
+
+    // Start a new swap; the broadcast runs on the pool and the caller returns immediately
+    std::shared_future<SwapState> SwapEngine::start(SwapRecord record, SwapCallbacks callbacks) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        record.id = nextId_++;
+        record.state = SwapState::Created;
+        if (record.deadline == 0) {
+            record.deadline = unixNow() + options_.timeout.count();
+        }
+        std::shared_future<SwapState> future = admit(std::move(record), std::move(callbacks));
+        std::shared_ptr<Swap> swap = swaps_[nextId_ - 1];
+        persist(swap->record);
+        dispatch([this, swap] { runBroadcast(swap); });
+        return future;
+    }
+
+    // Created -> Broadcast
+    void SwapEngine::runBroadcast(const std::shared_ptr<Swap>& swap) {
+        SwapRecord record;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            record = swap->record;  // Confirmations may update the record while the callback runs
+        }
+        try {
+            if (swap->callbacks.broadcast) {
+                swap->callbacks.broadcast(record);
+            }
+        } catch (const std::exception& e) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            refund(swap, std::string("Broadcast failed: ") + e.what());
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (swap->record.state != SwapState::Created) {
+            return;  // Refunded while broadcasting
+        }
+        swap->record.state = SwapState::Broadcast;
+        persist(swap->record);
+        if (swap->record.senderConfirmed && swap->record.receiverConfirmed) {
+            markConfirmed(swap, true);  // Both events arrived during the broadcast
+            return;
+        }
+        const auto remaining = std::chrono::seconds(std::max<int64_t>(0, swap->record.deadline - unixNow()));
+        schedule(remaining, TimerWheel::Timer{swap->record.id, true});
+        if (swap->callbacks.senderConfirmed || swap->callbacks.receiverConfirmed) {
+            schedule(options_.pollInterval, TimerWheel::Timer{swap->record.id, false});
+        }
+    }
+
+    // Poll the legs that have no confirmation yet
+    void SwapEngine::runPoll(const std::shared_ptr<Swap>& swap) {
+        auto poll = [](const std::function<bool()>& confirmed) {
+            try {
+                return confirmed && confirmed();
+            } catch (const std::exception&) {
+                return false;  // Treat a failed poll as "not yet"
+            }
+        };
+        bool senderConfirmed;
+        bool receiverConfirmed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            senderConfirmed = swap->record.senderConfirmed;
+            receiverConfirmed = swap->record.receiverConfirmed;
+        }
+        const bool senderDone = !senderConfirmed && poll(swap->callbacks.senderConfirmed);  // Polled without the lock
+        const bool receiverDone = !receiverConfirmed && poll(swap->callbacks.receiverConfirmed);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        swap->polling = false;
+        if (swap->record.state != SwapState::Broadcast) {
+            return;
+        }
+        if (senderDone && !swap->record.senderConfirmed) {
+            markConfirmed(swap, true);
+        }
+        if (receiverDone && swap->record.state == SwapState::Broadcast && !swap->record.receiverConfirmed) {
+            markConfirmed(swap, false);
+        }
+        if (swap->record.state == SwapState::Broadcast) {
+            schedule(options_.pollInterval, TimerWheel::Timer{swap->record.id, false});
+        }
+    }
+
+    // Confirmed -> Settled
+    void SwapEngine::runSettle(const std::shared_ptr<Swap>& swap) {
+        SwapRecord record;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            record = swap->record;
+        }
+        try {
+            if (swap->callbacks.settle) {
+                swap->callbacks.settle(record);
+            }
+        } catch (const std::exception& e) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            refund(swap, std::string("Settlement failed: ") + e.what());
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        swap->record.state = SwapState::Settled;
+        persist(swap->record);
+        finish(swap);
+    }
+
+    // Record a confirmed leg and start settlement once both legs are confirmed
+    void SwapEngine::markConfirmed(const std::shared_ptr<Swap>& swap, bool senderLeg) {
+        (senderLeg ? swap->record.senderConfirmed : swap->record.receiverConfirmed) = true;
+        if (swap->record.state != SwapState::Broadcast) {
+            persist(swap->record);  // Still broadcasting; the transition happens in runBroadcast
+            return;
+        }
+        if (swap->record.senderConfirmed && swap->record.receiverConfirmed) {
+            swap->record.state = SwapState::Confirmed;
+            persist(swap->record);
+            dispatch([this, swap] { runSettle(swap); });
+        } else {
+            persist(swap->record);
+        }
+    }
+
+    // Move a swap to Refunded; nothing was settled, so there are no balances to restore
+    void SwapEngine::refund(const std::shared_ptr<Swap>& swap, const std::string& reason) {
+        if (isTerminal(swap->record.state)) {
+            return;
+        }
+        swap->record.state = SwapState::Refunded;
+        swap->record.failureReason = reason;
+        persist(swap->record);
+        if (swap->callbacks.refund) {
+            SwapRecord record = swap->record;
+            std::function<void(const SwapRecord&)> onRefund = swap->callbacks.refund;
+            dispatch([onRefund, record] { onRefund(record); });
+        }
+        finish(swap);
+    }
+
+    // Resolve the future and forget the swap
+    void SwapEngine::finish(const std::shared_ptr<Swap>& swap) {
+        byTransaction_.erase(swap->record.senderTransactionId);
+        byTransaction_.erase(swap->record.receiverTransactionId);
+        swaps_.erase(swap->record.id);
+        swap->promise.set_value(swap->record.state);
+    }
+
+    // Append the record to the swap journal and sync it, so a transition is durable before the swap moves on. As with
+    // the stream before, a failed write does not stop the swap; recover then resumes from the last record that made it.
+    void SwapEngine::persist(const SwapRecord& record) {
+        if (journalFd_ < 0) {
+            return;
+        }
+        const std::string line = record.toJson().dump() + '\n';
+        const char* data = line.data();
+        size_t length = line.size();
+        while (length > 0) {
+            const ssize_t count = ::write(journalFd_, data, length);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            data += count;
+            length -= static_cast<size_t>(count);
+        }
+        ::fdatasync(journalFd_);
+    }
+
+    // Schedule a timer on the wheel
+    void SwapEngine::schedule(std::chrono::milliseconds delay, TimerWheel::Timer timer) {
+        const uint64_t ticks = static_cast<uint64_t>((delay.count() + options_.tick.count() - 1) / options_.tick.count());
+        wheel_.schedule(ticks, timer);
+    }
+
+    // Run a task on the shared pool while keeping the engine alive
+    void SwapEngine::dispatch(std::function<void()> task) {
+        ++activeTasks_;
+        SPHINXPool::ThreadPool::shared().submit([this, task = std::move(task)] {
+            try {
+                task();
+            } catch (...) {
+                // Transition tasks handle their own failures; never let one escape into the pool
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--activeTasks_ == 0) {
+                tasksDone_.notify_all();
+            }
+        });
+    }
+
+    // Report a confirmed transaction
+    bool SwapEngine::confirmTransaction(const std::string& transactionId) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = byTransaction_.find(transactionId);
+        if (it == byTransaction_.end()) {
+            return false;
+        }
+        const std::shared_ptr<Swap> swap = swaps_.at(it->second);
+        const bool senderLeg = (transactionId == swap->record.senderTransactionId);
+        if (!(senderLeg ? swap->record.senderConfirmed : swap->record.receiverConfirmed)) {
+            markConfirmed(swap, senderLeg);
+        }
+        return true;
+    }
+
+    // Replay the journal and resume the swaps that have not finished
+    void SwapEngine::recover(const std::function<SwapCallbacks(const SwapRecord&)>& makeCallbacks) {
+        if (journalFilename_.empty()) {
+            return;
+        }
+        std::unordered_map<uint64_t, SwapRecord> latest;
+        std::ifstream input(journalFilename_);
+        std::string line;
+        while (std::getline(input, line)) {
+            try {
+                SwapRecord record = SwapRecord::fromJson(nlohmann::json::parse(line));
+                latest[record.id] = std::move(record);
+            } catch (const std::exception&) {
+                break;  // A torn last line from a crash; everything before it is intact
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [id, record] : latest) {
+            nextId_ = std::max(nextId_, id + 1);
+            if (isTerminal(record.state) || swaps_.count(id) > 0) {
+                continue;
+            }
+            SwapCallbacks callbacks = makeCallbacks(record);
+            admit(record, std::move(callbacks));
+            std::shared_ptr<Swap> swap = swaps_[id];
+            if (record.state == SwapState::Created) {
+                refund(swap, "Recovered before broadcast");
+            } else if (record.state == SwapState::Confirmed) {
+                dispatch([this, swap] { runSettle(swap); });
+            } else if (record.deadline <= unixNow()) {
+                refund(swap, "Swap timed out");
+            } else {
+                schedule(std::chrono::seconds(record.deadline - unixNow()), TimerWheel::Timer{id, true});
+                if (swap->callbacks.senderConfirmed || swap->callbacks.receiverConfirmed) {
+                    schedule(options_.pollInterval, TimerWheel::Timer{id, false});
+                }
+            }
+        }
+    }
+
+    // Get a copy of an in-flight swap
+    std::unique_ptr<SwapRecord> SwapEngine::find(uint64_t swapId) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = swaps_.find(swapId);
+        return it == swaps_.end() ? nullptr : std::make_unique<SwapRecord>(it->second->record);
+    }
+
+    // Get the number of in-flight swaps
+    size_t SwapEngine::inFlight() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return swaps_.size();
+    }
+
+    // Timer thread: advance the wheel one tick at a time and act on expired timers
+    void SwapEngine::timerLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto next = std::chrono::steady_clock::now() + options_.tick;
+        while (!stopping_) {
+            stopSignal_.wait_until(lock, next, [this] { return stopping_; });
+            if (stopping_) {
+                break;
+            }
+            next += options_.tick;
+            for (const TimerWheel::Timer& timer : wheel_.advance()) {
+                auto it = swaps_.find(timer.swapId);
+                if (it == swaps_.end()) {
+                    continue;  // Finished already
+                }
+                std::shared_ptr<Swap> swap = it->second;
+                if (timer.deadline) {
+                    if (swap->record.state == SwapState::Created || swap->record.state == SwapState::Broadcast) {
+                        refund(swap, "Swap timed out");
+                    }
+                } else if (swap->record.state == SwapState::Broadcast && !swap->polling) {
+                    swap->polling = true;
+                    dispatch([this, swap] { runPoll(swap); });
+                }
+            }
+        }
+    }
+} // namespace SPHINXSwap
@@ -0,0 +1,175 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXATOMICSWAP_HPP
+#define SPHINXATOMICSWAP_HPP
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "json.hpp"
+#include "Ledger.hpp"
+
+namespace SPHINXSwap {
+
+    // Lifecycle of an atomic swap. Settled and Refunded are terminal.
+    enum class SwapState {
+        Created,    // Recorded, legs not broadcast yet
+        Broadcast,  // Both legs broadcast, waiting for confirmations
+        Confirmed,  // Both legs confirmed, settlement running
+        Settled,    // Balances updated, swap complete
+        Refunded    // Timed out or failed, no balance was changed
+    };
+
+    // Name of a state, as stored in the swap journal.
+    const char* toString(SwapState state);
+
+    // Persisted part of a swap.
+    struct SwapRecord {
+        uint64_t id = 0;
+        SwapState state = SwapState::Created;
+        std::string senderAddress;
+        std::string receiverAddress;
+        SPHINXLedger::Amount amount = 0;
+        std::string senderTransactionId;  // Id of the leg on this chain
+        std::string receiverTransactionId;  // Id of the leg on the counterparty chain
+        bool senderConfirmed = false;
+        bool receiverConfirmed = false;
+        int64_t deadline = 0;  // Unix time (seconds) after which an unconfirmed swap is refunded
+        std::string failureReason;
+
+        nlohmann::json toJson() const;
+        static SwapRecord fromJson(const nlohmann::json& swapJson);
+    };
+
+    // Actions the engine runs at each transition. They run on the shared thread pool, never on the caller's thread.
+    struct SwapCallbacks {
+        std::function<void(const SwapRecord&)> broadcast;  // Created -> Broadcast; throwing refunds the swap
+        std::function<bool()> senderConfirmed;  // Optional poll for the sender leg (used when no event arrives)
+        std::function<bool()> receiverConfirmed;  // Optional poll for the receiver leg
+        std::function<void(const SwapRecord&)> settle;  // Confirmed -> Settled; throwing refunds the swap
+        std::function<void(const SwapRecord&)> refund;  // Optional clean-up when the swap is refunded
+    };
+
+    // Timing of the state machine.
+    struct SwapOptions {
+        std::chrono::seconds pollInterval{10};  // How often legs without a confirmation event are polled
+        std::chrono::seconds timeout{3600};  // How long a swap may wait for its confirmations
+        std::chrono::milliseconds tick{250};  // Resolution of the timer wheel
+    };
+
+    // Hashed timer wheel: O(1) schedule and O(1) amortized expiry for any number of swaps.
+    class TimerWheel {
+    public:
+        struct Timer {
+            uint64_t swapId;
+            bool deadline;  // Deadline timer (true) or poll timer (false)
+        };
+
+        explicit TimerWheel(size_t slotCount = 512) : slots_(slotCount) {}
+
+        // Schedule a timer the given number of ticks from now (at least one).
+        void schedule(uint64_t ticks, Timer timer);
+
+        // Advance one tick and return the timers that expired.
+        std::vector<Timer> advance();
+
+    private:
+        struct Entry {
+            uint64_t rounds;  // Full turns of the wheel left before the timer fires
+            Timer timer;
+        };
+
+        std::vector<std::vector<Entry>> slots_;
+        size_t cursor_ = 0;
+    };
+
+    // Drives swaps through Created -> Broadcast -> Confirmed -> Settled (or Refunded) without blocking any caller.
+    // Confirmations arrive as events (confirmTransaction) or from polls scheduled on the timer wheel, one timer thread
+    // serves every in-flight swap, and transition work runs on the shared thread pool. Every transition is appended
+    // to the swap journal, so unfinished swaps can be resumed after a restart.
+    class SwapEngine {
+    public:
+        explicit SwapEngine(const std::string& journalFilename = "", SwapOptions options = {});
+        ~SwapEngine();
+
+        SwapEngine(const SwapEngine&) = delete;
+        SwapEngine& operator=(const SwapEngine&) = delete;
+
+        // Start a swap; the future resolves with Settled or Refunded.
+        std::shared_future<SwapState> start(SwapRecord record, SwapCallbacks callbacks);
+
+        // Report that a transaction was confirmed; returns false if no in-flight swap waits for it.
+        bool confirmTransaction(const std::string& transactionId);
+
+        // Resume the unfinished swaps of the journal. Created swaps are refunded (their broadcast may not have
+        // happened), Broadcast swaps wait for confirmations again and Confirmed swaps settle again, so settle must be idempotent.
+        void recover(const std::function<SwapCallbacks(const SwapRecord&)>& makeCallbacks);
+
+        // Get a snapshot of a swap, or nullptr once it has finished.
+        std::unique_ptr<SwapRecord> find(uint64_t swapId) const;
+
+        // Number of swaps in flight.
+        size_t inFlight() const;
+
+    private:
+        struct Swap {
+            SwapRecord record;
+            SwapCallbacks callbacks;
+            std::promise<SwapState> promise;
+            std::shared_future<SwapState> future;
+            bool polling = false;  // A poll is running on the pool
+        };
+
+        std::shared_future<SwapState> admit(SwapRecord record, SwapCallbacks callbacks);
+        void runBroadcast(const std::shared_ptr<Swap>& swap);
+        void runPoll(const std::shared_ptr<Swap>& swap);
+        void runSettle(const std::shared_ptr<Swap>& swap);
+        void markConfirmed(const std::shared_ptr<Swap>& swap, bool senderLeg);  // Caller holds mutex_
+        void refund(const std::shared_ptr<Swap>& swap, const std::string& reason);  // Caller holds mutex_
+        void finish(const std::shared_ptr<Swap>& swap);  // Caller holds mutex_
+        void persist(const SwapRecord& record);  // Caller holds mutex_; returns once the record is on stable storage
+        void schedule(std::chrono::milliseconds delay, TimerWheel::Timer timer);  // Caller holds mutex_
+        void dispatch(std::function<void()> task);  // Run on the pool; caller holds mutex_
+        void timerLoop();
+
+        SwapOptions options_;
+        std::string journalFilename_;
+        int journalFd_ = -1;  // Append-only, one JSON record per line, the last line of an id wins
+
+        mutable std::mutex mutex_;
+        std::condition_variable stopSignal_;
+        std::condition_variable tasksDone_;  // Signalled when activeTasks_ drops to zero
+        size_t activeTasks_ = 0;  // Pool tasks that still reference the engine
+        std::unordered_map<uint64_t, std::shared_ptr<Swap>> swaps_;  // In-flight swaps
+        std::unordered_map<std::string, uint64_t> byTransaction_;  // Leg transaction id -> swap id
+        TimerWheel wheel_;
+        uint64_t nextId_ = 1;
+        bool stopping_ = false;
+        std::thread timerThread_;
+    };
+} // namespace SPHINXSwap
+
+#endif // SPHINXATOMICSWAP_HPP
@@ -0,0 +1,80 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the hash-to-height index used by the SPHINX chain for O(1) block lookup by hash.
+
+// Keys:
+    // Block hashes are kept as 32-byte binary digests instead of 64-character hex strings.
+    // A digest fits inline in the map node, so the index needs no separate string allocation per block and half the key memory.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <string>
+
+#include "BlockIndex.hpp"
+#include "Hash.hpp"
+
+namespace SPHINXIndex {
+
+    namespace {
+        int hexValue(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        // Decode 64 hex characters, returning false if the string is not a hex digest
+        bool decodeHex(std::string_view hex, BlockDigest& digest) {
+            if (hex.size() != digest.size() * 2) {
+                return false;
+            }
+            for (size_t i = 0; i < digest.size(); ++i) {
+                const int high = hexValue(hex[2 * i]);
+                const int low = hexValue(hex[2 * i + 1]);
+                if (high < 0 || low < 0) {
+                    return false;
+                }
+                digest[i] = static_cast<uint8_t>((high << 4) | low);
+            }
+            return true;
+        }
+    } // namespace
+
+    // Convert a block hash to its fixed-size digest
+    BlockDigest toDigest(std::string_view blockHash) {
+        BlockDigest digest{};
+        if (!decodeHex(blockHash, digest)) {
+            decodeHex(SPHINXHash::SPHINX_256(std::string(blockHash)), digest);
+        }
+        return digest;
+    }
+
+    // Record the height of a block
+    void BlockIndex::insert(std::string_view blockHash, uint32_t height) {
+        heights_.emplace(toDigest(blockHash), height);
+    }
+
+    // Look up the height of a block by its hash
+    uint32_t BlockIndex::find(std::string_view blockHash) const {
+        auto it = heights_.find(toDigest(blockHash));
+        return it == heights_.end() ? NOT_FOUND : it->second;
+    }
+
+    // Remove a block from the index
+    void BlockIndex::erase(std::string_view blockHash) {
+        heights_.erase(toDigest(blockHash));
+    }
+} // namespace SPHINXIndex
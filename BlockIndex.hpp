@@ -0,0 +1,69 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXBLOCKINDEX_HPP
+#define SPHINXBLOCKINDEX_HPP
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+
+namespace SPHINXIndex {
+
+    // Fixed-size binary form of a 256-bit block hash.
+    using BlockDigest = std::array<uint8_t, 32>;
+
+    // Hasher for digests: the bytes are already uniformly distributed, so the first word is a good bucket key.
+    struct BlockDigestHasher {
+        size_t operator()(const BlockDigest& digest) const noexcept {
+            size_t value;
+            std::memcpy(&value, digest.data(), sizeof(value));
+            return value;
+        }
+    };
+
+    // Convert a block hash to its binary digest. 64-character hex hashes are decoded directly;
+    // any other string is hashed with SPHINX_256 first so every key has the same fixed size.
+    BlockDigest toDigest(std::string_view blockHash);
+
+    // Hash-to-height index of the blocks of a chain.
+    class BlockIndex {
+    public:
+        static constexpr uint32_t NOT_FOUND = std::numeric_limits<uint32_t>::max();
+
+        // Record the height of a block; the first block with a given hash wins.
+        void insert(std::string_view blockHash, uint32_t height);
+
+        // Get the height of the block with the given hash, or NOT_FOUND.
+        uint32_t find(std::string_view blockHash) const;
+
+        // Forget a block, for one that left the chain in a reorg.
+        void erase(std::string_view blockHash);
+
+        void reserve(size_t count) { heights_.reserve(count); }
+        void clear() { heights_.clear(); }
+        size_t size() const { return heights_.size(); }
+
+    private:
+        std::unordered_map<BlockDigest, uint32_t, BlockDigestHasher> heights_;  // Digest -> block height
+    };
+} // namespace SPHINXIndex
+
+#endif // SPHINXBLOCKINDEX_HPP
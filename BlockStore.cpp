@@ -0,0 +1,274 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the binary block file used by the SPHINX chain for persistence.
+
+// File Layout:
+    // The file starts with the 8 magic bytes "SPXBLK01", a u32 metadata length and the chain metadata encoded as CBOR.
+    // It is followed by one record per block. Every record is length-prefixed: u32 body length, u32 CRC-32 of the body, then the body.
+    // The body holds the block hash (u16 length + bytes) followed by the block encoded as CBOR, which is much smaller than indented JSON.
+    // All integers are little-endian.
+
+// BlockStore:
+    // The BlockStore maps the file with mmap and only walks the record headers to build an offset table.
+    // Block hashes are returned as views into the mapping and blocks are decoded only when they are accessed, so opening a large chain costs one pass over the headers and no block decoding.
+
+// BlockWriter:
+    // The BlockWriter writes a complete file to a temporary name and renames it into place once everything is synced.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "BlockStore.hpp"
+
+namespace SPHINXStore {
+
+    namespace {
+        void putU16(std::vector<uint8_t>& out, uint16_t value) {
+            out.push_back(static_cast<uint8_t>(value));
+            out.push_back(static_cast<uint8_t>(value >> 8));
+        }
+
+        void putU32(std::vector<uint8_t>& out, uint32_t value) {
+            for (int shift = 0; shift < 32; shift += 8) {
+                out.push_back(static_cast<uint8_t>(value >> shift));
+            }
+        }
+
+        uint16_t getU16(const uint8_t* in) {
+            return static_cast<uint16_t>(in[0] | (in[1] << 8));
+        }
+
+        uint32_t getU32(const uint8_t* in) {
+            return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+                   (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+        }
+
+        std::array<uint32_t, 256> makeCrcTable() {
+            std::array<uint32_t, 256> table{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t value = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    value = (value & 1) ? (0xEDB88320u ^ (value >> 1)) : (value >> 1);
+                }
+                table[i] = value;
+            }
+            return table;
+        }
+    } // namespace
+
+    // CRC-32 (IEEE polynomial, table driven)
+    uint32_t crc32(const uint8_t* data, size_t length) {
+        static const std::array<uint32_t, 256> table = makeCrcTable();
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < length; ++i) {
+            crc = table[(crc ^ data[i]) & 0xFFu] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    // Encode a block as a length-prefixed, checksummed record
+    std::vector<uint8_t> encodeRecord(const SPHINXBlock::Block& block) {
+        const std::string hash = block.getBlockHash();
+        if (hash.size() > UINT16_MAX) {
+            throw std::runtime_error("Block hash too long for the block file format");
+        }
+        const std::vector<uint8_t> payload = nlohmann::json::to_cbor(block.toJson());
+
+        std::vector<uint8_t> record;
+        record.reserve(RECORD_HEADER_SIZE + 2 + hash.size() + payload.size());
+        putU32(record, 0);  // Body length, patched below
+        putU32(record, 0);  // CRC, patched below
+        putU16(record, static_cast<uint16_t>(hash.size()));
+        record.insert(record.end(), hash.begin(), hash.end());
+        record.insert(record.end(), payload.begin(), payload.end());
+
+        const size_t bodyLength = record.size() - RECORD_HEADER_SIZE;
+        if (bodyLength > UINT32_MAX) {
+            throw std::runtime_error("Block too large for the block file format");
+        }
+        const uint32_t crc = crc32(record.data() + RECORD_HEADER_SIZE, bodyLength);
+        for (int i = 0; i < 4; ++i) {
+            record[i] = static_cast<uint8_t>(bodyLength >> (8 * i));
+            record[4 + i] = static_cast<uint8_t>(crc >> (8 * i));
+        }
+        return record;
+    }
+
+    // Decode a record body into a block
+    SPHINXBlock::Block decodeRecordBody(const uint8_t* body, size_t length) {
+        if (length < 2) {
+            throw std::runtime_error("Corrupt block record");
+        }
+        const size_t hashLength = getU16(body);
+        if (2 + hashLength > length) {
+            throw std::runtime_error("Corrupt block record");
+        }
+        const uint8_t* payload = body + 2 + hashLength;
+        SPHINXBlock::Block block("");
+        block.fromJson(nlohmann::json::from_cbor(payload, body + length));
+        return block;
+    }
+
+    BlockStore::~BlockStore() {
+        if (data_ != nullptr) {
+            ::munmap(const_cast<uint8_t*>(data_), mappedSize_);
+        }
+    }
+
+    // Map the file and build the record offset table
+    std::shared_ptr<BlockStore> BlockStore::open(const std::string& filename) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open block file: " + filename);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Failed to stat block file: " + filename);
+        }
+
+        std::shared_ptr<BlockStore> store(new BlockStore());
+        store->mappedSize_ = static_cast<size_t>(info.st_size);
+        if (store->mappedSize_ < sizeof(FILE_MAGIC) + 4) {
+            ::close(fd);
+            throw std::runtime_error("Not a SPHINX block file: " + filename);
+        }
+        void* mapping = ::mmap(nullptr, store->mappedSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);  // The mapping keeps the file alive
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error("Failed to map block file: " + filename);
+        }
+        store->data_ = static_cast<const uint8_t*>(mapping);
+        ::madvise(mapping, store->mappedSize_, MADV_RANDOM);  // Blocks are decoded on demand, not streamed
+
+        const uint8_t* data = store->data_;
+        if (std::memcmp(data, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+            throw std::runtime_error("Not a SPHINX block file: " + filename);
+        }
+        size_t offset = sizeof(FILE_MAGIC);
+        const size_t metadataLength = getU32(data + offset);
+        offset += 4;
+        if (offset + metadataLength > store->mappedSize_) {
+            throw std::runtime_error("Corrupt block file header: " + filename);
+        }
+        if (metadataLength > 0) {
+            store->metadata_ = nlohmann::json::from_cbor(data + offset, data + offset + metadataLength);
+        }
+        offset += metadataLength;
+
+        // Hop over the length prefixes; no block is decoded here
+        while (offset < store->mappedSize_) {
+            if (offset + RECORD_HEADER_SIZE > store->mappedSize_) {
+                throw std::runtime_error("Truncated block record in " + filename);
+            }
+            const size_t bodyLength = getU32(data + offset);
+            if (offset + RECORD_HEADER_SIZE + bodyLength > store->mappedSize_) {
+                throw std::runtime_error("Truncated block record in " + filename);
+            }
+            // blockHash reads the hash without a checksum check, so its length is bounded here once
+            if (bodyLength < 2 || 2 + static_cast<size_t>(getU16(data + offset + RECORD_HEADER_SIZE)) > bodyLength) {
+                throw std::runtime_error("Corrupt block record in " + filename);
+            }
+            store->offsets_.push_back(offset);
+            offset += RECORD_HEADER_SIZE + bodyLength;
+        }
+        return store;
+    }
+
+    // Locate the body of a record inside the mapping
+    const uint8_t* BlockStore::recordBody(size_t index, size_t& length) const {
+        if (index >= offsets_.size()) {
+            throw std::out_of_range("Block index out of range");
+        }
+        const uint8_t* record = data_ + offsets_[index];
+        length = getU32(record);
+        return record + RECORD_HEADER_SIZE;
+    }
+
+    // Read the hash of a block straight from the mapping
+    std::string_view BlockStore::blockHash(size_t index) const {
+        size_t length = 0;
+        const uint8_t* body = recordBody(index, length);
+        const size_t hashLength = getU16(body);
+        return std::string_view(reinterpret_cast<const char*>(body + 2), hashLength);
+    }
+
+    // Check and decode one block from the mapping
+    SPHINXBlock::Block BlockStore::decodeBlock(size_t index) const {
+        size_t length = 0;
+        const uint8_t* body = recordBody(index, length);
+        if (crc32(body, length) != getU32(data_ + offsets_[index] + 4)) {
+            throw std::runtime_error("Block record checksum mismatch at height " + std::to_string(index));
+        }
+        return decodeRecordBody(body, length);
+    }
+
+    BlockWriter::BlockWriter(const std::string& filename, const nlohmann::json& metadata)
+        : filename_(filename), tempFilename_(filename + ".tmp") {
+        file_ = std::fopen(tempFilename_.c_str(), "wb");
+        if (file_ == nullptr) {
+            throw std::runtime_error("Failed to create block file: " + tempFilename_);
+        }
+        try {
+            const std::vector<uint8_t> encodedMetadata = nlohmann::json::to_cbor(metadata);
+            std::vector<uint8_t> header(FILE_MAGIC, FILE_MAGIC + sizeof(FILE_MAGIC));
+            putU32(header, static_cast<uint32_t>(encodedMetadata.size()));
+            header.insert(header.end(), encodedMetadata.begin(), encodedMetadata.end());
+            if (std::fwrite(header.data(), 1, header.size(), file_) != header.size()) {
+                throw std::runtime_error("Failed to write block file: " + tempFilename_);
+            }
+        } catch (...) {
+            std::fclose(file_);  // The destructor does not run for a throwing constructor
+            std::remove(tempFilename_.c_str());
+            throw;
+        }
+    }
+
+    BlockWriter::~BlockWriter() {
+        if (file_ != nullptr) {
+            std::fclose(file_);  // finish() was never called, leave the real file untouched
+            std::remove(tempFilename_.c_str());
+        }
+    }
+
+    // Append one block record to the file
+    void BlockWriter::append(const SPHINXBlock::Block& block) {
+        const std::vector<uint8_t> record = encodeRecord(block);
+        if (std::fwrite(record.data(), 1, record.size(), file_) != record.size()) {
+            throw std::runtime_error("Failed to write block file: " + tempFilename_);
+        }
+    }
+
+    // Sync the temporary file and rename it over the real one
+    void BlockWriter::finish() {
+        if (std::fflush(file_) != 0 || ::fsync(::fileno(file_)) != 0) {
+            throw std::runtime_error("Failed to sync block file: " + tempFilename_);
+        }
+        std::fclose(file_);
+        file_ = nullptr;
+        if (std::rename(tempFilename_.c_str(), filename_.c_str()) != 0) {
+            throw std::runtime_error("Failed to move block file into place: " + filename_);
+        }
+    }
+} // namespace SPHINXStore
@@ -0,0 +1,117 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXBLOCKSTORE_HPP
+#define SPHINXBLOCKSTORE_HPP
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json.hpp"
+#include "Block.hpp"
+
+namespace SPHINXStore {
+
+    // Magic bytes at the start of every binary block file.
+    constexpr char FILE_MAGIC[8] = {'S', 'P', 'X', 'B', 'L', 'K', '0', '1'};
+
+    // Size of the fixed record header: u32 body length + u32 CRC-32 of the body.
+    constexpr size_t RECORD_HEADER_SIZE = 8;
+
+    // CRC-32 (IEEE) of a byte range, used to detect damaged records.
+    uint32_t crc32(const uint8_t* data, size_t length);
+
+    // Encode a block as one length-prefixed record:
+    //   u32 bodyLength | u32 crc32(body) | body = u16 hashLength | block hash | CBOR block payload
+    std::vector<uint8_t> encodeRecord(const SPHINXBlock::Block& block);
+
+    // Decode the body of a record (as produced by encodeRecord) back into a block.
+    SPHINXBlock::Block decodeRecordBody(const uint8_t* body, size_t length);
+
+    // Read-only access to a sequence of blocks that are not held decoded in memory.
+    class BlockSource {
+    public:
+        virtual ~BlockSource() = default;
+
+        // Number of blocks in the source.
+        virtual size_t size() const = 0;
+
+        // Hash of the block at the given index, without decoding the block.
+        virtual std::string_view blockHash(size_t index) const = 0;
+
+        // Decode the block at the given index.
+        virtual SPHINXBlock::Block decodeBlock(size_t index) const = 0;
+    };
+
+    // Binary block file opened through mmap. Only the record offsets are read on open;
+    // blocks are decoded lazily on access and hashes are read straight from the mapping.
+    class BlockStore : public BlockSource {
+    public:
+        ~BlockStore() override;
+
+        BlockStore(const BlockStore&) = delete;
+        BlockStore& operator=(const BlockStore&) = delete;
+
+        // Map a block file and index its records.
+        static std::shared_ptr<BlockStore> open(const std::string& filename);
+
+        size_t size() const override { return offsets_.size(); }
+        std::string_view blockHash(size_t index) const override;
+        SPHINXBlock::Block decodeBlock(size_t index) const override;
+
+        // Chain metadata stored in the file header (public key etc.).
+        const nlohmann::json& metadata() const { return metadata_; }
+
+    private:
+        BlockStore() = default;
+
+        const uint8_t* recordBody(size_t index, size_t& length) const;
+
+        const uint8_t* data_ = nullptr;  // Start of the mapping
+        size_t mappedSize_ = 0;  // Length of the mapping
+        std::vector<uint64_t> offsets_;  // File offset of every record header
+        nlohmann::json metadata_;  // Decoded header metadata
+    };
+
+    // Sequential writer for block files. Writes go to "<filename>.tmp" and are renamed into place by finish(),
+    // so a crash while saving never leaves a half-written file under the real name.
+    class BlockWriter {
+    public:
+        BlockWriter(const std::string& filename, const nlohmann::json& metadata);
+        ~BlockWriter();
+
+        BlockWriter(const BlockWriter&) = delete;
+        BlockWriter& operator=(const BlockWriter&) = delete;
+
+        // Append one block record.
+        void append(const SPHINXBlock::Block& block);
+
+        // Flush, sync and move the file into place.
+        void finish();
+
+    private:
+        std::string filename_;  // Final file name
+        std::string tempFilename_;  // File being written
+        std::FILE* file_ = nullptr;
+    };
+} // namespace SPHINXStore
+
+#endif // SPHINXBLOCKSTORE_HPP
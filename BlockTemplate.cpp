@@ -0,0 +1,211 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements block assembly: choosing transactions for a block and building it ready to sign.
+
+// Packing:
+    // Candidates are grouped by sender and sorted by nonce; each sender's run stops at its first nonce gap, since the later transactions could not be mined.
+    // A max-heap holds the next transaction of every sender, ordered by fee per encoded byte (compared with SPHINXTxPool::compareFeeRates). The best one goes in if it fits; otherwise its sender is done for this block and smaller transactions of other senders still fill the space.
+
+// Merkle root:
+    // The accumulator keeps at most one subtree root per level. Appending a leaf merges equal-sized subtrees like a carry, so packing hashes as it goes and the final root only folds the remaining levels, smallest first.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <algorithm>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "BlockTemplate.hpp"
+#include "Hash.hpp"
+#include "json.hpp"
+
+namespace SPHINXTemplate {
+
+    namespace {
+        using Digest = SPHINXIndex::BlockDigest;
+
+        Digest leafHash(const Digest& id) {
+            std::string data(1, '\x00');
+            data.append(reinterpret_cast<const char*>(id.data()), id.size());
+            return SPHINXIndex::toDigest(SPHINXHash::SPHINX_256(data));
+        }
+
+        Digest innerHash(const Digest& left, const Digest& right) {
+            std::string data(1, '\x01');
+            data.append(reinterpret_cast<const char*>(left.data()), left.size());
+            data.append(reinterpret_cast<const char*>(right.data()), right.size());
+            return SPHINXIndex::toDigest(SPHINXHash::SPHINX_256(data));
+        }
+
+        std::string toHex(const Digest& digest) {
+            static constexpr char HEX[] = "0123456789abcdef";
+            std::string hex(digest.size() * 2, '0');
+            for (size_t i = 0; i < digest.size(); ++i) {
+                hex[2 * i] = HEX[digest[i] >> 4];
+                hex[2 * i + 1] = HEX[digest[i] & 0x0f];
+            }
+            return hex;
+        }
+
+        // True when a pays a higher fee per byte than b
+        bool higherRate(const SPHINXTxPool::PoolEntry& a, const SPHINXTxPool::PoolEntry& b) {
+            return SPHINXTxPool::compareFeeRates(a.fee, a.size, b.fee, b.size) > 0;
+        }
+    } // namespace
+
+    // Merge the new leaf with the pending subtrees of equal size
+    void MerkleAccumulator::append(std::string_view transactionId) {
+        Digest carry = leafHash(SPHINXIndex::toDigest(transactionId));
+        size_t level = 0;
+        for (size_t bits = count_; bits & 1; bits >>= 1, ++level) {
+            carry = innerHash(peaks_[level], carry);
+        }
+        if (level == peaks_.size()) {
+            peaks_.push_back(carry);
+        } else {
+            peaks_[level] = carry;
+        }
+        ++count_;
+    }
+
+    // Fold the pending subtrees, the smallest (rightmost) first
+    std::string MerkleAccumulator::root() const {
+        if (count_ == 0) {
+            return toHex(Digest{});
+        }
+        bool started = false;
+        Digest result{};
+        for (size_t level = 0; level < peaks_.size(); ++level) {
+            if ((count_ >> level) & 1) {
+                result = started ? innerHash(peaks_[level], result) : peaks_[level];
+                started = true;
+            }
+        }
+        return toHex(result);
+    }
+
+    size_t encodedBlockSize(const SPHINXBlock::Block& block) {
+        return nlohmann::json::to_cbor(block.toJson()).size();
+    }
+
+    // Measure the empty block; the transaction array header grows to at most 9 bytes with the count
+    size_t blockOverhead(const std::string& previousHash) {
+        SPHINXBlock::Block block(previousHash);
+        block.setMerkleRoot(MerkleAccumulator().root());
+        return encodedBlockSize(block) + 8 + BLOCK_SIGNATURE_RESERVE;
+    }
+
+    BlockAssembler::BlockAssembler(const std::string& previousHash, size_t maxBytes) : maxBytes_(maxBytes) {
+        result_.block = SPHINXBlock::Block(previousHash);
+    }
+
+    // Append a transaction to the block and the Merkle accumulator
+    bool BlockAssembler::add(const SPHINXTxPool::PoolEntry& entry) {
+        if (entry.size > remaining()) {
+            return false;
+        }
+        result_.block.addTransaction(entry.transaction);
+        merkle_.append(entry.id);
+        result_.transactionIds.push_back(entry.id);
+        result_.bytes += entry.size;
+        result_.fees += entry.fee;
+        return true;
+    }
+
+    // Seal the Merkle root into the block
+    BlockTemplate BlockAssembler::finish() {
+        result_.merkleRoot = merkle_.root();
+        result_.block.setMerkleRoot(result_.merkleRoot);
+        BlockTemplate finished = std::move(result_);
+        result_ = BlockTemplate{};
+        merkle_ = MerkleAccumulator{};
+        return finished;
+    }
+
+    // Greedy fee-density packing over the senders' nonce runs
+    std::vector<size_t> packByFeeRate(std::span<const SPHINXTxPool::PoolEntry> candidates, size_t maxBytes) {
+        // Nonce-ordered run of every sender, cut at the first gap
+        std::unordered_set<SPHINXIndex::BlockDigest, SPHINXIndex::BlockDigestHasher> seen;
+        std::unordered_map<std::string_view, std::vector<size_t>> bySender;
+        seen.reserve(candidates.size());
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (candidates[i].size <= maxBytes && seen.insert(SPHINXIndex::toDigest(candidates[i].id)).second) {
+                bySender[candidates[i].sender].push_back(i);
+            }
+        }
+        std::vector<std::vector<size_t>> runs;
+        runs.reserve(bySender.size());
+        for (auto& [sender, indices] : bySender) {
+            std::stable_sort(indices.begin(), indices.end(), [&](size_t a, size_t b) { return candidates[a].nonce < candidates[b].nonce; });
+            size_t length = 1;
+            while (length < indices.size() && candidates[indices[length]].nonce == candidates[indices[length - 1]].nonce + 1) {
+                ++length;
+            }
+            indices.resize(length);
+            runs.push_back(std::move(indices));
+        }
+
+        // Max-heap of (run, position) by fee rate; equal rates keep the candidates' order
+        struct Head {
+            size_t run;
+            size_t position;
+        };
+        const auto worse = [&](const Head& a, const Head& b) {
+            const size_t left = runs[a.run][a.position];
+            const size_t right = runs[b.run][b.position];
+            if (higherRate(candidates[left], candidates[right]) || higherRate(candidates[right], candidates[left])) {
+                return higherRate(candidates[right], candidates[left]);
+            }
+            return left > right;
+        };
+        std::vector<Head> heads;
+        heads.reserve(runs.size());
+        for (size_t run = 0; run < runs.size(); ++run) {
+            heads.push_back(Head{run, 0});
+        }
+        std::make_heap(heads.begin(), heads.end(), worse);
+
+        std::vector<size_t> packed;
+        size_t remaining = maxBytes;
+        while (!heads.empty() && remaining > 0) {
+            std::pop_heap(heads.begin(), heads.end(), worse);
+            const Head best = heads.back();
+            heads.pop_back();
+            const size_t index = runs[best.run][best.position];
+            if (candidates[index].size > remaining) {
+                continue;  // The rest of this sender's run depends on it
+            }
+            packed.push_back(index);
+            remaining -= candidates[index].size;
+            if (best.position + 1 < runs[best.run].size()) {
+                heads.push_back(Head{best.run, best.position + 1});
+                std::push_heap(heads.begin(), heads.end(), worse);
+            }
+        }
+        return packed;
+    }
+
+    // Pack candidates and assemble the block
+    BlockTemplate buildTemplate(const std::string& previousHash, std::span<const SPHINXTxPool::PoolEntry> candidates, size_t maxBytes) {
+        BlockAssembler assembler(previousHash, maxBytes);
+        for (size_t index : packByFeeRate(candidates, maxBytes)) {
+            assembler.add(candidates[index]);
+        }
+        return assembler.finish();
+    }
+} // namespace SPHINXTemplate
@@ -0,0 +1,102 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXBLOCKTEMPLATE_HPP
+#define SPHINXBLOCKTEMPLATE_HPP
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <span>
+#include <vector>
+
+#include "Block.hpp"
+#include "BlockIndex.hpp"
+#include "Ledger.hpp"
+#include "Mempool.hpp"
+
+namespace SPHINXTemplate {
+
+    // Room kept in every template for the block signature, which is only set once the template is signed.
+    constexpr size_t BLOCK_SIGNATURE_RESERVE = 64 * 1024;
+
+    // Encoded size of a block: its CBOR form, as the block file and the journal store it.
+    size_t encodedBlockSize(const SPHINXBlock::Block& block);
+
+    // Bytes a block on top of previousHash takes besides its transactions: the encoded empty block with a Merkle root
+    // (header, previous hash and root), the largest transaction-array header and BLOCK_SIGNATURE_RESERVE.
+    size_t blockOverhead(const std::string& previousHash);
+
+    // Merkle root over transaction ids that is built leaf by leaf: it keeps one pending subtree root per level (like
+    // the bits of a binary counter), so an append costs O(1) hashes amortized and the root O(log n), with no tree kept.
+    // leaf = SPHINX_256(0x00 | id digest), inner = SPHINX_256(0x01 | left | right). The tree has the RFC 6962 shape: an
+    // odd subtree is carried up as it is instead of being paired with a copy of itself, so two lists never share a root.
+    class MerkleAccumulator {
+    public:
+        // Append the id of the next transaction (SPHINX_256 hex).
+        void append(std::string_view transactionId);
+
+        // Root as 64 hex characters (all zeros with no transactions).
+        std::string root() const;
+
+        size_t size() const { return count_; }
+
+    private:
+        std::vector<SPHINXIndex::BlockDigest> peaks_;  // peaks_[level] is a pending subtree of 2^level leaves when bit level of count_ is set
+        size_t count_ = 0;
+    };
+
+    // A block ready to be signed, with what went into it.
+    struct BlockTemplate {
+        SPHINXBlock::Block block;  // Previous hash, transactions and Merkle root set; not yet signed
+        std::string merkleRoot;
+        std::vector<std::string> transactionIds;  // In block order
+        size_t bytes = 0;  // Encoded size of the transactions
+        SPHINXLedger::Amount fees = 0;
+    };
+
+    // Fills one block: every added transaction goes straight into the block and the Merkle accumulator, so finishing
+    // the block only folds the last O(log n) subtrees.
+    class BlockAssembler {
+    public:
+        BlockAssembler(const std::string& previousHash, size_t maxBytes);
+
+        // Add a transaction if it fits in the remaining space; returns false (and changes nothing) if it does not.
+        bool add(const SPHINXTxPool::PoolEntry& entry);
+
+        size_t remaining() const { return maxBytes_ - result_.bytes; }
+        size_t count() const { return result_.transactionIds.size(); }
+
+        // Set the Merkle root and hand over the block; the assembler is empty afterwards.
+        BlockTemplate finish();
+
+    private:
+        size_t maxBytes_;
+        MerkleAccumulator merkle_;
+        BlockTemplate result_;
+    };
+
+    // Choose transactions from candidates for a block of at most maxBytes: greedy by fee density (fee per encoded
+    // byte), skipping what does not fit and trying smaller ones. A sender's transactions go in nonce order without
+    // gaps, starting from its lowest nonce among the candidates; duplicate ids are ignored. Returns candidate indices
+    // in block order.
+    std::vector<size_t> packByFeeRate(std::span<const SPHINXTxPool::PoolEntry> candidates, size_t maxBytes);
+
+    // Build a block on top of previousHash from candidates, packed by packByFeeRate.
+    BlockTemplate buildTemplate(const std::string& previousHash, std::span<const SPHINXTxPool::PoolEntry> candidates, size_t maxBytes);
+} // namespace SPHINXTemplate
+
+#endif // SPHINXBLOCKTEMPLATE_HPP
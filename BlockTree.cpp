@@ -0,0 +1,273 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the block tree behind fork-aware chains.
+
+// Tree:
+    // Nodes are keyed by the 32-byte binary digest of the block hash and hold the parent digest, height, cumulative work and whether the block is on the best chain; a parent -> child multimap lets whole branches be removed.
+    // The best chain itself still lives in the chain's block list. The tree only adds the branches next to it, so finding the fork point of a branch is a walk down until the first block that is on the best chain.
+    // pruneBelow moves the root up as the chain grows, dropping every branch that forks below it, so memory stays proportional to the reorg window.
+
+// Orphans:
+    // Blocks whose parent is unknown wait in a FIFO-bounded pool indexed by their own hash and by their parent's, so the arrival of a parent releases its children in one lookup.
+
+// Block effects:
+    // The balance change of a block is computed from its transactions and coalesced to one delta per address; applying it with sign -1 undoes the block, which is how reorgs move balances without replaying the chain.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "BlockTree.hpp"
+
+namespace SPHINXTree {
+
+    std::vector<SPHINXLedger::BalanceDelta> BlockEffect::deltas(int sign) const {
+        std::vector<SPHINXLedger::BalanceDelta> result;
+        result.reserve(addresses.size());
+        for (size_t i = 0; i < addresses.size(); ++i) {
+            result.emplace_back(addresses[i], sign < 0 ? -amounts[i] : amounts[i]);
+        }
+        return result;
+    }
+
+    // Sum the transfers of a block per address
+    BlockEffect blockEffect(const SPHINXBlock::Block& block) {
+        std::vector<std::pair<std::string, SPHINXLedger::Amount>> moves;
+        const auto& transactions = block.getTransactions();
+        moves.reserve(transactions.size() * 2);
+        for (size_t i = 0; i < transactions.size(); ++i) {
+            std::string recipientAddress = transactions[i].getRecipientAddress();
+            const double amount = transactions[i].getAmount();
+            if (recipientAddress.empty()) {
+                throw std::invalid_argument("Invalid transfer at index " + std::to_string(i) + ": missing recipient");
+            }
+            if (!(amount > 0.0)) {
+                throw std::invalid_argument("Invalid transfer at index " + std::to_string(i) + ": amount must be positive");
+            }
+            const SPHINXLedger::Amount units = SPHINXLedger::toAmount(amount);
+            std::string senderAddress = transactions[i].getSenderAddress();
+            if (!senderAddress.empty()) {
+                moves.emplace_back(std::move(senderAddress), -units);
+            }
+            moves.emplace_back(std::move(recipientAddress), units);
+        }
+        std::sort(moves.begin(), moves.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        BlockEffect effect;
+        for (auto& [address, amount] : moves) {
+            if (!effect.addresses.empty() && effect.addresses.back() == address) {
+                if (__builtin_add_overflow(effect.amounts.back(), amount, &effect.amounts.back())) {
+                    throw std::overflow_error("Balance overflow for address " + address);
+                }
+            } else {
+                effect.addresses.push_back(std::move(address));
+                effect.amounts.push_back(amount);
+            }
+        }
+        return effect;
+    }
+
+    void BlockTree::reset(const BlockDigest& root, uint32_t height) {
+        nodes_.clear();
+        children_.clear();
+        TreeNode node;
+        node.height = height;
+        node.sequence = nextSequence_++;
+        node.mainChain = true;
+        nodes_.emplace(root, node);
+        best_ = root;
+        rootHeight_ = height;
+    }
+
+    const TreeNode* BlockTree::find(const BlockDigest& hash) const {
+        auto it = nodes_.find(hash);
+        return it == nodes_.end() ? nullptr : &it->second;
+    }
+
+    // Attach a block under its parent with the parent's work plus its own
+    const TreeNode& BlockTree::insert(const BlockDigest& hash, const BlockDigest& parent, uint64_t work) {
+        auto parentNode = nodes_.find(parent);
+        if (parentNode == nodes_.end()) {
+            throw std::runtime_error("Parent block is not in the block tree");
+        }
+        TreeNode node;
+        node.parent = parent;
+        node.height = parentNode->second.height + 1;
+        if (__builtin_add_overflow(parentNode->second.cumulativeWork, work, &node.cumulativeWork)) {
+            node.cumulativeWork = UINT64_MAX;
+        }
+        node.sequence = nextSequence_++;
+        auto [it, inserted] = nodes_.emplace(hash, node);
+        if (inserted) {
+            children_.emplace(parent, hash);
+        }
+        return it->second;
+    }
+
+    // Remove a side branch, breadth first from its lowest block
+    std::vector<BlockDigest> BlockTree::removeBranch(const BlockDigest& hash) {
+        auto node = nodes_.find(hash);
+        if (node == nodes_.end()) {
+            return {};
+        }
+        if (node->second.mainChain) {
+            throw std::runtime_error("Cannot remove a block of the best chain from the block tree");
+        }
+        auto siblings = children_.equal_range(node->second.parent);
+        for (auto it = siblings.first; it != siblings.second; ++it) {
+            if (it->second == hash) {
+                children_.erase(it);
+                break;
+            }
+        }
+
+        std::vector<BlockDigest> removed{hash};
+        for (size_t i = 0; i < removed.size(); ++i) {
+            auto children = children_.equal_range(removed[i]);
+            for (auto it = children.first; it != children.second; ++it) {
+                removed.push_back(it->second);
+            }
+            children_.erase(removed[i]);
+            nodes_.erase(removed[i]);
+        }
+        return removed;
+    }
+
+    void BlockTree::setMainChain(const BlockDigest& hash, bool mainChain) {
+        auto node = nodes_.find(hash);
+        if (node != nodes_.end()) {
+            node->second.mainChain = mainChain;
+        }
+    }
+
+    bool BlockTree::moreWork(const TreeNode& a, const TreeNode& b) {
+        if (a.cumulativeWork != b.cumulativeWork) {
+            return a.cumulativeWork > b.cumulativeWork;
+        }
+        return a.sequence < b.sequence;  // Equal work: the block seen first stays the tip
+    }
+
+    // Collect the branch blocks down to the first one on the best chain
+    ForkPath BlockTree::pathTo(const BlockDigest& hash) const {
+        ForkPath path;
+        BlockDigest current = hash;
+        for (;;) {
+            auto node = nodes_.find(current);
+            if (node == nodes_.end()) {
+                throw std::runtime_error("Branch is not connected to the best chain");
+            }
+            if (node->second.mainChain) {
+                path.forkHeight = node->second.height;
+                break;
+            }
+            path.connect.push_back(current);
+            current = node->second.parent;
+        }
+        std::reverse(path.connect.begin(), path.connect.end());
+        return path;
+    }
+
+    // Move the root up to height, dropping what lies below it and the branches rooted there
+    std::vector<BlockDigest> BlockTree::pruneBelow(uint32_t height) {
+        std::vector<BlockDigest> dropped;
+        if (height <= rootHeight_) {
+            return dropped;
+        }
+        std::vector<BlockDigest> below;
+        for (const auto& [hash, node] : nodes_) {
+            if (node.height < height) {
+                below.push_back(hash);
+            }
+        }
+        for (const BlockDigest& hash : below) {
+            auto children = children_.equal_range(hash);
+            std::vector<BlockDigest> sideChildren;
+            for (auto it = children.first; it != children.second; ++it) {
+                const TreeNode& child = nodes_.at(it->second);
+                if (child.height >= height && !child.mainChain) {
+                    sideChildren.push_back(it->second);
+                }
+            }
+            for (const BlockDigest& child : sideChildren) {
+                std::vector<BlockDigest> branch = removeBranch(child);
+                dropped.insert(dropped.end(), branch.begin(), branch.end());
+            }
+        }
+        for (const BlockDigest& hash : below) {
+            if (!nodes_.at(hash).mainChain) {
+                dropped.push_back(hash);
+            }
+            children_.erase(hash);
+            nodes_.erase(hash);
+        }
+        rootHeight_ = height;
+        return dropped;
+    }
+
+    // Hold an orphan, evicting the oldest ones when the pool is full
+    size_t OrphanPool::add(const SPHINXBlock::Block& block) {
+        const BlockDigest hash = SPHINXIndex::toDigest(block.getBlockHash());
+        if (capacity_ == 0 || contains(hash)) {
+            return 0;
+        }
+        size_t evicted = 0;
+        while (byHash_.size() >= capacity_) {
+            erase(orphans_.begin());
+            ++evicted;
+        }
+        orphans_.push_back(Orphan{block, hash, SPHINXIndex::toDigest(block.getPreviousHash())});
+        auto orphan = std::prev(orphans_.end());
+        byHash_.emplace(hash, orphan);
+        byParent_.emplace(orphan->parent, orphan);
+        return evicted;
+    }
+
+    // Release the orphans waiting for a parent
+    std::vector<SPHINXBlock::Block> OrphanPool::takeChildren(const BlockDigest& parent) {
+        std::vector<std::list<Orphan>::iterator> waiting;
+        auto range = byParent_.equal_range(parent);
+        for (auto it = range.first; it != range.second; ++it) {
+            waiting.push_back(it->second);
+        }
+        std::vector<SPHINXBlock::Block> children;
+        children.reserve(waiting.size());
+        for (auto orphan : waiting) {
+            children.push_back(std::move(orphan->block));
+            erase(orphan);
+        }
+        return children;
+    }
+
+    void OrphanPool::clear() {
+        orphans_.clear();
+        byHash_.clear();
+        byParent_.clear();
+    }
+
+    void OrphanPool::erase(std::list<Orphan>::iterator orphan) {
+        byHash_.erase(orphan->hash);
+        auto range = byParent_.equal_range(orphan->parent);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == orphan) {
+                byParent_.erase(it);
+                break;
+            }
+        }
+        orphans_.erase(orphan);
+    }
+} // namespace SPHINXTree
@@ -0,0 +1,168 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXBLOCKTREE_HPP
+#define SPHINXBLOCKTREE_HPP
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Block.hpp"
+#include "BlockIndex.hpp"
+#include "Ledger.hpp"
+
+namespace SPHINXTree {
+
+    using SPHINXIndex::BlockDigest;
+
+    // Policy of a fork-aware chain.
+    struct ForkOptions {
+        size_t maxReorgDepth = 100;  // Blocks a reorg may disconnect; branches forking deeper below the tip are dropped
+        size_t maxOrphans = 256;  // Blocks kept while their parent is unknown, oldest evicted first
+        std::function<uint64_t(const SPHINXBlock::Block&)> blockWork;  // Work of a block; every block counts 1 when not set
+    };
+
+    // What happened to a block offered to a fork-aware chain.
+    enum class AcceptResult {
+        Connected,  // Extended the best chain
+        SideBranch,  // Stored on a branch with less work than the best chain
+        Reorganized,  // Its branch now has the most work and became the best chain
+        Orphaned,  // Parent unknown; held in the orphan pool until it arrives
+        Duplicate,  // Already known
+        Stale  // Forks off the best chain deeper than maxReorgDepth
+    };
+
+    // Counters of a fork-aware chain.
+    struct ForkStats {
+        size_t treeNodes = 0;  // Blocks in the tree, best chain included
+        size_t sideBlocks = 0;  // Blocks held off the best chain
+        size_t orphans = 0;  // Blocks waiting for their parent
+        uint64_t reorgs = 0;
+        uint64_t blocksDisconnected = 0;  // By all reorgs together
+        uint64_t deepestReorg = 0;  // Most blocks disconnected by one reorg
+        uint64_t orphansEvicted = 0;
+        uint64_t rejected = 0;  // Stale blocks, and branches dropped because a block on them did not apply
+    };
+
+    // Net balance change of a block: every transaction moves its amount from the sender to the recipient (a
+    // transaction without a sender mints). Coalesced to one entry per address, sorted by address.
+    struct BlockEffect {
+        std::vector<std::string> addresses;
+        std::vector<SPHINXLedger::Amount> amounts;
+
+        // Deltas to apply the block (sign 1) or to undo it (sign -1); they point into addresses.
+        std::vector<SPHINXLedger::BalanceDelta> deltas(int sign) const;
+    };
+
+    // Compute the effect of a block; throws std::invalid_argument for a transfer without recipient or with a non-positive amount.
+    BlockEffect blockEffect(const SPHINXBlock::Block& block);
+
+    // A block in the tree.
+    struct TreeNode {
+        BlockDigest parent{};
+        uint32_t height = 0;
+        uint64_t cumulativeWork = 0;  // Work of the branch from the root of the tree up to and including this block
+        uint64_t sequence = 0;  // Arrival order
+        bool mainChain = false;  // On the best chain
+    };
+
+    // Path from the best chain to a block: the height of the last common block and the branch blocks after it, lowest first.
+    struct ForkPath {
+        uint32_t forkHeight = 0;
+        std::vector<BlockDigest> connect;
+    };
+
+    // Index of the recent blocks of a chain as a tree: hash -> parent, height and cumulative work, with the best tip
+    // being the block with the most work (the earlier one on a tie). The tree starts at one block of the chain and is
+    // pruned from below, so it only covers the range in which reorgs are possible.
+    class BlockTree {
+    public:
+        // Start over with a single block, on the best chain.
+        void reset(const BlockDigest& root, uint32_t height);
+
+        const TreeNode* find(const BlockDigest& hash) const;
+        bool contains(const BlockDigest& hash) const { return nodes_.count(hash) > 0; }
+
+        // Add a block whose parent is in the tree (throws std::runtime_error otherwise), off the best chain.
+        const TreeNode& insert(const BlockDigest& hash, const BlockDigest& parent, uint64_t work);
+
+        // Remove a block and every block descending from it; returns the removed hashes. The block may not be on the best chain.
+        std::vector<BlockDigest> removeBranch(const BlockDigest& hash);
+
+        // Mark a block as on or off the best chain.
+        void setMainChain(const BlockDigest& hash, bool mainChain);
+
+        const BlockDigest& bestTip() const { return best_; }
+        void setBestTip(const BlockDigest& hash) { best_ = hash; }
+
+        // True when a would be a better tip than b.
+        static bool moreWork(const TreeNode& a, const TreeNode& b);
+
+        // Walk from a block down to the best chain.
+        ForkPath pathTo(const BlockDigest& hash) const;
+
+        // Drop every block below height, and the branches that fork below it; returns the dropped hashes that were off the best chain.
+        std::vector<BlockDigest> pruneBelow(uint32_t height);
+
+        uint32_t rootHeight() const { return rootHeight_; }
+        size_t size() const { return nodes_.size(); }
+
+    private:
+        std::unordered_map<BlockDigest, TreeNode, SPHINXIndex::BlockDigestHasher> nodes_;
+        std::unordered_multimap<BlockDigest, BlockDigest, SPHINXIndex::BlockDigestHasher> children_;  // Parent -> child
+        BlockDigest best_{};
+        uint32_t rootHeight_ = 0;
+        uint64_t nextSequence_ = 0;
+    };
+
+    // Bounded pool of blocks whose parent has not arrived yet, indexed by hash and by parent.
+    class OrphanPool {
+    public:
+        explicit OrphanPool(size_t capacity) : capacity_(capacity) {}
+
+        // Hold a block; returns the number of older orphans evicted to make room (nothing is added with capacity 0).
+        size_t add(const SPHINXBlock::Block& block);
+
+        bool contains(const BlockDigest& hash) const { return byHash_.count(hash) > 0; }
+
+        // Take out the orphans whose parent is the given block.
+        std::vector<SPHINXBlock::Block> takeChildren(const BlockDigest& parent);
+
+        void clear();
+        size_t size() const { return byHash_.size(); }
+
+    private:
+        struct Orphan {
+            SPHINXBlock::Block block;
+            BlockDigest hash;
+            BlockDigest parent;
+        };
+
+        void erase(std::list<Orphan>::iterator orphan);
+
+        size_t capacity_;
+        std::list<Orphan> orphans_;  // Oldest first
+        std::unordered_map<BlockDigest, std::list<Orphan>::iterator, SPHINXIndex::BlockDigestHasher> byHash_;
+        std::unordered_multimap<BlockDigest, std::list<Orphan>::iterator, SPHINXIndex::BlockDigestHasher> byParent_;
+    };
+} // namespace SPHINXTree
+
+#endif // SPHINXBLOCKTREE_HPP
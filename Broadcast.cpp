@@ -0,0 +1,320 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the asynchronous transaction broadcast pipeline of the chain.
+
+// Queue:
+    // Callers copy the transaction into a bounded MPSC ring (MpscQueue.hpp) and return; no lock is taken unless the sender is asleep or the queue is full.
+    // A full queue either makes the caller wait for the sender to free a cell or, with blockWhenFull off, throws; both are counted in the metrics.
+
+// Batching:
+    // The sender thread takes the first queued transaction, then keeps adding transactions until the batch reaches maxBatchTransactions or maxBatchBytes, or the window since the first one has passed.
+    // Transactions are encoded as CBOR records on the sender thread, so neither JSON text nor any encoding cost reaches the caller.
+    // A batch starts with a magic and a version byte, so the receiving end of the bridge tells it from a single JSON transaction and a future format from this one.
+
+// Failures:
+    // A batch the sink throws on is sent again after a backoff that doubles each time, up to maxSendAttempts. A batch that fails every attempt is counted and handed to onFailure. A stopping broadcaster does not wait out the backoff.
+
+// Wake-ups:
+    // The sender announces that it is going to sleep before it checks the queue a last time, and producers check that flag after publishing (with a full fence on both sides), so a wake-up is never lost and producers skip the mutex while the sender is busy.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "Broadcast.hpp"
+#include "BlockStore.hpp"
+#include "json.hpp"
+
+namespace SPHINXBroadcast {
+
+    namespace {
+        void putU32(uint8_t* out, uint32_t value) {
+            for (int i = 0; i < 4; ++i) {
+                out[i] = static_cast<uint8_t>(value >> (8 * i));
+            }
+        }
+
+        uint32_t getU32(const uint8_t* in) {
+            return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+                   (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+        }
+
+        // Append one length-prefixed CBOR record to a batch
+        void appendTransaction(std::vector<uint8_t>& batch, const SPHINXTrx::Transaction& transaction) {
+            const size_t start = batch.size();
+            batch.resize(start + 4);
+            nlohmann::json::to_cbor(transaction.toJson(), batch);  // Appends straight into the batch buffer
+            putU32(batch.data() + start, static_cast<uint32_t>(batch.size() - start - 4));
+        }
+
+        constexpr size_t HEADER_SIZE = sizeof(BATCH_MAGIC) + 1 + 4;  // Magic, version, count
+        constexpr size_t COUNT_OFFSET = sizeof(BATCH_MAGIC) + 1;
+    } // namespace
+
+    bool isBatch(std::span<const uint8_t> payload) {
+        return payload.size() >= sizeof(BATCH_MAGIC) && std::memcmp(payload.data(), BATCH_MAGIC, sizeof(BATCH_MAGIC)) == 0;
+    }
+
+    // Decode a batch after checking its version, its checksum and every record bound
+    std::vector<SPHINXTrx::Transaction> decodeBatch(std::span<const uint8_t> batch) {
+        if (batch.size() < HEADER_SIZE + 4 || !isBatch(batch)) {
+            throw std::runtime_error("Not a broadcast batch");
+        }
+        if (batch[sizeof(BATCH_MAGIC)] != BATCH_VERSION) {
+            throw std::runtime_error("Unsupported broadcast batch version " + std::to_string(batch[sizeof(BATCH_MAGIC)]));
+        }
+        const size_t end = batch.size() - 4;
+        if (SPHINXStore::crc32(batch.data(), end) != getU32(batch.data() + end)) {
+            throw std::runtime_error("Broadcast batch checksum mismatch");
+        }
+
+        const uint32_t count = getU32(batch.data() + COUNT_OFFSET);
+        std::vector<SPHINXTrx::Transaction> transactions;
+        transactions.reserve(std::min<size_t>(count, end / 4));
+        size_t offset = HEADER_SIZE;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (end - offset < 4 || end - offset - 4 < getU32(batch.data() + offset)) {
+                throw std::runtime_error("Broadcast batch record out of bounds");
+            }
+            const size_t length = getU32(batch.data() + offset);
+            const uint8_t* record = batch.data() + offset + 4;
+            SPHINXTrx::Transaction transaction;
+            transaction.fromJson(nlohmann::json::from_cbor(record, record + length));
+            transactions.push_back(std::move(transaction));
+            offset += 4 + length;
+        }
+        if (offset != end) {
+            throw std::runtime_error("Broadcast batch has trailing bytes");
+        }
+        return transactions;
+    }
+
+    Broadcaster::Broadcaster(BatchSink sink, BroadcastOptions options)
+        : sink_(std::move(sink)), options_(options), queue_(std::max<size_t>(options.queueCapacity, 2)) {
+        options_.maxBatchTransactions = std::max<size_t>(options_.maxBatchTransactions, 1);
+        sender_ = std::thread(&Broadcaster::run, this);
+    }
+
+    Broadcaster::~Broadcaster() {
+        stopping_.store(true);
+        {
+            std::lock_guard<std::mutex> lock(workMutex_);
+            workAvailable_.notify_one();
+        }
+        {
+            std::lock_guard<std::mutex> lock(spaceMutex_);
+            spaceAvailable_.notify_all();
+        }
+        sender_.join();  // The sender drains the queue before it returns
+    }
+
+    // Queue a transaction, waiting for room or throwing when the queue is full
+    void Broadcaster::broadcast(const SPHINXTrx::Transaction& transaction) {
+        if (stopping_.load(std::memory_order_relaxed)) {
+            throw std::runtime_error("Broadcaster is stopped");
+        }
+        if (!queue_.tryPush(transaction)) {
+            if (!options_.blockWhenFull) {
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                throw std::runtime_error("Broadcast queue is full");
+            }
+            fullWaits_.fetch_add(1, std::memory_order_relaxed);
+            std::unique_lock<std::mutex> lock(spaceMutex_);
+            spaceWaiters_.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);  // Count as a waiter before the next look at the queue
+            bool pushed = false;
+            spaceAvailable_.wait(lock, [&] { return (pushed = queue_.tryPush(transaction)) || stopping_.load(); });
+            spaceWaiters_.fetch_sub(1);
+            if (!pushed) {
+                throw std::runtime_error("Broadcaster is stopped");
+            }
+        }
+
+        const uint64_t dequeued = dequeued_.load(std::memory_order_relaxed);
+        const uint64_t pushed = queue_.pushedCount();
+        const size_t depth = pushed > dequeued ? std::min<size_t>(pushed - dequeued, queue_.capacity()) : 0;  // Counters are read apart
+        size_t deepest = maxQueueDepth_.load(std::memory_order_relaxed);
+        while (depth > deepest && !maxQueueDepth_.compare_exchange_weak(deepest, depth, std::memory_order_relaxed)) {
+        }
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);  // Publish the cell before looking at the sleep flag
+        if (senderSleeping_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(workMutex_);
+            workAvailable_.notify_one();
+        }
+    }
+
+    // Wait for the sender to hand every transaction queued so far to the sink
+    void Broadcaster::flush() {
+        const uint64_t target = queue_.pushedCount();
+        std::unique_lock<std::mutex> lock(flushMutex_);
+        batchSent_.wait(lock, [&] {
+            return sent_.load() + failed_.load() >= target;
+        });
+    }
+
+    BroadcastMetrics Broadcaster::metrics() const {
+        BroadcastMetrics result;
+        result.enqueued = queue_.pushedCount();
+        result.sent = sent_.load(std::memory_order_relaxed);
+        result.failed = failed_.load(std::memory_order_relaxed);
+        result.retries = retries_.load(std::memory_order_relaxed);
+        result.batches = batches_.load(std::memory_order_relaxed);
+        result.bytesSent = bytesSent_.load(std::memory_order_relaxed);
+        result.rejected = rejected_.load(std::memory_order_relaxed);
+        result.fullWaits = fullWaits_.load(std::memory_order_relaxed);
+        const uint64_t dequeued = dequeued_.load(std::memory_order_relaxed);
+        result.queueDepth = result.enqueued > dequeued ? static_cast<size_t>(result.enqueued - dequeued) : 0;
+        result.maxQueueDepth = maxQueueDepth_.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    // Sender loop: cut batches by count, size and window until stopped and drained
+    void Broadcaster::run() {
+        std::vector<uint8_t> batch;
+        for (;;) {
+            std::optional<SPHINXTrx::Transaction> next = queue_.tryPop();
+            if (!next) {
+                if (stopping_.load() && queue_.empty()) {
+                    return;
+                }
+                waitForWork(std::chrono::steady_clock::time_point::max());
+                continue;
+            }
+
+            const auto deadline = std::chrono::steady_clock::now() + options_.window;
+            batch.assign(BATCH_MAGIC, BATCH_MAGIC + sizeof(BATCH_MAGIC));
+            batch.push_back(BATCH_VERSION);
+            batch.resize(HEADER_SIZE, 0);  // Count, patched in by send
+            size_t count = 0;
+            for (;;) {
+                dequeued_.fetch_add(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);  // Free the cell before looking for waiters
+                if (spaceWaiters_.load(std::memory_order_relaxed) > 0) {
+                    std::lock_guard<std::mutex> lock(spaceMutex_);
+                    spaceAvailable_.notify_all();
+                }
+                appendTransaction(batch, *next);
+                ++count;
+                if (count >= options_.maxBatchTransactions || batch.size() >= options_.maxBatchBytes) {
+                    break;
+                }
+                next = queue_.tryPop();
+                while (!next && !stopping_.load() && waitForWork(deadline)) {
+                    next = queue_.tryPop();  // Keep filling the batch until the window closes
+                }
+                if (!next) {
+                    break;
+                }
+            }
+            send(batch, count);
+        }
+    }
+
+    // Sleep until a transaction is queued, the broadcaster stops or the deadline passes
+    bool Broadcaster::waitForWork(std::chrono::steady_clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(workMutex_);
+        senderSleeping_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);  // Announce the sleep before the last look at the queue
+        const auto ready = [this] { return !queue_.empty() || stopping_.load(); };
+        bool woken = true;
+        if (deadline == std::chrono::steady_clock::time_point::max()) {
+            workAvailable_.wait(lock, ready);
+        } else {
+            woken = workAvailable_.wait_until(lock, deadline, ready);
+        }
+        senderSleeping_.store(false, std::memory_order_relaxed);
+        return woken;
+    }
+
+    // Sleep out a retry backoff, cut short when the broadcaster stops
+    bool Broadcaster::waitToRetry(std::chrono::milliseconds delay) {
+        std::unique_lock<std::mutex> lock(workMutex_);
+        return !workAvailable_.wait_for(lock, delay, [this] { return stopping_.load(); });
+    }
+
+    // Seal a batch and hand it to the sink, retrying with a doubling backoff; a batch that fails every attempt goes to onFailure
+    void Broadcaster::send(std::vector<uint8_t>& batch, size_t count) {
+        putU32(batch.data() + COUNT_OFFSET, static_cast<uint32_t>(count));
+        const uint32_t checksum = SPHINXStore::crc32(batch.data(), batch.size());
+        batch.resize(batch.size() + 4);
+        putU32(batch.data() + batch.size() - 4, checksum);
+        const std::span<const uint8_t> sealed(batch);
+        std::chrono::milliseconds delay = options_.retryBackoff;
+        for (unsigned attempt = 1;; ++attempt) {
+            std::string error;
+            try {
+                sink_(sealed, count);
+                bytesSent_.fetch_add(batch.size(), std::memory_order_relaxed);
+                sent_.fetch_add(count);
+                break;
+            } catch (const std::exception& sinkError) {
+                error = sinkError.what();
+            }
+            if (attempt >= options_.maxSendAttempts || !waitToRetry(delay)) {
+                failed_.fetch_add(count);
+                if (options_.onFailure) {
+                    try {
+                        options_.onFailure(sealed, count, error);
+                    } catch (const std::exception&) {
+                        // The handler's own failure must not stop the sender
+                    }
+                }
+                break;
+            }
+            retries_.fetch_add(1, std::memory_order_relaxed);
+            delay *= 2;
+        }
+        batches_.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(flushMutex_);  // Orders the counters before a flush waiter's check
+        }
+        batchSent_.notify_all();
+    }
+
+    // Sink that decodes into this bridge
+    BatchSink LoopbackBridge::sink() {
+        return [this](std::span<const uint8_t> batch, size_t) {
+            std::vector<SPHINXTrx::Transaction> transactions = decodeBatch(batch);
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (SPHINXTrx::Transaction& transaction : transactions) {
+                transactions_.push_back(std::move(transaction));
+            }
+            ++batches_;
+            arrived_.notify_all();
+        };
+    }
+
+    std::vector<SPHINXTrx::Transaction> LoopbackBridge::received() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return transactions_;
+    }
+
+    size_t LoopbackBridge::batchCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return batches_;
+    }
+
+    bool LoopbackBridge::waitFor(size_t count, std::chrono::milliseconds timeout) const {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return arrived_.wait_for(lock, timeout, [&] { return transactions_.size() >= count; });
+    }
+} // namespace SPHINXBroadcast
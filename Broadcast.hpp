@@ -0,0 +1,167 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXBROADCAST_HPP
+#define SPHINXBROADCAST_HPP
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Transaction.hpp"
+#include "MpscQueue.hpp"
+
+namespace SPHINXBroadcast {
+
+    // Receives a batch the sink still threw on after the last attempt, with the sink's error, on the sender thread.
+    using FailureHandler = std::function<void(std::span<const uint8_t> batch, size_t count, const std::string& error)>;
+
+    // Batching, backpressure and retry policy of a broadcaster.
+    struct BroadcastOptions {
+        size_t queueCapacity = 8192;  // Transactions waiting to be sent (rounded up to a power of two)
+        size_t maxBatchTransactions = 256;  // A batch is sent once it holds this many transactions...
+        size_t maxBatchBytes = 64 * 1024;  // ...or this many encoded bytes...
+        std::chrono::microseconds window{2000};  // ...or once its first transaction has waited this long
+        bool blockWhenFull = true;  // A full queue makes callers wait (backpressure); false makes them throw instead
+        unsigned maxSendAttempts = 4;  // A batch the sink throws on is sent again, up to this many attempts in all...
+        std::chrono::milliseconds retryBackoff{50};  // ...waiting this long before the first retry and twice as long each time after
+        FailureHandler onFailure;  // Gets the batches that failed every attempt; without it they are only counted
+    };
+
+    // Counters of a broadcaster, read with relaxed loads (each value is exact, the set is not one atomic snapshot).
+    struct BroadcastMetrics {
+        uint64_t enqueued = 0;  // Transactions accepted by broadcast
+        uint64_t sent = 0;  // Transactions in batches the sink accepted
+        uint64_t failed = 0;  // Transactions in batches the sink threw on at every attempt (handed to onFailure)
+        uint64_t retries = 0;  // Batches sent again after the sink threw
+        uint64_t batches = 0;  // Batches handed to the sink
+        uint64_t bytesSent = 0;  // Encoded bytes of the accepted batches
+        uint64_t rejected = 0;  // Transactions refused because the queue was full (blockWhenFull off)
+        uint64_t fullWaits = 0;  // Times a caller found the queue full and had to wait
+        size_t queueDepth = 0;  // Transactions waiting right now
+        size_t maxQueueDepth = 0;  // Highest depth seen
+
+        // Mean transactions per batch.
+        double averageBatchSize() const {
+            return batches > 0 ? static_cast<double>(sent + failed) / static_cast<double>(batches) : 0.0;
+        }
+    };
+
+    // Magic bytes and version at the start of every batch. The bridge also carries single transactions as JSON text, which
+    // never starts with these bytes.
+    constexpr char BATCH_MAGIC[4] = {'S', 'P', 'X', 'B'};
+    constexpr uint8_t BATCH_VERSION = 1;
+
+    // Encoded batch:
+    //   magic | u8 version | u32 count | count x (u32 length | CBOR transaction) | u32 crc32(everything before)
+    // True if payload starts with the batch magic, whatever its version.
+    bool isBatch(std::span<const uint8_t> payload);
+
+    // Receiver side of the format: decode a batch; throws std::runtime_error if it is damaged, truncated or of another version.
+    std::vector<SPHINXTrx::Transaction> decodeBatch(std::span<const uint8_t> batch);
+
+    // Transport of encoded batches (the bridge, or a LoopbackBridge in tests). Runs on the sender thread; a throw makes the
+    // broadcaster retry the batch (see BroadcastOptions).
+    using BatchSink = std::function<void(std::span<const uint8_t> batch, size_t count)>;
+
+    // Asynchronous broadcast pipeline. broadcast() only copies the transaction into a bounded lock-free queue; one
+    // sender thread drains the queue, encodes transactions in binary and hands them to the sink in batches cut by
+    // count, size or time window, so callers return in microseconds and the sink sees a few large writes.
+    class Broadcaster {
+    public:
+        explicit Broadcaster(BatchSink sink, BroadcastOptions options = {});
+
+        // Send whatever is still queued, then stop the sender thread.
+        ~Broadcaster();
+
+        Broadcaster(const Broadcaster&) = delete;
+        Broadcaster& operator=(const Broadcaster&) = delete;
+
+        // Queue a transaction for broadcast; safe from any thread. When the queue is full, waits for room, or with
+        // blockWhenFull off throws std::runtime_error.
+        void broadcast(const SPHINXTrx::Transaction& transaction);
+
+        // Wait until every transaction queued before the call has been handed to the sink.
+        void flush();
+
+        BroadcastMetrics metrics() const;
+
+    private:
+        void run();
+        bool waitForWork(std::chrono::steady_clock::time_point deadline);  // False when the deadline passed with nothing queued
+        bool waitToRetry(std::chrono::milliseconds delay);  // False when the broadcaster stopped during the wait
+        void send(std::vector<uint8_t>& batch, size_t count);
+
+        BatchSink sink_;
+        BroadcastOptions options_;
+        MpscQueue<SPHINXTrx::Transaction> queue_;
+
+        std::mutex workMutex_;
+        std::condition_variable workAvailable_;  // The sender sleeps here when the queue is empty
+        std::atomic<bool> senderSleeping_{false};  // Producers only take workMutex_ when this is set
+        std::mutex spaceMutex_;
+        std::condition_variable spaceAvailable_;  // Producers wait here when the queue is full
+        std::atomic<size_t> spaceWaiters_{0};
+        std::mutex flushMutex_;
+        std::condition_variable batchSent_;
+        std::atomic<bool> stopping_{false};
+
+        std::atomic<uint64_t> dequeued_{0};  // Enqueued count comes from the queue itself
+        std::atomic<uint64_t> sent_{0};
+        std::atomic<uint64_t> failed_{0};
+        std::atomic<uint64_t> retries_{0};
+        std::atomic<uint64_t> batches_{0};
+        std::atomic<uint64_t> bytesSent_{0};
+        std::atomic<uint64_t> rejected_{0};
+        std::atomic<uint64_t> fullWaits_{0};
+        std::atomic<size_t> maxQueueDepth_{0};
+
+        std::thread sender_;  // Last member: started once everything above is constructed
+    };
+
+    // In-process stand-in for the bridge: decodes every batch it is given and keeps the transactions, for tests and
+    // single-node runs. Pass sink() to Chain::openBroadcast.
+    class LoopbackBridge {
+    public:
+        // Sink that delivers to this bridge; the bridge must outlive the broadcaster using it.
+        BatchSink sink();
+
+        // Transactions received so far, in broadcast order.
+        std::vector<SPHINXTrx::Transaction> received() const;
+
+        // Number of batches received.
+        size_t batchCount() const;
+
+        // Wait until at least count transactions arrived; false on timeout.
+        bool waitFor(size_t count, std::chrono::milliseconds timeout) const;
+
+    private:
+        mutable std::mutex mutex_;
+        mutable std::condition_variable arrived_;
+        std::vector<SPHINXTrx::Transaction> transactions_;
+        size_t batches_ = 0;
+    };
+} // namespace SPHINXBroadcast
+
+#endif // SPHINXBROADCAST_HPP
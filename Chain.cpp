@@ -41,21 +41,43 @@
 // Block Operations:
     // The addBlock function adds a block to the chain after verifying its validity using the public key.
     // The isChainValid function verifies the integrity and validity of the blockchain by checking the hashes, signatures, and blocks' order.
-    // The getBlockHash function retrieves the hash of a block at a given height.
+    // The validateChain function does the actual work: each block is hashed once and its signature verified on a work-stealing thread pool, then the previous-hash links are checked in a second pass. It reports the first invalid height and the throughput in blocks/sec.
+    // The getBlockHash function retrieves the hash of a block at a given height as a view, without copying the string, as long as Block::getBlockHash returns a reference; if it returns by value, the hash is copied rather than viewed through a temporary (SPHINXView::BlockHash).
+    // The getBlockAt and getGenesisBlock functions return shared pointers to const blocks, which keep the block alive after pruning, rollbacks or cache eviction without copying it, and blocks(from, to) gives a range that can be iterated without copying any block.
+    // The findBlockByHash function returns the height of a block in O(1) through a hash index keyed by 32-byte binary digests; addBlock, transferFromSidechain, fromJson and load keep the index up to date.
+    // The view function gives concurrent readers a consistent, immutable picture of the chain (ChainView.hpp): the block list up to the tip and the balances as of the same commit. addBlock, applyTransfers and the loaders publish a new view through an atomic shared pointer; in-memory blocks live in a segmented list (SegmentedList.hpp), so publishing shares them instead of copying; the ledger is chunked and shared the same way, so a view with new balances copies only the chunks written since the last one. Readers never take a chain lock and never block the writer.
 
 // Transaction and Bridge Operations:
     // The transferFromSidechain function transfers funds from a sidechain to the main chain by adding a block with the specified block hash from the sidechain.
-    // The handleBridgeTransaction function handles a bridge transaction on the chain, validating and adding the transaction to the target chain.
+    // The handleBridgeTransaction function handles a bridge transaction on the chain, validating and adding the transaction to the target chain; a versioned broadcast batch is decoded and taken all-or-nothing.
     // The signTransaction function signs a transaction using the private key.
-    // The broadcastTransaction function broadcasts a transaction via the bridge.
+    // The broadcastTransaction function admits a transaction to the mempool and queues it for a background broadcaster (Broadcast.hpp): callers only copy the transaction into a bounded lock-free MPSC queue, and one sender thread encodes transactions as CBOR and sends them to the bridge in batches cut by count, size or a time window. Batches start with a magic and a version byte, and handleBridgeTransaction on the receiving chain decodes them. A batch the bridge throws on is retried with a doubling backoff and, if every attempt fails, handed to BroadcastOptions::onFailure. A full queue applies backpressure; broadcastMetrics reports queue depth, batches, retries and waits, and openBroadcast swaps the bridge for another sink such as a LoopbackBridge.
+    // The mempool (Mempool.hpp) indexes pending transactions three ways: by the binary digest of their id, by sender in nonce order, and by fee rate in an indexed min-heap. submitTransaction encodes the transaction to CBOR once, which gives both its id (SPHINX_256 over those bytes) and its size, and assigns the default nonce inside the pool's lock so concurrent submissions of a sender cannot share one. It rejects duplicates, nonce conflicts without a sufficient fee bump and senders whose pending spend would exceed their balance in balances_; when the pool is over its count or byte budget, the lowest fee rate is evicted first together with the sender's later nonces. selectForBlock fills the transaction budget of a block greedily by fee rate while keeping each sender's nonces in order, and removeFromMempool and pruneMempool clean up after a block.
+    // The buildBlockTemplate functions assemble the next block (BlockTemplate.hpp) up to MainParams::getMaxBlockSize() minus the block overhead, which is the encoded empty block (header, previous hash, Merkle root) plus room for the signature; addBlock, acceptBlock and transferFromSidechain reject a block whose encoding is larger than the maximum. Transactions come from the mempool, or from a span of candidates packed greedily by fee density with each sender's nonces in order. Transactions go straight into the block, and the Merkle root over their ids is accumulated while packing (one pending subtree per level), so the result is ready to sign without another pass.
     // The handleTransfer function updates balances based on a transfer transaction.
+    // The applyTransfers function applies a whole batch of transfers: it validates the batch first, sorts and coalesces the updates per recipient, and commits all-or-nothing so a bad transfer never leaves a block partially applied. It only credits the recipients, for incoming transfers debited on the sending chain, and publishes one view per batch; handleTransfer is a batch of one and rejects a non-positive amount or an empty recipient.
+    // Every appended block moves balances by its transfers, debiting the senders and crediting the recipients, whether or not the chain is fork-aware; a block that overdraws an address is rejected before anything changes.
     // The updateBalance function updates the balance of an address on the chain.
+    // Balances are kept in a SPHINXLedger::Ledger: 64-bit fixed-point amounts (1e-8 units), interned fixed-width address ids and an open-addressing table, so updates are exact and lookups stay in a few cache lines.
+    // The stateRoot and shardStateRoot functions return a sparse Merkle commitment over the balances (StateTree.hpp), kept up to date in O(log n) per changed balance; proveBalance and proveShardBalance produce compact inclusion proofs that verifyBalanceProof and the proof-based verifyAtomicSwap check without calling into the other chain. That overload takes the sender address from the transaction, and its root must come from a trusted source.
 
 // JSON Serialization:
     // The toJson function converts the chain object to a JSON representation.
-    // The fromJson function populates the chain object from a JSON object.
-    // The save function saves the chain to a file in JSON format.
-    // The load function loads a chain from a JSON file.
+    // The fromJson function populates the chain object from a JSON object. fromJson and fromJsonText replace the blocks, the block source and the balances under the write lock, as load and rollbackTo do, and publish the view once the replacement is complete.
+    // The save function saves the chain to a compact binary block file (length-prefixed CBOR records, see BlockStore.hpp).
+    // The load function opens a binary block file through mmap; blocks are decoded lazily when they are accessed and block hashes are read straight from the mapping.
+    // Every path that replaces the block list (fromJson, fromJsonText, load, loadArchive, a recovered journal) and restoreSnapshot replays the block transfers through rebuildState, so the balances, their state tree and the undo history match the blocks; a file whose transfers overdraw an address is rejected.
+    // The exportJson and writeJson functions stream the chain as JSON to a file, stream or file descriptor one block at a time, without building a DOM of the whole chain; output can be compact and limited to a range of heights (JsonExport.hpp). JSON is kept as an export format only.
+    // The fromJson function decodes blocks in parallel into a vector sized up front. The fromJsonText and importJson functions scan the JSON text for block ranges without building a DOM and decode them in parallel, or lazily on first access (JsonImport.hpp).
+    // The snapshot, saveSnapshot and restoreSnapshot functions capture and restore the chain and shard balances with the tip hash, height and a SPHINX_256 commitment over a canonical encoding (Snapshot.hpp); enableSnapshots writes one every N blocks.
+    // The load function with SyncOptions restores the newest snapshot matching the block file, replays the transfers of the blocks above it and validates only those blocks or the ones above a trusted checkpoint hash; without a usable snapshot it replays the whole file like load, so a cold start costs O(recent blocks) instead of O(history). The commitment stored in a snapshot file is unkeyed and only detects damage, so a snapshot is trusted either through a snapshotCommitment from the same source as the checkpoint or because the snapshot directory is.
+    // A periodic snapshot that fails to write is counted in snapshotStats and does not fail the addBlock that triggered it, since that block is already applied.
+    // The saveArchive and loadArchive functions write and read a compressed block archive (Archive.hpp): blocks are packed into independently compressed frames with a frame index at the end, so getBlockAt on an archived chain decompresses only the frame holding the block.
+    // The enablePruning function keeps only the most recent blocks decoded in memory: older bodies are compressed into a cold scratch file (ColdStore.hpp, Compress.hpp) while their hashes stay in memory, so getBlockHash and getChainLength stay O(1), and getBlockAt pages cold blocks back in through an LRU.
+    // The enableForks function makes the chain fork-aware (BlockTree.hpp): a tree keyed by binary block digests holds the parent, height and cumulative work of the recent blocks, addBlock and acceptBlock connect blocks that extend the best tip, keep competing branches off to the side and reorganize when a branch gets more work, and blocks with an unknown parent wait in a bounded orphan pool. A block moves balances by its transfers; a reorg rolls the balances back to the fork point from the undo records and applies the new branch's deltas, so it costs the accounts touched since the fork, and a branch block that overdraws an address restores the old chain exactly by redoing the undone records. The tree is pruned to the reorg window as the chain grows.
+    // Every balance change saves the previous value of the account into the undo record of the next block (UndoLog.hpp), once per account and block; the shards keep their own records against the same heights. The rollbackTo function removes the blocks above a height and swaps the saved balances back, newest record first, so it costs the accounts changed since then instead of a replay. setUndoDepth bounds the history; snapshots and replaced block lists rebuild it from their replay.
+    // If the counterparty leg of an atomic swap throws, settlement credits the sender's debit back as a delta under the write lock, so a refunded swap leaves no half-applied transfer and keeps the balance changes other writers made meanwhile.
+    // The openJournal function attaches an append-only journal: addBlock and transferFromSidechain append just the new block as a checksummed record, fsyncs are batched (group commit) and a torn tail from a crash is truncated on open. The block is journaled before the balances, the hash index and the block list change, so a failed append leaves the chain as it was.
 
 // Shard Operations:
     // The createShard function creates a new shard in the chain.
@@ -64,6 +86,22 @@
     // The handleShardTransfer function handles a shard transfer transaction on the chain.
     // The handleShardBridgeTransaction function handles a shard bridge transaction on the chain.
     // The performShardAtomicSwap function performs an atomic swap with a shard on the chain.
+    // Every shard has its own lock and the shard directory is behind a shared lock, so operations on different shards run concurrently.
+    // The transferBetweenShards function holds the two shard locks, taken in address order, and no chain-wide lock: it checks the funds and saves the undo records first, then debits and credits; snapshot takes every shard lock in the same order, so it never sees a half-done transfer.
+    // The executeShardBatches function applies per-shard transfer batches on the shared thread pool, one all-or-nothing batch per shard.
+    // The Sharding::shardBlockchain function splits the account state of a chain into shards on a consistent-hash ring (ShardRing.hpp), in parallel, and reports the load skew per shard.
+
+// Atomic Swaps:
+    // performAtomicSwap and performShardAtomicSwap no longer block: they hand the swap to a SPHINXSwap::SwapEngine (AtomicSwap.hpp) and return a future.
+    // The engine moves each swap through Created -> Broadcast -> Confirmed -> Settled or Refunded, driven by onTransactionConfirmed events and timer-wheel polls instead of a sleeping thread per swap.
+    // The openSwapStore function journals every transition so in-flight swaps resume after a restart; a recovered swap is refunded, since the counterparty chain it would credit is gone.
+    // Settlement runs on the swap pool. It debits the sender under the chain's write lock, which every block and balance writer holds, and re-checks the balance there, so concurrent swaps cannot overdraw an address.
+
+// Signing:
+    // Transactions and bridge messages are signed by a SPHINXKeys::KeyManager (KeyManager.hpp) that loads or generates the chain's hybrid keypair once and caches the encoded signing key; no signing path runs keygen any more.
+    // The openKeyStore function keeps the key in a file so the chain signs with the same identity after a restart.
+    // The verifyBridgeSignatures function checks the signatures of many transactions in one call through SPHINXBatch::verifyBatch (SignatureBatch.hpp): each distinct public key is parsed once and the checks run on the thread pool.
+    // Successful verifications are remembered in a bounded LRU (SignatureCache.hpp) keyed by SPHINX_256(message, signature, public key); validateChain and verifyAtomicSwap consult it, so re-validating costs a hash lookup. The bridge handlers do not sign and re-verify the bridge data with the chain's own key: that only proves the chain holds its key, so they rely on the bridge's verifyTransaction.
 
 // This code provides the basic functionality of a blockchain and supports operations such as adding blocks, transferring funds, handling transactions, creating bridges, and managing shards.
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -71,15 +109,29 @@
 
 
 #include <unordered_map>
+#include <list>
+#include <atomic>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <chrono>
 #include <thread>
 #include <ctime>
 #include <stdexcept>
 #include <fstream>
 #include <array>
+#include <future>
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <iterator>
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <utility>
 #include <vector>
 
 #include "Chain.hpp"
@@ -92,6 +144,27 @@
 #include "Transaction.hpp"
 #include "Consensus/Contract.hpp"
 #include "Params.hpp"
+#include "ThreadPool.hpp"
+#include "BlockStore.hpp"
+#include "Journal.hpp"
+#include "ColdStore.hpp"
+#include "Archive.hpp"
+#include "JsonImport.hpp"
+#include "JsonExport.hpp"
+#include "BlockIndex.hpp"
+#include "Ledger.hpp"
+#include "UndoLog.hpp"
+#include "ChainView.hpp"
+#include "Snapshot.hpp"
+#include "AtomicSwap.hpp"
+#include "Broadcast.hpp"
+#include "Mempool.hpp"
+#include "BlockTemplate.hpp"
+#include "BlockTree.hpp"
+#include "ShardRing.hpp"
+#include "KeyManager.hpp"
+#include "SignatureBatch.hpp"
+#include "SignatureCache.hpp"
 
 
 using json = nlohmann::json;
@@ -99,6 +172,30 @@ using json = nlohmann::json;
 // Constant for block not found
 constexpr uint32_t BLOCK_NOT_FOUND = std::numeric_limits<uint32_t>::max();
 
+namespace {
+    // Id of an encoded transaction: SPHINX_256 over its CBOR bytes, so the id and the size come from one encoding
+    std::string transactionId(const std::vector<uint8_t>& encoded) {
+        return SPHINXHash::SPHINX_256(std::string(encoded.begin(), encoded.end()));
+    }
+
+    // Id of a signed transaction, used by the mempool and to match confirmation events to the atomic swap waiting for them
+    std::string transactionId(const SPHINXTrx::Transaction& transaction) {
+        return transactionId(json::to_cbor(transaction.toJson()));
+    }
+
+    // Ring for a shard count, built once and kept for the life of the process; there are only a few shard counts in use
+    const SPHINXShard::HashRing& ringFor(size_t shardCount) {
+        static std::mutex mutex;
+        static std::unordered_map<size_t, std::unique_ptr<const SPHINXShard::HashRing>> rings;
+        std::lock_guard<std::mutex> lock(mutex);
+        std::unique_ptr<const SPHINXShard::HashRing>& ring = rings[shardCount];
+        if (!ring) {
+            ring = std::make_unique<const SPHINXShard::HashRing>(shardCount);
+        }
+        return *ring;
+    }
+} // namespace
+
 // Forward declaration of SPHINXChain::Chain to avoid incomplete type error.
 class SPHINXChain::Chain;
 
@@ -131,36 +228,175 @@ public:
         // Function to add a block to the chain
         void addBlock(const SPHINXBlock::Block& block);
 
-        // Get the hash of a block at a specific block height.
-        std::string getBlockHash(uint32_t blockHeight) const;
+        // Get the hash of a block at a specific block height. It is a view (valid while the block is part of the chain) when
+        // Block::getBlockHash returns a reference, and a copy otherwise (SPHINXView::BlockHash).
+        SPHINXView::BlockHash getBlockHash(uint32_t blockHeight) const;
+
+        // Constant for block not found
+        static constexpr uint32_t BLOCK_NOT_FOUND = SPHINXIndex::BlockIndex::NOT_FOUND;
+
+        // Get the height of the block with the given hash in O(1), or BLOCK_NOT_FOUND.
+        uint32_t findBlockByHash(const std::string& blockHash) const;
 
         // Transfer tokens from the sidechain to the main chain using a block hash.
         void transferFromSidechain(const SPHINXChain::Chain& sidechain, const std::string& blockHash);
 
-        // Handle a bridge transaction for cross-chain communication.
+        // Handle a bridge transaction for cross-chain communication. The payload is one transaction as JSON text, or a batch
+        // sent by a broadcaster (SPHINXBroadcast::isBatch), which is decoded and added only if every transaction in it is valid.
         void handleBridgeTransaction(const std::string& bridge, const std::string& targetChain, const std::string& transaction);
 
         // Convert the chain data to a JSON format.
         nlohmann::json toJson() const;
 
-        // Load chain data from a JSON object.
+        // Load chain data from a JSON object. The block list is replaced under the write lock, then one view is published.
         void fromJson(const nlohmann::json& chainJson);
 
-        // Save chain data to a file with the given filename.
-        bool save(const nlohmann::json& chainJson, const std::string& filename) const;
+        // Load chain data from JSON text without building a DOM for the whole document. Blocks are decoded in parallel
+        // chunks, or with options.lazy kept as undecoded text and decoded on first access. Like fromJson, the block list is
+        // replaced under the write lock; only the scan of the text runs outside it.
+        void fromJsonText(std::string text, SPHINXStore::JsonImportOptions options = {});
+
+        // Import a chain exported with exportJson.
+        static Chain importJson(const std::string& filename, SPHINXStore::JsonImportOptions options = {});
 
-        // Load chain data from a file with the given filename.
+        // Save chain data to a binary block file with the given filename.
+        bool save(const std::string& filename) const;
+
+        // Load chain data from a binary block file with the given filename. Every block is decoded once to replay its
+        // transfers into the balances; after that blocks are decoded lazily.
         static Chain load(const std::string& filename);
 
+        // Save chain data to a compressed block archive: blocks are grouped into independently compressed frames with a
+        // frame index (Archive.hpp), so reading one block later decompresses one frame.
+        bool saveArchive(const std::string& filename, SPHINXStore::ArchiveOptions options = {}) const;
+
+        // Load chain data from a block archive. Every frame is decompressed once to replay the transfers into the balances;
+        // after that blocks are decoded lazily one frame at a time.
+        static Chain loadArchive(const std::string& filename);
+
+        // Export chain data to a JSON file with the given filename. Blocks are written one at a time (no DOM of the whole
+        // chain); options select compact output and a range of heights [from, to).
+        bool exportJson(const std::string& filename, SPHINXStore::JsonExportOptions options = {}) const;
+
+        // Stream chain data as JSON to an output stream; throws std::runtime_error if writing fails.
+        void writeJson(std::ostream& out, SPHINXStore::JsonExportOptions options = {}) const;
+
+        // Stream chain data as JSON to an open file descriptor (file, pipe or socket); the descriptor is not closed.
+        void writeJson(int fd, SPHINXStore::JsonExportOptions options = {}) const;
+
+        // Attach an append-only journal; every block added afterwards is appended to it with a checksum.
+        void openJournal(const std::string& filename, SPHINXStore::JournalOptions options = {});
+
+        // Make every block appended to the journal durable now.
+        void flushJournal();
+
         // Get the genesis block of the chain.
-        SPHINXBlock::Block getGenesisBlock() const;
+        std::shared_ptr<const SPHINXBlock::Block> getGenesisBlock() const;
+
+        // Get the block at the specified index. The block is shared, not copied, and the pointer keeps it alive whatever the
+        // chain does afterwards: pruning, rollbacks and the eviction of cold blocks from the decoded cache.
+        std::shared_ptr<const SPHINXBlock::Block> getBlockAt(size_t index) const;
+
+        // Keep only the most recent options.hotBlocks blocks decoded in memory. Older bodies are compressed into a cold
+        // scratch file (ColdStore.hpp), hashes stay in memory, and getBlockAt pages cold blocks back in through an LRU of
+        // options.cacheBlocks blocks.
+        void enablePruning(SPHINXStore::PruneOptions options);
+
+        // Hold competing branches instead of only appending. addBlock then accepts any block whose parent is known, keeps the
+        // branch with the most work as the chain (reorganizing when another branch overtakes it) and parks blocks with an
+        // unknown parent in a bounded orphan pool. Blocks move balances by their transfers (BlockTree.hpp); a reorg puts back
+        // the balances saved at the fork point (UndoLog.hpp) and applies the new branch's deltas. The tree starts at the current
+        // tip. A journaled chain cannot be fork-aware, because the journal is append-only.
+        void enableForks(SPHINXTree::ForkOptions options = {});
+
+        // Offer a block to a fork-aware chain and report what became of it. Throws std::runtime_error if forks are not
+        // enabled or the block is invalid: a bad signature, or transfers that overdraw a sender when it is connected.
+        SPHINXTree::AcceptResult acceptBlock(const SPHINXBlock::Block& block);
+
+        // Tree, orphan and reorg counters (all zero while forks are disabled).
+        SPHINXTree::ForkStats forkStats() const;
+
+        // Roll the chain back so the block at height is the tip. The later blocks are removed and the chain and shard
+        // balances are put back as they were when that block was added, from per-block undo records (UndoLog.hpp), so the
+        // cost is the accounts changed since then rather than a replay of the chain. Throws std::out_of_range past the tip and
+        // std::runtime_error when the undo records or the in-memory blocks do not reach back that far (see setUndoDepth and
+        // enablePruning) or the chain is journaled, because the journal is append-only.
+        void rollbackTo(uint32_t height);
+
+        // Set how many recent blocks keep undo records (SPHINXLedger::UNDO_DEPTH by default); a fork-aware chain keeps at
+        // least its reorg window.
+        void setUndoDepth(size_t blocks);
+
+        // Forward iterator over the blocks of a chain; dereferencing yields a const reference, never a copy. The iterator
+        // holds the block it points at, so the reference stays valid until the iterator moves on.
+        class BlockIterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = SPHINXBlock::Block;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const SPHINXBlock::Block*;
+            using reference = const SPHINXBlock::Block&;
+
+            BlockIterator() = default;
+            BlockIterator(const Chain* chain, size_t height) : chain_(chain), height_(height) {}
+
+            reference operator*() const { return *held(); }
+            pointer operator->() const { return held().get(); }
+            BlockIterator& operator++() { ++height_; block_.reset(); return *this; }
+            BlockIterator operator++(int) { BlockIterator previous = *this; ++*this; return previous; }
+            bool operator==(const BlockIterator& other) const { return height_ == other.height_; }
+            bool operator!=(const BlockIterator& other) const { return height_ != other.height_; }
+
+            // Height of the block the iterator points at.
+            size_t height() const { return height_; }
+
+        private:
+            const std::shared_ptr<const SPHINXBlock::Block>& held() const {
+                if (!block_) {
+                    block_ = chain_->blockPtr(height_);
+                }
+                return block_;
+            }
+
+            const Chain* chain_ = nullptr;
+            size_t height_ = 0;
+            mutable std::shared_ptr<const SPHINXBlock::Block> block_;  // Block at height_, loaded on first dereference
+        };
+
+        // Half-open range of blocks [from, to) for range-based for loops.
+        class BlockRange {
+        public:
+            BlockRange(const Chain* chain, size_t from, size_t to) : chain_(chain), from_(from), to_(to) {}
+
+            BlockIterator begin() const { return BlockIterator(chain_, from_); }
+            BlockIterator end() const { return BlockIterator(chain_, to_); }
+            size_t size() const { return to_ - from_; }
+            bool empty() const { return from_ == to_; }
 
-        // Get the block at the specified index.
-        SPHINXBlock::Block getBlockAt(size_t index) const;
+        private:
+            const Chain* chain_;
+            size_t from_;
+            size_t to_;
+        };
+
+        // Get the blocks with heights in [from, to) as a range of const references.
+        BlockRange blocks(size_t from, size_t to) const;
+
+        // Get every block of the chain as a range of const references.
+        BlockRange blocks() const;
 
         // Get the length of the chain (number of blocks).
         size_t getChainLength() const;
 
+        // Get the current read view: the blocks up to the tip and the balances as of the last block or transfer batch.
+        // Any thread may call this while one writer adds blocks and applies balances. It takes none of the chain's locks,
+        // and the view stays consistent and valid for as long as the caller holds it, whatever the writer does meanwhile.
+        std::shared_ptr<const SPHINXView::ChainView> view() const;
+
+        // Publish a new read view now. addBlock, applyTransfers, restoreSnapshot and the loaders publish on their own;
+        // updateBalance does not, so call this to make single balance updates visible to readers before the next block.
+        void publishView();
+
         // Visualize the chain, printing its details to the console.
         void visualizeChain() const;
 
@@ -176,14 +412,71 @@ public:
         // Handle a bridge transaction between this chain and the target chain.
         void handleBridgeTransaction(const std::string& bridgeAddress, const std::string& recipientAddress, double amount);
 
-        // Perform an atomic swap between this chain and the target chain.
-        void performAtomicSwap(const Chain& targetChain, const std::string& senderAddress, const std::string& receiverAddress, double amount);
+        // Perform an atomic swap between this chain and the target chain. Returns immediately; the future resolves with
+        // Settled or Refunded. Both chains must stay alive until it is ready.
+        std::shared_future<SPHINXSwap::SwapState> performAtomicSwap(const Chain& targetChain, const std::string& senderAddress, const std::string& receiverAddress, double amount);
+
+        // Persist atomic swaps to a journal and resume the ones that were in flight.
+        void openSwapStore(const std::string& filename);
+
+        // Use the signing key stored in filename, generating and storing one if the file does not exist yet.
+        void openKeyStore(const std::string& filename);
+
+        // Get the key manager that signs for this chain (its counters give signatures/sec).
+        SPHINXKeys::KeyManager& keyManager() { return *keyManager_; }
+
+        // Report a confirmed transaction; returns false if no atomic swap waits for it.
+        bool onTransactionConfirmed(const std::string& transactionId);
 
         // Sign a transaction before broadcasting it.
         void signTransaction(SPHINXTrx::Transaction& transaction);
 
-        // Broadcast a signed transaction to the network.
-        void broadcastTransaction(const SPHINXTrx::Transaction& transaction);
+        // Broadcast a signed transaction to the network. The transaction is admitted to the mempool (see submitTransaction) and
+        // queued for the background broadcaster (Broadcast.hpp), which sends it with others in one binary batch; the call
+        // returns in microseconds. A transaction that is already pending is not sent again; one the mempool rejects throws
+        // std::runtime_error.
+        void broadcastTransaction(const SPHINXTrx::Transaction& transaction, double fee = 0.0, std::optional<uint64_t> nonce = std::nullopt);
+
+        // Admit a transaction to the mempool without broadcasting it. The nonce orders the sender's transactions and defaults
+        // to the one after the sender's last pending transaction, taken atomically with admission; the amounts and fees of a sender's pending transactions may
+        // not exceed its balance.
+        SPHINXTxPool::AddResult submitTransaction(const SPHINXTrx::Transaction& transaction, double fee = 0.0, std::optional<uint64_t> nonce = std::nullopt);
+
+        // Pick pending transactions for the next block by fee rate, each sender's in nonce order, up to maxBytes of encoded
+        // transactions; 0 or anything above the transaction budget of a block means the whole budget (see buildBlockTemplate).
+        std::vector<SPHINXTrx::Transaction> selectForBlock(size_t maxBytes = 0) const;
+
+        // Remove transactions that went into a block from the mempool; returns the number removed.
+        size_t removeFromMempool(std::span<const SPHINXTrx::Transaction> transactions);
+
+        // Evict pending transactions that their senders can no longer pay for after balances went down; returns the number evicted.
+        size_t pruneMempool();
+
+        // Size and admission counters of the mempool.
+        SPHINXTxPool::PoolStats mempoolStats() const;
+
+        // Assemble the next block on top of the tip from the mempool, up to maxBytes of transactions (0 or anything above
+        // the budget means the whole budget). The budget is MainParams::getMaxBlockSize() minus the block overhead: the header,
+        // previous hash and Merkle root, and room for the signature (SPHINXTemplate::blockOverhead). The block carries its transactions and Merkle root and
+        // is ready to be signed and passed to addBlock; the pool is left unchanged until removeFromMempool.
+        SPHINXTemplate::BlockTemplate buildBlockTemplate(size_t maxBytes = 0) const;
+
+        // Assemble the next block from the given candidates instead of the mempool, packed greedily by fee density.
+        SPHINXTemplate::BlockTemplate buildBlockTemplate(std::span<const SPHINXTxPool::PoolEntry> candidates, size_t maxBytes = 0) const;
+
+        // Maximum encoded size of a block, header and signature included, from MainParams. addBlock and acceptBlock reject
+        // larger blocks.
+        size_t getMaxBlockSize() const { return maxBlockSize_; }
+
+        // Send broadcast batches to the given sink instead of the bridge (for example a SPHINXBroadcast::LoopbackBridge) and/or
+        // with other batching options. Call before broadcasting; a previous broadcaster sends what it still holds first.
+        void openBroadcast(SPHINXBroadcast::BatchSink sink, SPHINXBroadcast::BroadcastOptions options = {});
+
+        // Wait until every transaction broadcast so far has been handed to the bridge.
+        void flushBroadcasts();
+
+        // Queue depth, batching and backpressure counters of the broadcaster (all zero before the first broadcast).
+        SPHINXBroadcast::BroadcastMetrics broadcastMetrics() const;
 
         // Update the balance of an address with the specified amount.
         void updateBalance(const std::string& address, double amount);
@@ -194,9 +487,40 @@ public:
         // Verify an atomic swap transaction with the target chain.
         bool verifyAtomicSwap(const SPHINXTrx::Transaction& transaction, const Chain& targetChain) const;
 
-        // Handle a transfer transaction.
+        // Verify an atomic swap against the committed state of a remote chain instead of a local Chain object: the
+        // signature must be valid and the proof must show, under stateRoot, that the transaction's sender holds the amount.
+        // The proof is only as good as the root: stateRoot must come from a trusted source, such as a validated header of
+        // the remote chain, never from the party presenting the proof.
+        bool verifyAtomicSwap(const SPHINXTrx::Transaction& transaction, const std::string& stateRoot, const SPHINXLedger::StateProof& senderProof) const;
+
+        // Root of the sparse Merkle commitment over the chain balances (64 hex characters).
+        std::string stateRoot() const;
+
+        // Proof of the balance of an address against stateRoot(), so another chain can check it without querying this one.
+        SPHINXLedger::StateProof proveBalance(const std::string& address) const;
+
+        // Root of the commitment over the balances of a shard.
+        std::string shardStateRoot(const std::string& shardName) const;
+
+        // Proof of the balance of an address in a shard against shardStateRoot(shardName).
+        SPHINXLedger::StateProof proveShardBalance(const std::string& shardName, const std::string& address) const;
+
+        // Check a balance proof against a state root; returns the proven balance (0 for a proven absent address), or nothing if the proof does not match.
+        static std::optional<double> verifyBalanceProof(const std::string& stateRoot, const std::string& address, const SPHINXLedger::StateProof& proof);
+
+        // Verify the bridge signatures of many transactions in one call: repeated sender keys are parsed once and the
+        // checks run on the thread pool. Returns one entry per transaction, 1 when its signature is valid.
+        std::vector<uint8_t> verifyBridgeSignatures(std::span<const SPHINXTrx::Transaction> transactions) const;
+
+        // Handle a transfer transaction as a batch of one (applyTransfers), which publishes one view. Throws
+        // std::invalid_argument if the amount is not positive or the recipient is empty.
         void handleTransfer(const SPHINXTrx::Transaction& transaction);
 
+        // Apply a batch of transfer transactions all-or-nothing: the batch is validated first, updates are coalesced per recipient,
+        // and either every transfer is applied or none is. Only the recipients are credited; the senders were debited on the
+        // sending chain. Transfers inside blocks move both sides. One view is published per batch, however large.
+        void applyTransfers(std::span<const SPHINXTrx::Transaction> transactions);
+
         // Get the address of the bridge.
         std::string getBridgeAddress() const;
 
@@ -219,7 +543,7 @@ public:
         void handleShardBridgeTransaction(const std::string& shardName, const std::string& bridgeAddress, const std::string& recipientAddress, double amount);
 
         // Perform an atomic swap with a shard.
-        void performShardAtomicSwap(const std::string& shardName, const Chain& targetShard, const std::string& senderAddress, const std::string& receiverAddress, double amount);
+        std::shared_future<SPHINXSwap::SwapState> performShardAtomicSwap(const std::string& shardName, const Chain& targetShard, const std::string& senderAddress, const std::string& receiverAddress, double amount);
 
         // Update the balance of an address in a shard.
         void updateShardBalance(const std::string& shardName, const std::string& address, double amount);
@@ -227,33 +551,275 @@ public:
         // Get the balance of an address in a shard.
         double getShardBalance(const std::string& shardName, const std::string& address) const;
 
+        // Move funds from an address in one shard to an address in another. Only the two shard locks are held, taken in
+        // address order: the funds are checked and the undo records saved first, then the sender is debited and the
+        // recipient credited, so a snapshot never sees one without the other. Nothing of it survives a crash, like the shard balances.
+        void transferBetweenShards(const std::string& fromShard, const std::string& toShard, const std::string& senderAddress, const std::string& recipientAddress, double amount);
+
+        // Transfers to apply to one shard's balances.
+        struct ShardBatch {
+            std::string shardName;
+            std::vector<SPHINXTrx::Transaction> transactions;
+        };
+
+        // Apply shard batches in parallel; batches of different shards never wait on each other. Each batch is applied
+        // all-or-nothing; the result holds one entry per batch, empty on success or the reason the batch was rejected.
+        std::vector<std::string> executeShardBatches(std::span<const ShardBatch> batches);
+
         // Check if the chain is valid.
         bool isChainValid() const;
 
+        // Result of a full-chain validation run.
+        struct ValidationReport {
+            bool valid = true;  // True when every block passed
+            uint32_t firstInvalidHeight = std::numeric_limits<uint32_t>::max();  // BLOCK_NOT_FOUND when the chain is valid
+            size_t blocksChecked = 0;  // Number of validated blocks below the first invalid height
+            double elapsedSeconds = 0.0;  // Wall-clock time of the run
+
+            // Validation throughput in blocks per second.
+            double blocksPerSecond() const {
+                return elapsedSeconds > 0.0 ? static_cast<double>(blocksChecked) / elapsedSeconds : 0.0;
+            }
+        };
+
+        // Validate the chain in parallel and report the first invalid height and the throughput. Blocks below fromHeight
+        // are trusted (a snapshot or checkpoint covers them); the block at fromHeight is linked to the stored hash of its parent.
+        ValidationReport validateChain(size_t fromHeight = 0) const;
+
+        // Capture the account state (chain and shard balances) at the current tip, with its commitment.
+        SPHINXStore::StateSnapshot snapshot() const;
+
+        // Write a snapshot of the current state to a file and return its commitment.
+        std::string saveSnapshot(const std::string& filename) const;
+
+        // Replace the account state with a snapshot; throws std::runtime_error if its tip is not the block of this chain at that height.
+        void restoreSnapshot(const SPHINXStore::StateSnapshot& snapshot);
+
+        // Write a snapshot to options.directory whenever addBlock makes the chain length a multiple of options.interval.
+        // A snapshot that cannot be written does not fail addBlock; it is counted in snapshotStats.
+        void enableSnapshots(SPHINXStore::SnapshotOptions options);
+
+        // Counters of the periodic snapshots, with the latest write error.
+        SPHINXStore::SnapshotStats snapshotStats() const;
+
+        // Options of a fast load.
+        struct SyncOptions {
+            std::string snapshotDirectory;  // Restore the state from the newest snapshot here that matches the block file
+            std::string checkpointHash;  // Trusted block hash; the history below it is not validated again
+            std::string snapshotCommitment;  // Trusted commitment of the snapshot to restore, from the same source as checkpointHash
+        };
+
+        // Load a block file, restore the newest matching snapshot and validate only the blocks above the snapshot tip or the
+        // checkpoint, whichever is higher. Throws std::runtime_error if the checkpoint is not in the file or a block is invalid.
+        // The commitment inside a snapshot file only catches damage: with snapshotCommitment set, only the snapshot with that
+        // commitment is restored (none matching means a full validation); without it, the snapshot directory must be trusted.
+        static Chain load(const std::string& filename, const SyncOptions& options, ValidationReport* report = nullptr);
+
     private:
         // Structure to represent a shard with its chain, bridge address, bridge secret, and balances.
         struct Shard {
         Chain* chain;  // Use a pointer to SPHINXChain::Chain.
         std::string bridgeAddress;
         std::string bridgeSecret;
-        std::unordered_map<std::string, double> balances;
+        SPHINXLedger::Ledger balances;  // Fixed-point balances of addresses in the shard
+        SPHINXLedger::UndoLog undo;  // Shard balances before each block of the chain
+        mutable std::mutex mutex;  // Guards chain, balances and undo; several are only ever held together in address order
     };
 
-    std::vector<Shard> shards_;  // Shards in the chain
-    std::vector<SPHINXBlock::Block> blocks_;  // Blocks in the chain
+    std::vector<std::unique_ptr<Shard>> shards_;  // Shards in the chain, stable addresses so a shard can be used without the directory lock
+    std::unique_ptr<std::shared_mutex> shardsMutex_ = std::make_unique<std::shared_mutex>();  // Guards shards_ and shardIndices_
+    SPHINXView::BlockList blocks_;  // Blocks in the chain; segmented, so read views share them instead of copying
     SPHINXHybridKey::HybridKeypair SPHINXKeyPub; // Public key of the chain
-    static constexpr uint32_t BLOCK_NOT_FOUND = std::numeric_limits<uint32_t>::max();  // Constant for block not found
+    static constexpr size_t VALIDATION_GRAIN = 64;  // Blocks per validation task
+    static constexpr size_t IMPORT_GRAIN = 64;  // Blocks per JSON decoding task
     std::unordered_map<std::string, uint32_t> shardIndices_;  // Indices of shards in the chain
 
-    std::unordered_map<std::string, double> balances_;  // Balances of addresses on the chain
+    SPHINXLedger::Ledger balances_;  // Fixed-point balances of addresses on the chain
+    SPHINXLedger::UndoLog undo_;  // Balances before each block's changes, for rollbackTo and reorgs
     std::string bridgeAddress_;  // Address of the bridge
     std::string bridgeSecret_;  // Secret key for the bridge
     // Target chain for atomic swaps
     SPHINXChain::Chain* targetChain_;  // Use a pointer to SPHINXChain::Chain.
+    std::shared_ptr<const SPHINXStore::BlockSource> blockSource_;  // Blocks [0, blockSource_->size()) live in a block file, blocks_ holds the rest
+    std::unique_ptr<SPHINXStore::BlockJournal> journal_;  // Append-only journal, null when the chain is not journaled
+    SPHINXIndex::BlockIndex blockIndex_;  // Block hash -> height, kept in step with the block list
+    SPHINXStore::SnapshotOptions snapshotOptions_;  // Periodic snapshot policy, disabled while the directory is empty
+    SPHINXStore::SnapshotStats snapshotStats_;  // Written by takePeriodicSnapshot under the write lock
+
+    using ViewSlot = std::atomic<std::shared_ptr<const SPHINXView::ChainView>>;
+    std::unique_ptr<ViewSlot> view_ = std::make_unique<ViewSlot>();  // Current read view, replaced by publishView
+    std::shared_ptr<const SPHINXLedger::Ledger> publishedBalances_;  // Balances of the current view
+    bool balancesChanged_ = true;  // balances_ differ from publishedBalances_
+    uint64_t viewVersion_ = 0;  // Version of the last published view
+    std::unique_ptr<std::recursive_mutex> writeMutex_ = std::make_unique<std::recursive_mutex>();  // Serializes blocks_ and balances_ between the owner and swap settlement on the swap pool
+
+    // Add delta to the balance of an address under the write lock, saving the previous balance for rollbackTo. With
+    // requireFunds, throws instead if the balance would go below zero.
+    void applyDelta(const std::string& address, SPHINXLedger::Amount delta, bool requireFunds);
+
+    // Rebuild blockIndex_ from scratch; block-file hashes are read without decoding the blocks.
+    void rebuildBlockIndex();
+
+    // Append a block that is about to be added to blocks_ to the journal, if there is one.
+    void appendToJournal(const SPHINXBlock::Block& block);
+
+    // Append a verified block to a linear chain. The effect is checked and the block journaled first; the balances, the
+    // hash index and the block list change only once the journal has taken it, so a failed append leaves no trace.
+    void appendBlock(const SPHINXBlock::Block& block);
+
+    // Write a periodic snapshot if snapshots are enabled and the chain length is on the interval. Never throws: the block
+    // is already applied, so a failed write is only recorded in snapshotStats_.
+    void takePeriodicSnapshot();
+
+    // Height of the next block: balance changes are saved in its undo record.
+    uint32_t nextHeight() const { return static_cast<uint32_t>(getChainLength()); }
+
+    // Restart the undo history of the chain and its shards from the current balances.
+    void resetUndo();
+
+    // Recompute the balances from the transfers of the blocks at fromHeight and above, on top of the current balances
+    // (an empty ledger when fromHeight is 0), saving undo records on the way. Every path that replaces the block list
+    // ends here, so the balances, their state tree and the undo history always match the blocks. Throws if a block
+    // overdraws an address.
+    void rebuildState(size_t fromHeight);
+
+    // Open a binary block file and index its blocks without replaying them; the balances are left empty for the
+    // caller to restore or rebuild.
+    static SPHINXChain openBlockFile(const std::string& filename);
+
+    // Number of blocks served by blockSource_.
+    size_t storedBlockCount() const;
+
+    // Get the block at the given height, decoding it into scratch if it is not held in memory.
+    const SPHINXBlock::Block& blockAt(size_t index, SPHINXBlock::Block& scratch) const;
+
+    // Blocks decoded from blockSource_, so repeated reads do not decode again. Callers hold their own pointers, so an
+    // evicted block lives on until they let go. The cache is unbounded unless pruning is enabled; then it is an LRU of
+    // PruneOptions::cacheBlocks blocks.
+    struct DecodedBlocks {
+        std::mutex mutex;
+        size_t capacity = std::numeric_limits<size_t>::max();
+        std::list<size_t> recent;  // Heights of the decoded blocks, most recently used first
+        std::unordered_map<size_t, std::pair<std::shared_ptr<const SPHINXBlock::Block>, std::list<size_t>::iterator>> blocks;  // Height -> block, position in recent
+    };
+    std::unique_ptr<DecodedBlocks> decodedBlocks_;  // Null when there is no block file
+
+    // Replace the block list with a block file (or nothing), dropping blocks_ and the decoded cache.
+    void attachBlockSource(std::shared_ptr<const SPHINXStore::BlockSource> source);
+
+    // With pruning enabled, move the blocks below the hot window from blocks_ to the cold store.
+    void pruneHotBlocks();
+
+    std::shared_ptr<SPHINXStore::ColdBlockStore> coldStore_;  // Cold tier of a pruned chain, null when pruning is off
+    SPHINXStore::PruneOptions pruneOptions_;
+
+    // Fork-aware state: the tree of recent blocks, the blocks held off the best chain and the orphans.
+    struct ForkState {
+        explicit ForkState(SPHINXTree::ForkOptions forkOptions) : options(std::move(forkOptions)), orphans(options.maxOrphans) {}
+
+        SPHINXTree::ForkOptions options;
+        SPHINXTree::BlockTree tree;
+        std::unordered_map<SPHINXIndex::BlockDigest, SPHINXBlock::Block, SPHINXIndex::BlockDigestHasher> sideBlocks;  // Every tree block off the best chain
+        SPHINXTree::OrphanPool orphans;
+        SPHINXTree::ForkStats stats;
+    };
+    std::unique_ptr<ForkState> forks_;  // Null while forks are disabled
+
+    // Start the block tree over at the current tip, dropping side branches and orphans.
+    void resetForkTree();
+
+    // Put a block whose parent is in the tree into the tree, connecting it, or reorganizing to its branch if that has the most work.
+    SPHINXTree::AcceptResult insertIntoTree(const SPHINXBlock::Block& block);
+
+    // Apply the balance effect of a block, saving the previous balances, and append it to the best chain; throws if the
+    // effect overdraws an address.
+    void connectBlock(const SPHINXBlock::Block& block);
+
+    // Compute the balance effect of a block that is about to be appended; throws if it overdraws an address. Every path
+    // that appends a block checks it before changing anything.
+    SPHINXTree::BlockEffect checkBlockEffect(const SPHINXBlock::Block& block) const;
+
+    // Apply a checked block effect, saving the previous balances in the record of the next block.
+    void applyBlockEffect(const SPHINXTree::BlockEffect& effect);
+
+    // Link a block whose balance effect is already applied in as the tip of the best chain.
+    void pushTip(const SPHINXBlock::Block& block);
+
+    // Take the blocks above height off the best chain, tip first, with one copy-on-write truncate so read views keep
+    // them; the caller puts their balances back from the undo records.
+    std::vector<SPHINXBlock::Block> disconnectAbove(uint32_t height);
+
+    // Make the branch ending at tip the best chain; false if it forks too deep. A block of the branch that does not apply
+    // drops the rest of the branch, restores the previous chain and throws.
+    bool reorganizeTo(const SPHINXIndex::BlockDigest& tip);
+
+    // Get a block by height without a range check; stored blocks are decoded once and cached.
+    std::shared_ptr<const SPHINXBlock::Block> blockPtr(size_t index) const;
+
+    // Find a shard by name under the directory lock; throws if it does not exist.
+    Shard& findShard(const std::string& shardName);
+    const Shard& findShard(const std::string& shardName) const;
+
+    // Validate a batch of transfers and coalesce it into one delta per recipient (deltas point into recipients).
+    static void coalesceTransfers(std::span<const SPHINXTrx::Transaction> transactions, std::vector<std::string>& recipients, std::vector<SPHINXLedger::BalanceDelta>& deltas);
+
+    std::shared_ptr<SPHINXKeys::KeyManager> keyManager_ = std::make_shared<SPHINXKeys::KeyManager>();  // Signing key, generated once on first use
+    std::shared_ptr<SPHINXSwap::SwapEngine> swapEngine_;  // Atomic swap state machine, created on first use
+
+    // Get the swap engine, creating an in-memory one if openSwapStore was not called.
+    SPHINXSwap::SwapEngine& swapEngine();
+
+    std::unique_ptr<SPHINXTxPool::TransactionPool> mempool_ = std::make_unique<SPHINXTxPool::TransactionPool>();  // Pending transactions, indexed by id, sender nonce and fee rate
+    size_t maxBlockSize_ = 0;  // MainParams::getMaxBlockSize()
+
+    // Clamp a requested transaction size to what fits in a block on top of the tip, 0 meaning all of it.
+    size_t blockBudget(size_t maxBytes) const;
+
+    // Throw std::runtime_error if the encoded block is larger than maxBlockSize_.
+    void checkBlockSize(const SPHINXBlock::Block& block) const;
+
+    std::unique_ptr<SPHINXBroadcast::Broadcaster> broadcaster_;  // Background transaction broadcaster, created on first use
+    std::unique_ptr<std::once_flag> broadcasterOnce_ = std::make_unique<std::once_flag>();  // Broadcasts may start on several threads
+
+    // Get the broadcaster, creating one that sends to the bridge if openBroadcast was not called.
+    SPHINXBroadcast::Broadcaster& broadcaster();
+
+    public:
+    // Load of one shard after partitioning.
+    struct ShardLoad {
+        size_t accounts = 0;
+        SPHINXLedger::Amount balance = 0;  // Sum of the balances assigned to the shard
+    };
+
+    // Outcome of Sharding::shardBlockchain, used to tune the shard count.
+    struct ShardingReport {
+        std::vector<ShardLoad> shards;
+        double accountSkew = 0.0;  // Largest shard / average shard, by account count (1.0 is perfectly even)
+        double balanceSkew = 0.0;  // Same, by balance
+        double seconds = 0.0;  // Wall time of the partitioning
+    };
+
+    // Sharding class for horizontal partitioning of the blockchain network
+    class Sharding {
+    public:
+        // Split the account state of a chain into shardCount chains. Addresses are assigned through a consistent-hash
+        // ring (ShardRing.hpp), so changing the shard count moves as few accounts as possible; the partitioning runs
+        // in parallel on the shared thread pool. Every shard keeps the block history of the source chain without a copy:
+        // a block file is shared and the blocks in memory share segments, so only the last, partly filled segment is
+        // copied per shard. If report is given it receives the load of every shard and the skew.
+        static std::vector<SPHINXChain> shardBlockchain(const SPHINXChain& chain, size_t shardCount, ShardingReport* report = nullptr);
+
+        // Get the shard an address belongs to when a chain is split into shardCount shards. The ring of each shard count
+        // is built once and reused.
+        static size_t shardForAddress(const std::string& address, size_t shardCount);
+    };
+
+    private:
+    static constexpr size_t PARTITION_GRAIN = 4096;  // Accounts per partitioning task
     };
 
     // Implementation of the Chain constructor
-    SPHINXChain::SPHINXChain(const MainParams& mainParams) {
+    SPHINXChain::SPHINXChain(const MainParams& mainParams) : maxBlockSize_(static_cast<size_t>(std::max(mainParams.getMaxBlockSize(), 0))) {
         std::string genesisMessage = "Welcome to Post-Quantum era, The Beginning of a Secured-Trustless Network will start from here - SPHINX Network";
         SPHINXBlock::Block genesisBlock(SPHINXHash::SPHINX_256(genesisMessage));
         addBlock(genesisBlock);
@@ -261,50 +827,77 @@ public:
 
     // Implementation of the addBlock function
     void SPHINXChain::addBlock(const SPHINXBlock::Block& block) {
-        if (blocks_.empty()) {  // If the chain is empty
-            blocks_.push_back(block);  // Add the block to the chain
-        } else {
-            if (block.verifyBlock(SPHINXPubKey)) {  // Verify the block using the public key
-                blocks_.push_back(block);  // Add the block to the chain
-            } else {
-                throw std::runtime_error("Invalid block! Block verification failed.");  // Throw an error if the block verification fails
-            }
+        std::lock_guard<std::recursive_mutex> writeLock(*writeMutex_);
+        if (forks_) {
+            acceptBlock(block);  // May connect, reorganize, or hold the block off the best chain
+            return;
         }
+        if (getChainLength() > 0) {
+            checkBlockSize(block);  // The genesis block is built here, not received
+        }
+        if (getChainLength() > 0 && !block.verifyBlock(SPHINXPubKey)) {  // Verify every block but the genesis block using the public key
+            throw std::runtime_error("Invalid block! Block verification failed.");  // Throw an error if the block verification fails
+        }
+        appendBlock(block);
+        pruneHotBlocks();
+        publishView();
+        takePeriodicSnapshot();
     }
 
     // Get the hash of the block at the given height
-    std::string Chain::getBlockHash(uint32_t blockHeight) const {
-        if (blockHeight >= blocks_.size()) {  // If the block height is out of range
+    SPHINXView::BlockHash Chain::getBlockHash(uint32_t blockHeight) const {
+        if (blockHeight >= getChainLength()) {  // If the block height is out of range
             throw std::out_of_range("Block height out of range.");  // Throw an out-of-range error
         }
-        return blocks_[blockHeight].getBlockHash();  // Get the hash of the block at the given height
+        if (blockHeight < storedBlockCount()) {
+            return SPHINXView::BlockHash(blockSource_->blockHash(blockHeight));  // Read the hash straight from the block file, no decoding
+        }
+        return blocks_[blockHeight - storedBlockCount()].getBlockHash();  // A view only if the block hands out a reference to its hash
     }
 
     // Transfer a block from a sidechain to the main chain
     void Chain::transferFromSidechain(const Chain& sidechain, const std::string& blockHash) {
-        uint32_t blockHeight = BLOCK_NOT_FOUND;  // Initialize the block height variable
-        for (uint32_t i = 0; i < sidechain.getChainLength(); ++i) {  // Iterate over the blocks in the sidechain
-            if (sidechain.getBlockHash(i) == blockHash) {  // Check if the block hash matches the given block hash
-                blockHeight = i;  // Store the block height
-                break;
-            }
-        }
+        std::lock_guard<std::recursive_mutex> writeLock(*writeMutex_);
+        const uint32_t blockHeight = sidechain.findBlockByHash(blockHash);  // Look the block up in the sidechain's hash index
 
         if (blockHeight == BLOCK_NOT_FOUND) {  // If the block is not found in the main chain
             throw std::runtime_error("Block not found in the main chain.");  // Throw an error
         }
 
-        const SPHINXBlock::Block& block = sidechain.getBlockAt(blockHeight);  // Get the block at the specified height from the sidechain
-        if (block.verifyBlock(SPHINXPubKey)) {  // Verify the block using the public key
-            blocks_.push_back(block);  // Add the block to the chain
+        const std::shared_ptr<const SPHINXBlock::Block> block = sidechain.getBlockAt(blockHeight);  // Get the block at the specified height from the sidechain
+        checkBlockSize(*block);  // The sidechain may allow larger blocks
+        if (block->verifyBlock(SPHINXPubKey)) {  // Verify the block using the public key
+            appendBlock(*block);  // Its transfers move balances on this chain like any other block
         } else {
             throw std::runtime_error("Invalid block! Block verification failed.");  // Throw an error if the block verification fails
         }
+        if (forks_) {
+            resetForkTree();  // The block did not come through the tree, start it over at the new tip
+        }
+        pruneHotBlocks();
+        publishView();
     }
 
     // Handle a bridge transaction
     void Chain::handleBridgeTransaction(const std::string& bridgeAddress, const std::string& targetChain, const std::string& transaction) {
         if (bridgeAddress == "SPHINX") {  // Check if the bridge is "SPHINX"
+            const std::span<const uint8_t> payload(reinterpret_cast<const uint8_t*>(transaction.data()), transaction.size());
+            if (SPHINXBroadcast::isBatch(payload)) {
+                // A batch from a broadcaster (Broadcast.hpp): validate every transaction before adding any
+                std::vector<std::string> transactions;
+                for (const SPHINXTrx::Transaction& decoded : SPHINXBroadcast::decodeBatch(payload)) {
+                    transactions.push_back(decoded.toJson().dump());
+                }
+                for (const std::string& batchTransaction : transactions) {
+                    if (!SPHINXVerify::validateTransaction(batchTransaction)) {
+                        throw std::runtime_error("Invalid transaction! Transaction validation failed.");
+                    }
+                }
+                for (const std::string& batchTransaction : transactions) {
+                    targetChain_.addTransaction(batchTransaction);
+                }
+                return;
+            }
             bool isValid = SPHINXVerify::validateTransaction(transaction);  // Validate the transaction
             if (!isValid) {  // If the transaction is not valid
                 throw std::runtime_error("Invalid transaction! Transaction validation failed.");  // Throw an error
@@ -320,8 +913,9 @@ public:
         nlohmann::json chainJson;
         // Serialize the blocks
         nlohmann::json blocksJson = nlohmann::json::array();
-        for (const SPHINXBlock::Block& block : blocks_) {
-            blocksJson.push_back(block.toJson());
+        SPHINXBlock::Block scratch("");
+        for (size_t i = 0; i < getChainLength(); ++i) {
+            blocksJson.push_back(blockAt(i, scratch).toJson());
         }
         chainJson["blocks"] = blocksJson;
 
@@ -333,69 +927,923 @@ public:
 
     // Load chain data from JSON and populate the chain
     void Chain::fromJson(const nlohmann::json& chainJson) {
-        blocks_.clear();
+        std::lock_guard<std::recursive_mutex> writeLock(*writeMutex_);  // Writers never see a half-replaced block list
+        attachBlockSource(nullptr);  // The JSON document replaces any block file
 
-        // Deserialize the blocks
+        // Deserialize the blocks in parallel chunks, straight into their final slots
         const nlohmann::json& blocksJson = chainJson["blocks"];
-        for (const auto& blockJson : blocksJson) {
-            SPHINXBlock::Block block("");
-            block.fromJson(blockJson);
-            blocks_.push_back(block);
-        }
+        blocks_.assign(blocksJson.size(), SPHINXBlock::Block(""));
+        SPHINXPool::ThreadPool::shared().parallelFor(0, blocksJson.size(), IMPORT_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                blocks_[i].fromJson(blocksJson[i]);
+            }
+        });
 
         // Deserialize the public key
         SPHINXPubKey = SPHINXHybridKey::sphinxKeyFromString(chainJson["SPHINXPubKey"]);
+
+        rebuildBlockIndex();
+        rebuildState(0);
+        pruneHotBlocks();
+        publishView();
     }
 
-    // Save the chain data to a file in JSON format
-    bool Chain::save(const nlohmann::json& chainJson, const std::string& filename) const {
-        std::ofstream outputFile(filename);
-        if (outputFile.is_open()) {
-            outputFile << chainJson.dump(4);  // Write the formatted JSON data to the file
-            outputFile.close();
+    // Load chain data from JSON text
+    void Chain::fromJsonText(std::string text, SPHINXStore::JsonImportOptions options) {
+        const SPHINXStore::JsonChainLayout layout = SPHINXStore::scanChainJson(text);  // Read-only, outside the lock
+
+        std::lock_guard<std::recursive_mutex> writeLock(*writeMutex_);  // Writers never see a half-replaced block list
+        if (layout.publicKey.second > layout.publicKey.first) {
+            const std::string_view keyText = std::string_view(text).substr(layout.publicKey.first, layout.publicKey.second - layout.publicKey.first);
+            SPHINXPubKey = SPHINXHybridKey::sphinxKeyFromString(nlohmann::json::parse(keyText.begin(), keyText.end()).get<std::string>());
+        }
+
+        if (options.lazy) {
+            // Blocks stay as text in the source and go through the decoded-block cache on first access
+            attachBlockSource(SPHINXStore::JsonBlockSource::create(std::move(text), layout.blocks, options.grain));
+        } else {
+            attachBlockSource(nullptr);
+            blocks_.assign(layout.blocks.size(), SPHINXBlock::Block(""));  // One allocation, no regrowth
+            const std::string_view document(text);
+            SPHINXPool::ThreadPool::shared().parallelFor(0, layout.blocks.size(), options.grain, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    const SPHINXStore::JsonRange& range = layout.blocks[i];
+                    blocks_[i] = SPHINXStore::decodeJsonBlock(document.substr(range.first, range.second - range.first));
+                }
+            });
+        }
+        rebuildBlockIndex();
+        rebuildState(0);
+        pruneHotBlocks();
+        publishView();
+    }
+
+    // Import a chain from a JSON export
+    SPHINXChain Chain::importJson(const std::string& filename, SPHINXStore::JsonImportOptions options) {
+        std::ifstream input(filename, std::ios::binary);
+        if (!input.is_open()) {
+            throw std::runtime_error("Failed to open JSON chain file: " + filename);
+        }
+        std::string text((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        Chain importedChain{MainParams()};
+        importedChain.fromJsonText(std::move(text), options);
+        return importedChain;
+    }
+
+    // Save the chain data to a binary block file, one length-prefixed record per block
+    bool Chain::save(const std::string& filename) const {
+        try {
+            nlohmann::json metadata;
+            metadata["SPHINXPubKey"] = SPHINXHybridKey::sphinxKeyToString(SPHINXPubKey);
+            SPHINXStore::BlockWriter writer(filename, metadata);
+            SPHINXBlock::Block scratch("");
+            for (size_t i = 0; i < getChainLength(); ++i) {
+                writer.append(blockAt(i, scratch));  // Blocks are encoded one at a time, the chain is never held as one document
+            }
+            writer.finish();
             return true;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    // Open a binary block file; only the record offsets are read, blocks are decoded on access
+    SPHINXChain Chain::openBlockFile(const std::string& filename) {
+        std::shared_ptr<SPHINXStore::BlockStore> store = SPHINXStore::BlockStore::open(filename);
+        Chain loadedChain{MainParams()};
+        loadedChain.attachBlockSource(store);  // Drops the freshly created genesis block, the file has its own
+        if (store->metadata().contains("SPHINXPubKey")) {
+            loadedChain.SPHINXPubKey = SPHINXHybridKey::sphinxKeyFromString(store->metadata()["SPHINXPubKey"]);
         }
-        return false;
+        loadedChain.rebuildBlockIndex();
+        return loadedChain;
     }
 
-    // Load chain data from a JSON file and return the loaded chain
+    // Load chain data from a binary block file and replay its transfers
     SPHINXChain Chain::load(const std::string& filename) {
-        std::ifstream inputFile(filename);
-        if (inputFile.is_open()) {
-            nlohmann::json chainJson;
-            inputFile >> chainJson;  // Read the JSON data from the file
-            inputFile.close();
-            Chain loadedChain;
-            loadedChain.fromJson(chainJson);  // Deserialize the JSON data into a Chain object
-            return loadedChain;
+        Chain loadedChain = openBlockFile(filename);
+        loadedChain.rebuildState(0);  // Every block is decoded once to replay its transfers
+        loadedChain.publishView();
+        return loadedChain;
+    }
+
+    // Save the chain data to a compressed block archive, one frame of blocks at a time
+    bool Chain::saveArchive(const std::string& filename, SPHINXStore::ArchiveOptions options) const {
+        try {
+            nlohmann::json metadata;
+            metadata["SPHINXPubKey"] = SPHINXHybridKey::sphinxKeyToString(SPHINXPubKey);
+            SPHINXStore::ArchiveWriter writer(filename, metadata, options);
+            SPHINXBlock::Block scratch("");
+            for (size_t i = 0; i < getChainLength(); ++i) {
+                writer.append(blockAt(i, scratch));
+            }
+            writer.finish();
+            return true;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    // Load chain data from a block archive; blocks are decoded on access
+    SPHINXChain Chain::loadArchive(const std::string& filename) {
+        std::shared_ptr<SPHINXStore::BlockArchive> archive = SPHINXStore::BlockArchive::open(filename);
+        Chain loadedChain{MainParams()};
+        loadedChain.attachBlockSource(archive);  // Drops the freshly created genesis block, the archive has its own
+        if (archive->metadata().contains("SPHINXPubKey")) {
+            loadedChain.SPHINXPubKey = SPHINXHybridKey::sphinxKeyFromString(archive->metadata()["SPHINXPubKey"]);
+        }
+        loadedChain.rebuildBlockIndex();
+        loadedChain.rebuildState(0);  // Every block is decoded once to replay its transfers
+        loadedChain.publishView();
+        return loadedChain;
+    }
+
+    // Load a block file starting from the newest snapshot and trusted checkpoint; only later blocks are validated
+    SPHINXChain Chain::load(const std::string& filename, const SyncOptions& options, ValidationReport* report) {
+        Chain loadedChain = openBlockFile(filename);  // Not replayed yet: only the blocks above a snapshot need to be
+        size_t validateFrom = 0;
+
+        if (!options.snapshotDirectory.empty()) {
+            for (uint64_t height : SPHINXStore::listSnapshots(options.snapshotDirectory)) {  // Newest first
+                if (height == 0 || height > loadedChain.getChainLength()) {
+                    continue;  // Taken on a longer history than the file holds
+                }
+                try {
+                    const SPHINXStore::StateSnapshot snapshot = SPHINXStore::readSnapshot(SPHINXStore::snapshotFilename(options.snapshotDirectory, height));
+                    if (snapshot.height != height || snapshot.tipHash != loadedChain.getBlockHash(static_cast<uint32_t>(height - 1))) {
+                        continue;  // Taken on another fork
+                    }
+                    if (!options.snapshotCommitment.empty() && snapshot.commitment != options.snapshotCommitment) {
+                        continue;  // Not the trusted state
+                    }
+                    loadedChain.restoreSnapshot(snapshot);
+                    validateFrom = height;  // The snapshot tip was validated when the snapshot was taken
+                    break;
+                } catch (const std::runtime_error&) {
+                    continue;  // Damaged snapshot, fall back to an older one
+                }
+            }
+        }
+        if (validateFrom == 0) {
+            loadedChain.rebuildState(0);  // No usable snapshot, replay the whole history
+            loadedChain.publishView();
+        }
+
+        if (!options.checkpointHash.empty()) {
+            const uint32_t checkpointHeight = loadedChain.findBlockByHash(options.checkpointHash);
+            if (checkpointHeight == BLOCK_NOT_FOUND) {
+                throw std::runtime_error("Checkpoint block not found: " + options.checkpointHash);
+            }
+            validateFrom = std::max<size_t>(validateFrom, checkpointHeight);  // The checkpoint block itself is still checked against its hash
+        }
+
+        const ValidationReport validation = loadedChain.validateChain(validateFrom);
+        if (report != nullptr) {
+            *report = validation;
+        }
+        if (!validation.valid) {
+            throw std::runtime_error("Invalid block at height " + std::to_string(validation.firstInvalidHeight));
+        }
+        return loadedChain;
+    }
+
+    // Export the chain data to a file in JSON format
+    bool Chain::exportJson(const std::string& filename, SPHINXStore::JsonExportOptions options) const {
+        std::ofstream outputFile(filename, std::ios::binary);
+        if (!outputFile.is_open()) {
+            return false;
+        }
+        try {
+            writeJson(outputFile, options);
+            outputFile.close();
+            return !outputFile.fail();
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    // Stream the chain data as JSON, one block at a time
+    void Chain::writeJson(std::ostream& out, SPHINXStore::JsonExportOptions options) const {
+        const size_t to = std::min(options.to, getChainLength());
+        SPHINXStore::JsonChainWriter writer(out, options.compact);
+        writer.begin(SPHINXHybridKey::sphinxKeyToString(SPHINXPubKey));
+        SPHINXBlock::Block scratch("");
+        for (size_t i = options.from; i < to; ++i) {
+            writer.writeBlock(blockAt(i, scratch));  // Stored blocks are decoded into scratch, not cached
+        }
+        writer.finish();
+    }
+
+    // Stream the chain data as JSON to a file descriptor
+    void Chain::writeJson(int fd, SPHINXStore::JsonExportOptions options) const {
+        SPHINXStore::FdOutputBuffer buffer(fd);
+        std::ostream out(&buffer);
+        writeJson(out, options);
+    }
+
+    // Attach an append-only journal. An existing journal is recovered (a torn tail is truncated) and becomes the chain's history;
+    // a new journal receives the blocks the chain already holds once, after that only new blocks are written
+    void Chain::openJournal(const std::string& filename, SPHINXStore::JournalOptions options) {
+        if (forks_) {
+            throw std::runtime_error("A fork-aware chain cannot be journaled: the journal is append-only");
+        }
+        nlohmann::json metadata;
+        metadata["SPHINXPubKey"] = SPHINXHybridKey::sphinxKeyToString(SPHINXPubKey);
+        std::unique_ptr<SPHINXStore::BlockJournal> journal = SPHINXStore::BlockJournal::open(filename, metadata, options);
+
+        if (journal->recordCount() > 0) {
+            std::shared_ptr<SPHINXStore::BlockStore> store = SPHINXStore::BlockStore::open(filename);
+            attachBlockSource(store);  // Serve the journaled blocks lazily from the file
+            if (store->metadata().contains("SPHINXPubKey")) {
+                SPHINXPubKey = SPHINXHybridKey::sphinxKeyFromString(store->metadata()["SPHINXPubKey"]);
+            }
+            rebuildBlockIndex();
+            rebuildState(0);
+            publishView();
+        } else {
+            SPHINXBlock::Block scratch("");
+            for (size_t i = 0; i < getChainLength(); ++i) {
+                journal->append(blockAt(i, scratch));
+            }
+            journal->flush();
+        }
+        journal_ = std::move(journal);
+    }
+
+    // Sync every journaled block to stable storage
+    void Chain::flushJournal() {
+        if (journal_) {
+            journal_->flush();
+        }
+    }
+
+    // Append one block to the journal; the fsync is batched with other appends by the journal
+    void Chain::appendToJournal(const SPHINXBlock::Block& block) {
+        if (journal_) {
+            journal_->append(block);
+        }
+    }
+
+    // Journal a block before the chain takes it, so a failed append changes nothing
+    void Chain::appendBlock(const SPHINXBlock::Block& block) {
+        const SPHINXTree::BlockEffect effect = checkBlockEffect(block);  // Throws before anything changes
+        appendToJournal(block);  // Persist just this block
+        applyBlockEffect(effect);
+        blockIndex_.insert(block.getBlockHash(), static_cast<uint32_t>(getChainLength()));  // Index the block by its hash
+        blocks_.push_back(block);  // Add the block to the chain
+    }
+
+    // Capture the chain and shard balances at the current tip
+    SPHINXStore::StateSnapshot Chain::snapshot() const {
+        std::lock_guard<std::recursive_mutex> writeLock(*writeMutex_);
+        SPHINXStore::StateSnapshot state;
+        state.height = getChainLength();
+        if (state.height > 0) {
+            state.tipHash = std::string(getBlockHash(static_cast<uint32_t>(state.height - 1)));
+        }
+        state.balances = balances_;
+        {
+            std::shared_lock<std::shared_mutex> lock(*shardsMutex_);
+
+            // Hold every shard at once, locked in address order like transferBetweenShards, so no cross-shard transfer is half seen
+            std::vector<const Shard*> ordered;
+            ordered.reserve(shards_.size());
+            for (const auto& shard : shards_) {
+                ordered.push_back(shard.get());
+            }
+            std::sort(ordered.begin(), ordered.end(), std::less<const Shard*>());
+            std::vector<std::unique_lock<std::mutex>> shardLocks;
+            shardLocks.reserve(ordered.size());
+            for (const Shard* shard : ordered) {
+                shardLocks.emplace_back(shard->mutex);
+            }
+
+            state.shards.reserve(shardIndices_.size());
+            for (const auto& [shardName, index] : shardIndices_) {
+                state.shards.emplace_back(shardName, shards_[index]->balances);
+            }
+        }
+        state.commitment = SPHINXStore::stateCommitment(state);
+        return state;
+    }
+
+    // Write a snapshot of the current state to a file
+    std::string Chain::saveSnapshot(const std::string& filename) const {
+        return SPHINXStore::writeSnapshot(filename, snapshot());
+    }
+
+    // Replace the chain and shard balances with the state of a snapshot
+    void Chain::restoreSnapshot(const SPHINXStore::StateSnapshot& snapshot) {
+        std::lock_guard<std::recursive_mutex> writeLock(*writeMutex_);
+        if (snapshot.height == 0 || snapshot.height > getChainLength() ||
+            getBlockHash(static_cast<uint32_t>(snapshot.height - 1)) != snapshot.tipHash) {
+            throw std::runtime_error("Snapshot does not match the chain at height " + std::to_string(snapshot.height));
+        }
+        balances_ = snapshot.balances;
+        for (const auto& [shardName, balances] : snapshot.shards) {
+            bool exists;
+            {
+                std::shared_lock<std::shared_mutex> lock(*shardsMutex_);
+                exists = shardIndices_.count(shardName) > 0;
+            }
+            if (!exists) {
+                createShard(shardName);
+            }
+            Shard& shard = findShard(shardName);
+            std::lock_guard<std::mutex> shardLock(shard.mutex);
+            shard.balances = balances;
+        }
+        rebuildState(snapshot.height);  // The blocks above the snapshot move the balances on from its state
+        publishView();
+    }
+
+    // Enable periodic snapshots
+    void Chain::enableSnapshots(SPHINXStore::SnapshotOptions options) {
+        if (!options.directory.empty()) {
+            std::filesystem::create_directories(options.directory);  // Fail here rather than in addBlock
+        }
+        snapshotOptions_ = std::move(options);
+    }
+
+    // Write a snapshot when the chain length reaches the next multiple of the interval, keeping the newest few
+    void Chain::takePeriodicSnapshot() {
+        const size_t length = getChainLength();
+        if (snapshotOptions_.directory.empty() || snapshotOptions_.interval == 0 || length % snapshotOptions_.interval != 0) {
+            return;
+        }
+        try {
+            SPHINXStore::writeSnapshot(SPHINXStore::snapshotFilename(snapshotOptions_.directory, length), snapshot());
+            SPHINXStore::pruneSnapshots(snapshotOptions_.directory, std::max<size_t>(snapshotOptions_.keep, 1));
+            ++snapshotStats_.taken;
+        } catch (const std::exception& error) {
+            ++snapshotStats_.failed;  // The block stays added; the next interval tries again
+            snapshotStats_.lastError = error.what();
+        }
+    }
+
+    // Get the periodic snapshot counters
+    SPHINXStore::SnapshotStats Chain::snapshotStats() const {
+        std::lock_guard<std::recursive_mutex> writeLock(*writeMutex_);
+        return snapshotStats_;
+    }
+
+    // Get the height of a block by its hash using the hash index
+    uint32_t Chain::findBlockByHash(const std::string& blockHash) const {
+        return blockIndex_.find(blockHash);
+    }
+
+    // Rebuild the hash index over every block of the chain
+    void Chain::rebuildBlockIndex() {
+        blockIndex_.clear();
+        blockIndex_.reserve(getChainLength());
+        const size_t stored = storedBlockCount();
+        for (size_t i = 0; i < stored; ++i) {
+            blockIndex_.insert(blockSource_->blockHash(i), static_cast<uint32_t>(i));  // Straight from the mapping
+        }
+        for (size_t i = 0; i < blocks_.size(); ++i) {
+            blockIndex_.insert(blocks_[i].getBlockHash(), static_cast<uint32_t>(stored + i));
+        }
+        resetUndo();  // Heights of the old block list no longer apply
+        if (forks_) {
+            resetForkTree();  // The block list was replaced, branches of the old one no longer apply
+        }
+    }
+
+    // Get the number of blocks served by the block file
+    size_t Chain::storedBlockCount() const {
+        return blockSource_ ? blockSource_->size() : 0;
+    }
+
+    // Replace the block list with the given block file
+    void Chain::attachBlockSource(std::shared_ptr<const SPHINXStore::BlockSource> source) {
+        blocks_.clear();
+        blockSource_ = std::move(source);
+        if (coldStore_) {
+            // A pruned chain keeps pruning on top of the new source
+            coldStore_ = SPHINXStore::ColdBlockStore::create(pruneOptions_.directory, blockSource_);
+            blockSource_ = coldStore_->view(coldStore_->size());
+        }
+        decodedBlocks_ = blockSource_ ? std::make_unique<DecodedBlocks>() : nullptr;
+        if (decodedBlocks_ && coldStore_) {
+            decodedBlocks_->capacity = std::max<size_t>(pruneOptions_.cacheBlocks, 1);
+        }
+        publishView();
+    }
+
+    // Enable pruning: blocks beyond the hot window move to a compressed cold store
+    void Chain::enablePruning(SPHINXStore::PruneOptions options) {
+        pruneOptions_ = std::move(options);
+        coldStore_ = SPHINXStore::ColdBlockStore::create(pruneOptions_.directory, blockSource_);
+        blockSource_ = coldStore_->view(coldStore_->size());
+        if (!decodedBlocks_) {
+            decodedBlocks_ = std::make_unique<DecodedBlocks>();
+        }
+        {
+            std::lock_guard<std::mutex> lock(decodedBlocks_->mutex);
+            DecodedBlocks& cache = *decodedBlocks_;
+            cache.capacity = std::max<size_t>(pruneOptions_.cacheBlocks, 1);
+            while (cache.blocks.size() > cache.capacity) {
+                cache.blocks.erase(cache.recent.back());
+                cache.recent.pop_back();
+            }
+        }
+        pruneHotBlocks();
+        publishView();
+    }
+
+    // Enable fork-aware block acceptance, with the tree rooted at the current tip
+    void Chain::enableForks(SPHINXTree::ForkOptions options) {
+        if (journal_) {
+            throw std::runtime_error("Forks cannot be enabled on a journaled chain: the journal is append-only");
+        }
+        undo_.setDepth(std::max(undo_.depth(), options.maxReorgDepth));  // A reorg rolls back through the undo records
+        forks_ = std::make_unique<ForkState>(std::move(options));
+        resetForkTree();
+    }
+
+    // Drop the branches and orphans and root the tree at the tip
+    void Chain::resetForkTree() {
+        forks_->tree.reset(SPHINXIndex::toDigest(getBlockHash(static_cast<uint32_t>(getChainLength() - 1))), static_cast<uint32_t>(getChainLength() - 1));
+        forks_->sideBlocks.clear();
+        forks_->orphans.clear();
+    }
+
+    // Accept a block into the tree, or into the orphan pool when its parent is unknown
+    SPHINXTree::AcceptResult Chain::acceptBlock(const SPHINXBlock::Block& block) {
+        std::lock_guard<std::recursive_mutex> writeLock(*writeMutex_);
+        if (!forks_) {
+            throw std::runtime_error("Forks are not enabled on this chain");
+        }
+        ForkState& forks = *forks_;
+        const SPHINXIndex::BlockDigest hash = SPHINXIndex::toDigest(block.getBlockHash());
+        if (forks.tree.contains(hash) || forks.orphans.contains(hash) || blockIndex_.find(block.getBlockHash()) != SPHINXIndex::BlockIndex::NOT_FOUND) {
+            return SPHINXTree::AcceptResult::Duplicate;
+        }
+        checkBlockSize(block);  // Before the signature check and before an oversized block can sit in the orphan pool
+        if (!block.verifyBlock(SPHINXPubKey)) {  // Verify the block using the public key
+            throw std::runtime_error("Invalid block! Block verification failed.");
+        }
+        if (!forks.tree.contains(SPHINXIndex::toDigest(block.getPreviousHash()))) {
+            if (blockIndex_.find(block.getPreviousHash()) != SPHINXIndex::BlockIndex::NOT_FOUND) {
+                ++forks.stats.rejected;  // The parent is on the chain, but below the reorg window
+                return SPHINXTree::AcceptResult::Stale;
+            }
+            forks.stats.orphansEvicted += forks.orphans.add(block);
+            return SPHINXTree::AcceptResult::Orphaned;
+        }
+
+        const SPHINXIndex::BlockDigest tipBefore = forks.tree.bestTip();
+        SPHINXTree::AcceptResult result = insertIntoTree(block);
+
+        // Orphans waiting for this block, and for the orphans released by it
+        std::vector<SPHINXIndex::BlockDigest> released{hash};
+        for (size_t i = 0; i < released.size(); ++i) {
+            for (const SPHINXBlock::Block& child : forks.orphans.takeChildren(released[i])) {
+                try {
+                    if (insertIntoTree(child) == SPHINXTree::AcceptResult::Reorganized) {
+                        result = SPHINXTree::AcceptResult::Reorganized;
+                    }
+                    released.push_back(SPHINXIndex::toDigest(child.getBlockHash()));
+                } catch (const std::exception&) {
+                    ++forks.stats.rejected;  // A bad orphan does not fail the block that released it
+                }
+            }
+        }
+
+        if (forks.tree.bestTip() != tipBefore) {
+            // Keep the tree to the reorg window, dropping branches that fork below it
+            const uint32_t bestHeight = static_cast<uint32_t>(getChainLength() - 1);
+            const size_t window = std::min<size_t>(forks.options.maxReorgDepth, UINT32_MAX / 2);
+            if (bestHeight - forks.tree.rootHeight() > 2 * window) {
+                for (const SPHINXIndex::BlockDigest& dropped : forks.tree.pruneBelow(static_cast<uint32_t>(bestHeight - window))) {
+                    forks.sideBlocks.erase(dropped);
+                }
+            }
+            pruneHotBlocks();
+            publishView();
+            takePeriodicSnapshot();
+        }
+        return result;
+    }
+
+    // Place a block under its parent: extend the tip, or store it on a branch and switch if the branch has the most work
+    SPHINXTree::AcceptResult Chain::insertIntoTree(const SPHINXBlock::Block& block) {
+        ForkState& forks = *forks_;
+        const SPHINXIndex::BlockDigest hash = SPHINXIndex::toDigest(block.getBlockHash());
+        const SPHINXIndex::BlockDigest parent = SPHINXIndex::toDigest(block.getPreviousHash());
+        const uint64_t work = forks.options.blockWork ? forks.options.blockWork(block) : 1;
+
+        if (parent == forks.tree.bestTip()) {
+            forks.tree.insert(hash, parent, work);
+            try {
+                connectBlock(block);
+            } catch (...) {
+                forks.tree.removeBranch(hash);
+                throw;
+            }
+            return SPHINXTree::AcceptResult::Connected;
+        }
+
+        const SPHINXTree::TreeNode& parentNode = *forks.tree.find(parent);
+        if (parentNode.mainChain && getChainLength() - 1 - parentNode.height > forks.options.maxReorgDepth) {
+            ++forks.stats.rejected;
+            return SPHINXTree::AcceptResult::Stale;
+        }
+        const SPHINXTree::TreeNode node = forks.tree.insert(hash, parent, work);
+        forks.sideBlocks.emplace(hash, block);
+        if (SPHINXTree::BlockTree::moreWork(node, *forks.tree.find(forks.tree.bestTip())) && reorganizeTo(hash)) {
+            return SPHINXTree::AcceptResult::Reorganized;
+        }
+        return SPHINXTree::AcceptResult::SideBranch;
+    }
+
+    // Apply the transfers of a block and append it
+    void Chain::connectBlock(const SPHINXBlock::Block& block) {
+        applyBlockEffect(checkBlockEffect(block));
+        pushTip(block);
+    }
+
+    // Sum the transfers of a block and check them against the balances
+    SPHINXTree::BlockEffect Chain::checkBlockEffect(const SPHINXBlock::Block& block) const {
+        SPHINXTree::BlockEffect effect = SPHINXTree::blockEffect(block);
+        for (size_t i = 0; i < effect.addresses.size(); ++i) {
+            if (effect.amounts[i] < 0 && balances_.balance(effect.addresses[i]) < -effect.amounts[i]) {
+                throw std::runtime_error("Invalid block! Transfers overdraw address " + effect.addresses[i]);
+            }
+        }
+        return effect;
+    }
+
+    // Apply the transfers of a checked block
+    void Chain::applyBlockEffect(const SPHINXTree::BlockEffect& effect) {
+        const std::vector<SPHINXLedger::BalanceDelta> deltas = effect.deltas(1);
+        undo_.save(balances_, deltas, nextHeight());  // In the record of this block
+        balances_.applyBatch(deltas);
+        balancesChanged_ = true;
+    }
+
+    // Make a block the tip of the best chain
+    void Chain::pushTip(const SPHINXBlock::Block& block) {
+        blockIndex_.insert(block.getBlockHash(), static_cast<uint32_t>(getChainLength()));  // Index the block by its hash
+        blocks_.push_back(block);  // Add the block to the chain
+        const SPHINXIndex::BlockDigest hash = SPHINXIndex::toDigest(block.getBlockHash());
+        forks_->tree.setMainChain(hash, true);
+        forks_->tree.setBestTip(hash);
+    }
+
+    // Remove the blocks above height; published views share the removed blocks, so they are cut off rather than destroyed
+    std::vector<SPHINXBlock::Block> Chain::disconnectAbove(uint32_t height) {
+        const size_t keep = height + 1 - storedBlockCount();
+        std::vector<SPHINXBlock::Block> removed;
+        removed.reserve(blocks_.size() - keep);
+        for (size_t i = blocks_.size(); i > keep; --i) {
+            removed.push_back(blocks_[i - 1]);
+            blockIndex_.erase(removed.back().getBlockHash());
+            forks_->tree.setMainChain(SPHINXIndex::toDigest(removed.back().getBlockHash()), false);
+        }
+        blocks_.truncate(keep);
+        forks_->tree.setBestTip(SPHINXIndex::toDigest(getBlockHash(height)));
+        return removed;
+    }
+
+    // Disconnect down to the fork point, then connect the branch; all or nothing
+    bool Chain::reorganizeTo(const SPHINXIndex::BlockDigest& tip) {
+        ForkState& forks = *forks_;
+        const SPHINXTree::ForkPath path = forks.tree.pathTo(tip);
+        const size_t depth = getChainLength() - 1 - path.forkHeight;
+        if (depth > forks.options.maxReorgDepth || path.forkHeight + 1 < storedBlockCount() || path.forkHeight + 1 < undo_.floor()) {
+            return false;  // Too deep, or the blocks to disconnect or their undo records are no longer held
+        }
+
+        // Balances as of the fork point, in O(accounts changed since)
+        std::vector<SPHINXLedger::UndoRecord> undone = undo_.rollback(balances_, path.forkHeight + 1);
+        balancesChanged_ = true;
+        std::vector<SPHINXIndex::BlockDigest> disconnected;  // Old best chain, tip first
+        for (SPHINXBlock::Block& block : disconnectAbove(path.forkHeight)) {
+            disconnected.push_back(SPHINXIndex::toDigest(block.getBlockHash()));
+            forks.sideBlocks.emplace(disconnected.back(), std::move(block));
+        }
+
+        size_t connected = 0;
+        try {
+            for (; connected < path.connect.size(); ++connected) {
+                auto side = forks.sideBlocks.find(path.connect[connected]);
+                connectBlock(side->second);
+                forks.sideBlocks.erase(side);
+            }
+        } catch (const std::exception& error) {
+            // Back to the old best chain, without the failing block and what was built on it
+            undo_.rollback(balances_, path.forkHeight + 1);
+            for (SPHINXBlock::Block& block : disconnectAbove(path.forkHeight)) {
+                forks.sideBlocks.emplace(SPHINXIndex::toDigest(block.getBlockHash()), std::move(block));
+            }
+            undo_.redo(balances_, std::move(undone));  // The balances exactly as they were before the reorg
+            for (auto hash = disconnected.rbegin(); hash != disconnected.rend(); ++hash) {
+                auto side = forks.sideBlocks.find(*hash);
+                pushTip(side->second);
+                forks.sideBlocks.erase(side);
+            }
+            for (const SPHINXIndex::BlockDigest& dropped : forks.tree.removeBranch(path.connect[connected])) {
+                forks.sideBlocks.erase(dropped);
+            }
+            ++forks.stats.rejected;
+            throw std::runtime_error(std::string("Reorganization aborted, branch dropped: ") + error.what());
+        }
+
+        ++forks.stats.reorgs;
+        forks.stats.blocksDisconnected += depth;
+        forks.stats.deepestReorg = std::max<uint64_t>(forks.stats.deepestReorg, depth);
+        return true;
+    }
+
+    // Get the fork counters
+    SPHINXTree::ForkStats Chain::forkStats() const {
+        if (!forks_) {
+            return {};
+        }
+        SPHINXTree::ForkStats stats = forks_->stats;
+        stats.treeNodes = forks_->tree.size();
+        stats.sideBlocks = forks_->sideBlocks.size();
+        stats.orphans = forks_->orphans.size();
+        return stats;
+    }
+
+    // Undo the balance changes since the block at height was added and remove the blocks after it
+    void Chain::rollbackTo(uint32_t height) {
+        std::lock_guard<std::recursive_mutex> writeLock(*writeMutex_);
+        if (height >= getChainLength()) {
+            throw std::out_of_range("Block height out of range.");
+        }
+        if (journal_) {
+            throw std::runtime_error("A journaled chain cannot be rolled back: the journal is append-only");
+        }
+        const uint32_t length = height + 1;
+        if (length < storedBlockCount()) {
+            throw std::runtime_error("Cannot roll back to height " + std::to_string(height) + ": the blocks above it are no longer held in memory");
+        }
+        std::vector<Shard*> shards;
+        {
+            std::shared_lock<std::shared_mutex> lock(*shardsMutex_);
+            for (const auto& shard : shards_) {
+                shards.push_back(shard.get());
+            }
+        }
+        uint32_t floor = undo_.floor();
+        for (Shard* shard : shards) {
+            std::lock_guard<std::mutex> shardLock(shard->mutex);
+            floor = std::max(floor, shard->undo.floor());
+        }
+        if (length < floor) {
+            throw std::runtime_error("Cannot roll back to height " + std::to_string(height) + ": undo records start at height " + std::to_string(floor - 1));
+        }
+
+        // Nothing has changed yet, and from here on nothing can fail
+        undo_.rollback(balances_, length);
+        balancesChanged_ = true;
+        for (Shard* shard : shards) {
+            std::lock_guard<std::mutex> shardLock(shard->mutex);
+            shard->undo.rollback(shard->balances, length);
+        }
+        const size_t keep = length - storedBlockCount();
+        for (size_t i = keep; i < blocks_.size(); ++i) {
+            blockIndex_.erase(blocks_[i].getBlockHash());
+        }
+        blocks_.truncate(keep);  // Copy-on-write: published views keep the removed blocks
+        if (forks_) {
+            resetForkTree();  // Branches off the removed blocks no longer have a place to go
+        }
+        publishView();
+    }
+
+    // Set how many blocks of undo records are kept, on the chain and on every shard
+    void Chain::setUndoDepth(size_t blocks) {
+        if (forks_) {
+            blocks = std::max(blocks, forks_->options.maxReorgDepth);
+        }
+        undo_.setDepth(blocks);
+        std::shared_lock<std::shared_mutex> lock(*shardsMutex_);
+        for (const auto& shard : shards_) {
+            std::lock_guard<std::mutex> shardLock(shard->mutex);
+            shard->undo.setDepth(blocks);
+        }
+    }
+
+    // Start the undo history of the chain and the shards at the current balances
+    void Chain::resetUndo() {
+        undo_.reset(nextHeight());
+        std::shared_lock<std::shared_mutex> lock(*shardsMutex_);
+        for (const auto& shard : shards_) {
+            std::lock_guard<std::mutex> shardLock(shard->mutex);
+            shard->undo.reset(nextHeight());
+        }
+    }
+
+    // Replay the transfers of the blocks from a height on, with undo records for the blocks rollback can still reach
+    void Chain::rebuildState(size_t fromHeight) {
+        std::lock_guard<std::recursive_mutex> writeLock(*writeMutex_);
+        if (fromHeight == 0) {
+            balances_ = SPHINXLedger::Ledger{};
+        }
+        resetUndo();  // The shards are not replayed, their history starts at the tip
+        undo_.reset(static_cast<uint32_t>(fromHeight));
+        SPHINXBlock::Block scratch("");
+        for (size_t i = fromHeight; i < getChainLength(); ++i) {
+            const SPHINXTree::BlockEffect effect = checkBlockEffect(blockAt(i, scratch));
+            const std::vector<SPHINXLedger::BalanceDelta> deltas = effect.deltas(1);  // Views into effect
+            undo_.save(balances_, deltas, static_cast<uint32_t>(i));  // Older records are trimmed to the undo depth
+            balances_.applyBatch(deltas);
+        }
+        balancesChanged_ = true;
+    }
+
+    // Move the blocks below the hot window to the cold store, in batches so erasing the front of blocks_ stays cheap per block
+    void Chain::pruneHotBlocks() {
+        if (!coldStore_) {
+            return;
+        }
+        const size_t batch = std::max<size_t>(pruneOptions_.hotBlocks / 4, 1);
+        if (blocks_.size() < pruneOptions_.hotBlocks + batch) {
+            return;
+        }
+        const size_t stored = storedBlockCount();
+        const size_t count = blocks_.size() - pruneOptions_.hotBlocks;
+        try {
+            for (size_t i = 0; i < count; ++i) {
+                coldStore_->append(blocks_[i]);
+            }
+        } catch (...) {
+            coldStore_->truncate(stored);  // Nothing moved, the blocks are still hot
+            throw;
+        }
+        blocks_.eraseFront(count);  // Views published before keep their own snapshot of these blocks
+        blockSource_ = coldStore_->view(stored + count);  // Heights are unchanged, so the decoded cache stays valid
+    }
+
+    // Get a block by height; a stored block is decoded on first access and then served from the cache
+    std::shared_ptr<const SPHINXBlock::Block> Chain::blockPtr(size_t index) const {
+        const size_t stored = storedBlockCount();
+        if (index >= stored) {
+            return blocks_.share(index - stored);  // Hot path: shares the segment of blocks_, no copy
+        }
+        std::lock_guard<std::mutex> lock(decodedBlocks_->mutex);
+        DecodedBlocks& cache = *decodedBlocks_;
+        auto it = cache.blocks.find(index);
+        if (it != cache.blocks.end()) {
+            cache.recent.splice(cache.recent.begin(), cache.recent, it->second.second);  // Now the most recently used
+            return it->second.first;
+        }
+
+        auto block = std::make_shared<const SPHINXBlock::Block>(blockSource_->decodeBlock(index));
+        cache.recent.push_front(index);
+        cache.blocks.emplace(index, std::make_pair(block, cache.recent.begin()));
+        while (cache.blocks.size() > cache.capacity) {
+            cache.blocks.erase(cache.recent.back());  // Least recently used; callers still holding it keep it alive
+            cache.recent.pop_back();
+        }
+        return block;
+    }
+
+    // Get a block by height, decoding it from the block file into scratch when it is not in memory
+    const SPHINXBlock::Block& Chain::blockAt(size_t index, SPHINXBlock::Block& scratch) const {
+        const size_t stored = storedBlockCount();
+        if (index < stored) {
+            scratch = blockSource_->decodeBlock(index);
+            return scratch;
         }
-        throw std::runtime_error("Failed to load chain from file: " + filename);
+        return blocks_[index - stored];
+    }
+
+    // Check the whole chain and return true if every block is valid
+    bool Chain::isChainValid() const {
+        return validateChain().valid;
+    }
+
+    // Validate the chain in two passes: every block is hashed exactly once and its signature verified on the thread pool,
+    // then the previous-hash links are checked against the computed hashes in a cheap sequential pass
+    Chain::ValidationReport Chain::validateChain(size_t fromHeight) const {
+        const auto start = std::chrono::steady_clock::now();
+        const size_t count = getChainLength();
+        fromHeight = std::min(fromHeight, count);
+        std::vector<std::string> hashes(count);  // Computed hash of every block, filled by the parallel pass
+        std::vector<std::string> previousHashes(count);  // Recorded previous hash of every block, so pass 2 never decodes again
+        std::atomic<size_t> firstInvalid{count};  // Lowest failing height seen so far
+
+        auto markInvalid = [&firstInvalid](size_t height) {
+            size_t current = firstInvalid.load(std::memory_order_relaxed);
+            while (height < current && !firstInvalid.compare_exchange_weak(current, height, std::memory_order_relaxed)) {
+            }
+        };
+
+        // Block signatures that verified before (on any earlier run) are answered by the signature cache
+        SPHINXBatch::SignatureCache& signatureCache = SPHINXBatch::SignatureCache::shared();
+        // Keyed by the public half of SPHINXKeyPub, the key verifySPHINXBlock checks against, so a cached entry can only
+        // answer for a signature that verified under that same key
+        const std::string chainKey = SPHINXHybridKey::sphinxKeyToString(SPHINXKey::mergePublicKeys(SPHINXKeyPub.merged_key.curve448_public_key, SPHINXKeyPub.merged_key.kyber_public_key));
+
+        // Pass 1: hash and signature check, spread over the work-stealing pool
+        SPHINXPool::ThreadPool::shared().parallelFor(fromHeight, count, VALIDATION_GRAIN, [&](size_t begin, size_t end) {
+            SPHINXBlock::Block scratch("");
+            for (size_t i = begin; i < end; ++i) {
+                if (i > firstInvalid.load(std::memory_order_relaxed)) {
+                    return;  // A lower height already failed, nothing above it matters
+                }
+                const SPHINXBlock::Block& block = blockAt(i, scratch);
+                hashes[i] = block.calculateBlockHash();
+                previousHashes[i] = block.getPreviousHash();
+                if (i == 0) {
+                    continue;  // The genesis block is only needed for the link of block 1
+                }
+                if (block.getBlockHash() != hashes[i]) {
+                    markInvalid(i);
+                    continue;
+                }
+                const std::string signature = block.getSignature();
+                const SPHINXBatch::CacheKey key = SPHINXBatch::SignatureCache::makeKey(hashes[i], signature, chainKey);
+                if (signatureCache.contains(key)) {
+                    continue;  // The hash matched, so this is the exact block that verified before
+                }
+                if (SPHINXVerify::verifySPHINXBlock(block, signature, SPHINXKeyPub)) {
+                    signatureCache.insert(key);
+                } else {
+                    markInvalid(i);
+                }
+            }
+        });
+
+        // Pass 2: previous-hash links, every hash below the first failure has been computed
+        size_t limit = firstInvalid.load();
+        if (fromHeight > 0 && fromHeight < limit) {
+            hashes[fromHeight - 1] = std::string(getBlockHash(static_cast<uint32_t>(fromHeight - 1)));  // Trusted parent, anchored by the stored hash
+        }
+        for (size_t i = std::max<size_t>(fromHeight, 1); i < limit; ++i) {
+            if (previousHashes[i] != hashes[i - 1]) {
+                limit = i;
+                break;
+            }
+        }
+
+        ValidationReport report;
+        report.valid = (limit == count);
+        report.firstInvalidHeight = report.valid ? BLOCK_NOT_FOUND : static_cast<uint32_t>(limit);
+        report.blocksChecked = limit - fromHeight;
+        report.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return report;
     }
 
     // Get the genesis block of the chain
-    SPHINXBlock::Block Chain::getGenesisBlock() const {
-        return blocks_.front();  // Return the first block in the chain
+    std::shared_ptr<const SPHINXBlock::Block> Chain::getGenesisBlock() const {
+        return getBlockAt(0);  // Return the first block in the chain
     }
 
     // Get the block at a specific index in the chain
-    SPHINXBlock::Block Chain::getBlockAt(size_t index) const {
-        if (index < blocks_.size()) {
-            return blocks_[index];  // Return the block at the specified index
+    std::shared_ptr<const SPHINXBlock::Block> Chain::getBlockAt(size_t index) const {
+        if (index < getChainLength()) {
+            return blockPtr(index);  // Share the block at the specified index, no copy
         } else {
             throw std::out_of_range("Index out of range");
         }
     }
 
+    // Get a range over the blocks with heights in [from, to)
+    Chain::BlockRange Chain::blocks(size_t from, size_t to) const {
+        if (from > to || to > getChainLength()) {
+            throw std::out_of_range("Block range out of range");
+        }
+        return BlockRange(this, from, to);
+    }
+
+    // Get a range over every block of the chain
+    Chain::BlockRange Chain::blocks() const {
+        return BlockRange(this, 0, getChainLength());
+    }
+
     // Get the number of blocks in the chain
     size_t Chain::getChainLength() const {
-        return blocks_.size();  // Return the number of blocks in the chain
+        return storedBlockCount() + blocks_.size();  // Return the number of blocks in the chain
+    }
+
+    // Get the current read view; a single atomic load, the writer is never waited for
+    std::shared_ptr<const SPHINXView::ChainView> Chain::view() const {
+        return view_->load(std::memory_order_acquire);
+    }
+
+    // Publish the block list and balances as a new read view. Blocks are shared through an O(1) snapshot of the
+    // segmented block list. The ledger shares its chunks with the view and copies a chunk only when it next writes to it,
+    // so each view costs the chunks touched since the previous one.
+    void Chain::publishView() {
+        std::lock_guard<std::recursive_mutex> writeLock(*writeMutex_);
+        if (balancesChanged_ || !publishedBalances_) {
+            publishedBalances_ = std::make_shared<const SPHINXLedger::Ledger>(balances_.copyAccounts());
+            balancesChanged_ = false;
+        }
+        view_->store(std::make_shared<const SPHINXView::ChainView>(++viewVersion_, blockSource_, blocks_.snapshot(), publishedBalances_),
+                     std::memory_order_release);
     }
 
     // Visualize the chain by printing the index and hash of each block
     void Chain::visualizeChain() const {
-        for (size_t i = 0; i < blocks_.size(); ++i) {
-            const SPHINXBlock::Block& block = blocks_[i];
-            std::cout << "Block " << i << " - Hash: " << block.getBlockHash() << std::endl;  // Print the index and hash of each block
+        for (size_t i = 0; i < getChainLength(); ++i) {
+            std::cout << "Block " << i << " - Hash: " << getBlockHash(static_cast<uint32_t>(i)) << std::endl;  // Print the index and hash of each block
         }
     }
 
@@ -416,18 +1864,11 @@ public:
             throw std::runtime_error("Authentication failed");  // Throw an error if authentication fails
         }
 
-        // Generate and perform a key exchange
-        SPHINXHybridKey::HybridKeypair keyPair = SPHINXKey::generate_and_perform_key_exchange();
-
-        // Calculate the public key
-        SPHINXKey::SPHINXPubKey publicKey = SPHINXKey::mergePublicKeys(keyPair.merged_key.curve448_public_key, keyPair.merged_key.kyber_public_key);
-
         // Create a transaction
         SPHINXTrx::Transaction transferTransaction = createTransaction(sidechainAddress, senderAddress, amount);
 
-        // Sign the transaction using the private key
-        SPHINXKey::SPHINXPrivKey privateKey;  // Replace this with the actual private key
-        std::string signature = SPHINXSign::signTransactionData(transactionToString(transferTransaction), privateKey);
+        // Sign the transaction with the chain's cached key, so it is broadcast signed
+        transferTransaction.setSignature(keyManager_->sign(transactionToString(transferTransaction)));
 
         // Broadcast the transaction
         SPHINXMempool::broadcastTransaction(transferTransaction);
@@ -455,23 +1896,9 @@ public:
             throw std::runtime_error("Authentication failed");
         }
 
-        // Generate and perform a key exchange
-        SPHINXHybridKey::HybridKeypair keyPair = SPHINXKey::generate_and_perform_key_exchange();
-
-        // Calculate the public key
-        SPHINXKey::SPHINXPubKey publicKey = SPHINXKey::calculatePublicKey(keyPair.merged_key.kyber_private_key);
-
-        // Get the transaction data from the bridge
+        // Get the transaction data from the bridge; the bridge vouches for it through verifyTransaction above
         std::string transactionData = bridge.getTransactionData(bridgeAddress);
 
-        // Sent request to Sign the transaction data to "sign.hpp"
-        SPHINXKey::SPHINXPrivKey privateKey;  // Replace this with the actual private key
-        std::string signature = SPHINXSign::signTransactionData(transactionData, privateKey);
-
-        // Throw an error if the signature verification fails
-        if (!SPHINXVerify::verifySignature(transactionData, signature, PUBLIC_KEY)) {
-            throw std::runtime_error("Authentication failed");
-        }
         // Calculate the transaction hash
         std::string transactionHash = SPHINXHash::SPHINX_256(transactionData);
 
@@ -486,11 +1913,9 @@ public:
     }
 
     // Perform an atomic swap between the current chain and a target chain
-    void Chain::performAtomicSwap(const Chain& targetChain, const std::string& senderAddress, const std::string& receiverAddress, double amount) {
+    std::shared_future<SPHINXSwap::SwapState> Chain::performAtomicSwap(const Chain& targetChain, const std::string& senderAddress, const std::string& receiverAddress, double amount) {
         // Get the balance of the sender address
         double senderBalance = getBalance(senderAddress);
-        // Get the balance of the receiver address in the target chain
-        double receiverBalance = targetChain.getBalance(receiverAddress);
         if (senderBalance < amount) {
             // Throw an error if the sender doesn't have enough funds
             throw std::runtime_error("Sender does not have enough funds");
@@ -501,31 +1926,80 @@ public:
             throw std::runtime_error("Authentication failed");
         }
         // Create a transaction from the sender address to the target chain bridge address
-        SPHINXTrx::Transaction senderTransaction = createTransaction(senderAddress, targetChain.getBridgeAddress(), amount);
+        auto senderTransaction = std::make_shared<SPHINXTrx::Transaction>(createTransaction(senderAddress, targetChain.getBridgeAddress(), amount));
         // Create a transaction from the receiver address in the target chain to the sender address
-        SPHINXTrx::Transaction receiverTransaction = targetChain.createTransaction(receiverAddress, senderAddress, amount);
+        auto receiverTransaction = std::make_shared<SPHINXTrx::Transaction>(targetChain.createTransaction(receiverAddress, senderAddress, amount));
+
+        signTransaction(*senderTransaction);  // Sign the sender transaction
+        signTransaction(*receiverTransaction);  // Sign the receiver transaction
+
+        SPHINXSwap::SwapRecord record;
+        record.senderAddress = senderAddress;
+        record.receiverAddress = receiverAddress;
+        record.amount = SPHINXLedger::toAmount(amount);
+        record.senderTransactionId = transactionId(*senderTransaction);
+        record.receiverTransactionId = transactionId(*receiverTransaction);
+
+        // Both chains must outlive the swap: the callbacks run until the returned future is ready
+        const Chain* target = &targetChain;
+        SPHINXSwap::SwapCallbacks callbacks;
+        callbacks.broadcast = [this, target, senderTransaction, receiverTransaction](const SPHINXSwap::SwapRecord&) {
+            broadcastTransaction(*senderTransaction);  // Broadcast the sender transaction
+            target->broadcastTransaction(*receiverTransaction);  // Broadcast the receiver transaction
+        };
+        // Polled on the timer wheel when onTransactionConfirmed is not called for a leg
+        callbacks.senderConfirmed = [senderTransaction] { return senderTransaction->isConfirmed(); };
+        callbacks.receiverConfirmed = [receiverTransaction] { return receiverTransaction->isConfirmed(); };
+        callbacks.settle = [this, target, senderTransaction, receiverTransaction](const SPHINXSwap::SwapRecord& swap) {
+            if (!verifyAtomicSwap(*senderTransaction, *target) || !target->verifyAtomicSwap(*receiverTransaction, *this)) {
+                // Throw an error if the atomic swap verification fails; the engine refunds the swap
+                throw std::runtime_error("Atomic swap verification failed");
+            }
+            // Both legs or neither: a refund leaves the balances untouched
+            // Debit the sender under the write lock; the balance may have changed since the swap started. The lock is
+            // released before the target chain is touched, so two chains settling towards each other cannot deadlock.
+            applyDelta(swap.senderAddress, -swap.amount, true);
+            try {
+                // Update the balance of the receiver address in the target chain
+                target->updateBalance(swap.receiverAddress, SPHINXLedger::toDouble(swap.amount));
+            } catch (...) {
+                applyDelta(swap.senderAddress, swap.amount, false);  // Credit the debit back as a delta, keeping what other writers changed meanwhile
+                throw;
+            }
+        };
+        return swapEngine().start(std::move(record), std::move(callbacks));
+    }
+
+    // Use a persistent swap journal and resume the swaps that were in flight when the node stopped
+    void Chain::openSwapStore(const std::string& filename) {
+        swapEngine_ = std::make_shared<SPHINXSwap::SwapEngine>(filename);
+        swapEngine_->recover([this](const SPHINXSwap::SwapRecord&) {
+            // The transactions and the counterparty chain are gone after a restart, so the receiver leg cannot be
+            // credited; settlement throws and the engine refunds the swap instead of debiting only the sender
+            SPHINXSwap::SwapCallbacks callbacks;
+            callbacks.settle = [](const SPHINXSwap::SwapRecord&) {
+                throw std::runtime_error("Counterparty chain is not available after a restart");
+            };
+            return callbacks;
+        });
+    }
 
-        signTransaction(senderTransaction);  // Sign the sender transaction
-        signTransaction(receiverTransaction);  // Sign the receiver transaction
-        broadcastTransaction(senderTransaction);  // Broadcast the sender transaction
-        targetChain.broadcastTransaction(receiverTransaction);  // Broadcast the receiver transaction
+    // Report a confirmed transaction to the in-flight atomic swaps
+    bool Chain::onTransactionConfirmed(const std::string& transactionId) {
+        return swapEngine().confirmTransaction(transactionId);
+    }
 
-        while (true) {
-            if (senderTransaction.isConfirmed() && receiverTransaction.isConfirmed()) {
-                break;  // Exit the loop if both transactions are confirmed
-            }
-            // Sleep for 10 seconds before checking the confirmation status again
-            std::this_thread::sleep_for(std::chrono::seconds(10));
-        }
+    // Switch to a persistent signing key
+    void Chain::openKeyStore(const std::string& filename) {
+        keyManager_ = std::make_shared<SPHINXKeys::KeyManager>(filename);
+    }
 
-        if (!verifyAtomicSwap(senderTransaction, targetChain) || !targetChain.verifyAtomicSwap(receiverTransaction, *this)) {
-            // Throw an error if the atomic swap verification fails
-            throw std::runtime_error("Atomic swap verification failed");
+    // Get the swap engine, creating an in-memory one on first use
+    SPHINXSwap::SwapEngine& Chain::swapEngine() {
+        if (!swapEngine_) {
+            swapEngine_ = std::make_shared<SPHINXSwap::SwapEngine>();
         }
-        // Update the balance of the sender address
-        updateBalance(senderAddress, -amount);
-        // Update the balance of the receiver address in the target chain
-        targetChain.updateBalance(receiverAddress, amount);
+        return *swapEngine_;
     }
 
     // Sign a transaction using the bridge's private key
@@ -533,58 +2007,290 @@ public:
         // Get the transaction data from the bridge
         std::string transactionData = bridge.getTransactionData(bridgeAddress_);
         
-        // Generate the hybrid key pair
-        SPHINXHybridKey::HybridKeypair hybridKeyPair = SPHINXKey::generate_hybrid_keypair();
-
-        // Get the private key from the hybrid key pair
-        std::string privateKey = SPHINXKey::sphinxKeyToString(hybridKeyPair.merged_key.sphinxPrivKey);
-
-        // Sign the transaction data using the private key
-        std::string signature = SPHINXSign::signTransactionData(transactionData, privateKey);
+        // Sign the transaction data with the chain's key, generated or loaded once by the key manager
+        std::string signature = keyManager_->sign(transactionData);
 
         // Set the transaction signature
         transaction.setSignature(signature);
     }
 
-    // Broadcast a transaction to the network via the bridge and add it to the mempool
-    void Chain::broadcastTransaction(const SPHINXTrx::Transaction& transaction) {
-        // Convert the transaction to JSON
-        std::string transactionJson = transaction.toJson().dump();
-        
-        // Broadcast the transaction via the bridge
-        bridge.broadcastTransaction(bridgeAddress_, transactionJson);
-        
-        // Add the transaction to the mempool
-        mempool.addTransaction(transaction);
+    // Admit a transaction to the mempool and queue it for the background broadcaster
+    void Chain::broadcastTransaction(const SPHINXTrx::Transaction& transaction, double fee, std::optional<uint64_t> nonce) {
+        const SPHINXTxPool::AddResult result = submitTransaction(transaction, fee, nonce);
+        if (result == SPHINXTxPool::AddResult::Duplicate) {
+            return;  // Already pending, and already broadcast
+        }
+        if (result != SPHINXTxPool::AddResult::Added && result != SPHINXTxPool::AddResult::Replaced) {
+            throw std::runtime_error(std::string("Transaction rejected by the mempool: ") + SPHINXTxPool::toString(result));
+        }
+
+        // Queue the transaction; encoding and the bridge call happen on the broadcaster thread, in batches
+        broadcaster().broadcast(transaction);
+    }
+
+    // Index a transaction in the mempool, checking it against the sender's balance
+    SPHINXTxPool::AddResult Chain::submitTransaction(const SPHINXTrx::Transaction& transaction, double fee, std::optional<uint64_t> nonce) {
+        // One binary encoding gives the id (duplicate check) and the size (fee rate) admission needs; no JSON text is built
+        const std::vector<uint8_t> encoded = json::to_cbor(transaction.toJson());
+
+        SPHINXTxPool::PoolEntry entry;
+        entry.id = transactionId(encoded);
+        entry.sender = transaction.getSenderAddress();
+        entry.nonce = nonce.value_or(0);
+        entry.amount = SPHINXLedger::toAmount(transaction.getAmount());
+        entry.fee = SPHINXLedger::toAmount(fee);
+        entry.size = encoded.size();  // What the transaction takes in a block or a broadcast batch
+        entry.transaction = transaction;
+
+        SPHINXLedger::Amount senderBalance;
+        {
+            std::lock_guard<std::recursive_mutex> writeLock(*writeMutex_);
+            senderBalance = balances_.balance(entry.sender);
+        }
+        return mempool_->add(std::move(entry), senderBalance, !nonce);  // The default nonce is taken under the pool lock
+    }
+
+    // Pick the pending transactions for the next block
+    std::vector<SPHINXTrx::Transaction> Chain::selectForBlock(size_t maxBytes) const {
+        std::vector<SPHINXTxPool::PoolEntry> entries = mempool_->selectForBlock(blockBudget(maxBytes));
+        std::vector<SPHINXTrx::Transaction> transactions;
+        transactions.reserve(entries.size());
+        for (SPHINXTxPool::PoolEntry& entry : entries) {
+            transactions.push_back(std::move(entry.transaction));
+        }
+        return transactions;
+    }
+
+    // Drop the transactions of a block from the mempool
+    size_t Chain::removeFromMempool(std::span<const SPHINXTrx::Transaction> transactions) {
+        std::vector<std::string> ids;
+        ids.reserve(transactions.size());
+        for (const SPHINXTrx::Transaction& transaction : transactions) {
+            ids.push_back(transactionId(transaction));
+        }
+        return mempool_->remove(ids);
+    }
+
+    // Re-check the pending transactions against the current balances
+    size_t Chain::pruneMempool() {
+        std::lock_guard<std::recursive_mutex> writeLock(*writeMutex_);
+        return mempool_->dropUnaffordable([this](std::string_view sender) { return balances_.balance(sender); });
+    }
+
+    // Get the mempool counters
+    SPHINXTxPool::PoolStats Chain::mempoolStats() const {
+        return mempool_->stats();
+    }
+
+    // Transaction bytes left in a block on top of the tip once the overhead is taken off
+    size_t Chain::blockBudget(size_t maxBytes) const {
+        const size_t overhead = SPHINXTemplate::blockOverhead(std::string(getBlockHash(static_cast<uint32_t>(getChainLength() - 1))));
+        const size_t budget = maxBlockSize_ > overhead ? maxBlockSize_ - overhead : 0;
+        return maxBytes == 0 ? budget : std::min(maxBytes, budget);
+    }
+
+    // Reject a block larger than the maximum block size
+    void Chain::checkBlockSize(const SPHINXBlock::Block& block) const {
+        if (SPHINXTemplate::encodedBlockSize(block) > maxBlockSize_) {
+            throw std::runtime_error("Invalid block! Block exceeds the maximum block size.");
+        }
+    }
+
+    // Assemble a block from the mempool; the pool has already ordered the transactions by fee rate
+    SPHINXTemplate::BlockTemplate Chain::buildBlockTemplate(size_t maxBytes) const {
+        const size_t budget = blockBudget(maxBytes);
+        SPHINXTemplate::BlockAssembler assembler(std::string(getBlockHash(static_cast<uint32_t>(getChainLength() - 1))), budget);
+        for (const SPHINXTxPool::PoolEntry& entry : mempool_->selectForBlock(budget)) {
+            assembler.add(entry);
+        }
+        return assembler.finish();
+    }
+
+    // Assemble a block from explicit candidates
+    SPHINXTemplate::BlockTemplate Chain::buildBlockTemplate(std::span<const SPHINXTxPool::PoolEntry> candidates, size_t maxBytes) const {
+        return SPHINXTemplate::buildTemplate(std::string(getBlockHash(static_cast<uint32_t>(getChainLength() - 1))), candidates, blockBudget(maxBytes));
+    }
+
+    // Replace the broadcaster with one that sends to the given sink
+    void Chain::openBroadcast(SPHINXBroadcast::BatchSink sink, SPHINXBroadcast::BroadcastOptions options) {
+        broadcaster_.reset();  // Drains the previous broadcaster
+        broadcaster_ = std::make_unique<SPHINXBroadcast::Broadcaster>(std::move(sink), options);
+    }
+
+    // Wait for the queued broadcasts
+    void Chain::flushBroadcasts() {
+        if (broadcaster_) {
+            broadcaster_->flush();
+        }
+    }
+
+    // Get the broadcaster counters
+    SPHINXBroadcast::BroadcastMetrics Chain::broadcastMetrics() const {
+        return broadcaster_ ? broadcaster_->metrics() : SPHINXBroadcast::BroadcastMetrics{};
+    }
+
+    // Get the broadcaster, creating a bridge-backed one on first use
+    SPHINXBroadcast::Broadcaster& Chain::broadcaster() {
+        std::call_once(*broadcasterOnce_, [this] {
+            if (!broadcaster_) {
+                // The sink keeps its own copy of the address, so it never refers back to a chain that may have been moved
+                broadcaster_ = std::make_unique<SPHINXBroadcast::Broadcaster>([bridgeAddress = bridgeAddress_](std::span<const uint8_t> batch, size_t) {
+                    bridge.broadcastTransaction(bridgeAddress, std::string(batch.begin(), batch.end()));  // One bridge call per batch
+                });
+            }
+        });
+        return *broadcaster_;
     }
 
     // Update the balance of a given address by adding the specified amount
     void Chain::updateBalance(const std::string& address, double amount) {
-        balances_[address] += amount;  // Update the balance of the given address by adding the specified amount
+        applyDelta(address, SPHINXLedger::toAmount(amount), false);  // Converted to fixed point once, the sum itself is exact
+    }
+
+    // Add a fixed-point delta to a balance; swap settlement calls this from the swap pool
+    void Chain::applyDelta(const std::string& address, SPHINXLedger::Amount delta, bool requireFunds) {
+        std::lock_guard<std::recursive_mutex> writeLock(*writeMutex_);
+        const SPHINXLedger::AddressId id = balances_.intern(address);
+        if (requireFunds && balances_.balance(id) + delta < 0) {
+            throw std::runtime_error("Insufficient balance for address: " + address);  // Checked at settlement, not when the swap started
+        }
+        undo_.save(balances_, id, nextHeight());  // Previous balance, for rollbackTo
+        balances_.add(id, delta);
+        balancesChanged_ = true;  // Readers see it with the next published view
     }
 
     // Get the balance of a given address
     double Chain::getBalance(const std::string& address) const {
-        if (balances_.count(address) > 0) {
-            return balances_.at(address);  // Return the balance of the given address if it exists
-        }
-        return 0.0;  // Return 0 if the balance of the given address is not found
+        std::lock_guard<std::recursive_mutex> writeLock(*writeMutex_);
+        return SPHINXLedger::toDouble(balances_.balance(address));  // Unknown addresses have a zero balance
     }
 
     // Verify an atomic swap transaction by checking the transaction signature and the bridge transaction in the target chain
     bool Chain::verifyAtomicSwap(const SPHINXTrx::Transaction& transaction, const Chain& targetChain) const {
-        std::string transactionData = bridge.getTransactionData(bridgeAddress_);
-        std::string signature = transaction.getSignature();
-        std::string senderPublicKey = transaction.getSenderPublicKey();
         // Verify the transaction signature and the bridge transaction in the target chain
-        return SPHINXVerify::verifySignature(transactionData, signature, senderPublicKey) && targetChain.verifyBridgeTransaction(transaction);
+        return verifyBridgeSignatures(std::span<const SPHINXTrx::Transaction>(&transaction, 1))[0] && targetChain.verifyBridgeTransaction(transaction);
+    }
+
+    // Verify an atomic swap transaction against a state root and a proof of the sender balance
+    bool Chain::verifyAtomicSwap(const SPHINXTrx::Transaction& transaction, const std::string& stateRoot, const SPHINXLedger::StateProof& senderProof) const {
+        // The address comes from the signed transaction, so a proof for some other funded account does not pass
+        const std::optional<SPHINXLedger::Amount> balance = SPHINXLedger::StateTree::verify(stateRoot, transaction.getSenderAddress(), senderProof);
+        if (!balance || *balance < SPHINXLedger::toAmount(transaction.getAmount())) {
+            return false;  // Proof does not match the root, or the sender cannot cover the amount
+        }
+        return verifyBridgeSignatures(std::span<const SPHINXTrx::Transaction>(&transaction, 1))[0];
+    }
+
+    // Get the root of the commitment over the chain balances
+    std::string Chain::stateRoot() const {
+        std::lock_guard<std::recursive_mutex> writeLock(*writeMutex_);
+        return balances_.stateRoot();
+    }
+
+    // Prove the balance of an address on the chain
+    SPHINXLedger::StateProof Chain::proveBalance(const std::string& address) const {
+        std::lock_guard<std::recursive_mutex> writeLock(*writeMutex_);
+        return balances_.prove(address);
+    }
+
+    // Get the root of the commitment over the balances of a shard
+    std::string Chain::shardStateRoot(const std::string& shardName) const {
+        const Shard& shard = findShard(shardName);
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+        return shard.balances.stateRoot();
+    }
+
+    // Prove the balance of an address in a shard
+    SPHINXLedger::StateProof Chain::proveShardBalance(const std::string& shardName, const std::string& address) const {
+        const Shard& shard = findShard(shardName);
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+        return shard.balances.prove(address);
+    }
+
+    // Check a balance proof against a state root
+    std::optional<double> Chain::verifyBalanceProof(const std::string& stateRoot, const std::string& address, const SPHINXLedger::StateProof& proof) {
+        const std::optional<SPHINXLedger::Amount> balance = SPHINXLedger::StateTree::verify(stateRoot, address, proof);
+        if (!balance) {
+            return std::nullopt;
+        }
+        return SPHINXLedger::toDouble(*balance);
+    }
+
+    // Verify the bridge signatures of a batch of transactions
+    std::vector<uint8_t> Chain::verifyBridgeSignatures(std::span<const SPHINXTrx::Transaction> transactions) const {
+        const std::string transactionData = bridge.getTransactionData(bridgeAddress_);  // Signed bridge data, the same for the whole batch
+        std::vector<std::string> signatures;
+        std::vector<std::string> publicKeys;
+        signatures.reserve(transactions.size());
+        publicKeys.reserve(transactions.size());
+        for (const SPHINXTrx::Transaction& transaction : transactions) {
+            signatures.push_back(transaction.getSignature());
+            publicKeys.push_back(transaction.getSenderPublicKey());
+        }
+
+        std::vector<SPHINXBatch::SignatureCheck> checks(transactions.size());
+        for (size_t i = 0; i < transactions.size(); ++i) {
+            checks[i] = SPHINXBatch::SignatureCheck{transactionData, signatures[i], publicKeys[i]};
+        }
+        return SPHINXBatch::verifyBatch(checks, nullptr, &SPHINXBatch::SignatureCache::shared());
     }
 
     // Handle a transfer transaction by updating the balance of the recipient address
     void Chain::handleTransfer(const SPHINXTrx::Transaction& transaction) {
-        std::string recipientAddress = transaction.getRecipientAddress();
-        double amount = transaction.getAmount();
-        updateBalance(recipientAddress, amount);  // Update the balance of the recipient address
+        applyTransfers(std::span<const SPHINXTrx::Transaction>(&transaction, 1));  // Same validation and single publish as a batch of one
+    }
+
+    // Apply a batch of transfers: validate everything, coalesce per recipient, then commit all-or-nothing
+    void Chain::applyTransfers(std::span<const SPHINXTrx::Transaction> transactions) {
+        std::lock_guard<std::recursive_mutex> writeLock(*writeMutex_);
+        std::vector<std::string> recipients;
+        std::vector<SPHINXLedger::BalanceDelta> deltas;
+        coalesceTransfers(transactions, recipients, deltas);
+
+        // Commit: the ledger applies every delta or none of them
+        undo_.save(balances_, deltas, nextHeight());
+        balances_.applyBatch(deltas);
+        balancesChanged_ = true;
+        publishView();  // Once per batch
+    }
+
+    // Validate a batch of transfers and coalesce it into one delta per recipient
+    void Chain::coalesceTransfers(std::span<const SPHINXTrx::Transaction> transactions, std::vector<std::string>& recipients, std::vector<SPHINXLedger::BalanceDelta>& deltas) {
+        // Validate the whole batch before touching any balance
+        std::vector<SPHINXLedger::Amount> amounts;
+        recipients.clear();
+        deltas.clear();
+        recipients.reserve(transactions.size());
+        amounts.reserve(transactions.size());
+        for (size_t i = 0; i < transactions.size(); ++i) {
+            std::string recipientAddress = transactions[i].getRecipientAddress();
+            const double amount = transactions[i].getAmount();
+            if (recipientAddress.empty()) {
+                throw std::invalid_argument("Invalid transfer at index " + std::to_string(i) + ": missing recipient");
+            }
+            if (!(amount > 0.0)) {
+                throw std::invalid_argument("Invalid transfer at index " + std::to_string(i) + ": amount must be positive");
+            }
+            recipients.push_back(std::move(recipientAddress));
+            amounts.push_back(SPHINXLedger::toAmount(amount));  // Throws if the amount cannot be represented
+        }
+
+        // Group by recipient so every account is updated once
+        std::vector<uint32_t> order(transactions.size());
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&recipients](uint32_t a, uint32_t b) { return recipients[a] < recipients[b]; });
+
+        for (uint32_t index : order) {
+            if (!deltas.empty() && deltas.back().first == recipients[index]) {
+                if (__builtin_add_overflow(deltas.back().second, amounts[index], &deltas.back().second)) {
+                    throw std::overflow_error("Transfer batch overflows the balance of " + recipients[index]);
+                }
+            } else {
+                deltas.emplace_back(recipients[index], amounts[index]);
+            }
+        }
     }
 
     // Get the bridge address of the chain
@@ -599,29 +2305,28 @@ public:
 
     // Create a new shard with the given shard name
     void Chain::createShard(const std::string& shardName) {
-        Shard shard;
-        shard.bridgeAddress = shardName;
-        shard.chain = Chain();
-        shards_.push_back(shard);  // Add a new shard to the shard vector
+        auto shard = std::make_unique<Shard>();
+        shard->bridgeAddress = shardName;
+        shard->chain = Chain();
+        shard->undo.setDepth(undo_.depth());
+        std::unique_lock<std::shared_mutex> lock(*shardsMutex_);  // Only the shard directory is locked exclusively
+        if (shardIndices_.count(shardName) > 0) {
+            throw std::runtime_error("Shard already exists: " + shardName);
+        }
+        shards_.push_back(std::move(shard));  // Add a new shard to the shard vector
         shardIndices_[shardName] = shards_.size() - 1;  // Store the shard index by shard name for quick access
     }
 
     // Join an existing shard with the given shard name and chain
     void Chain::joinShard(const std::string& shardName, const Chain& shardChain) {
-        auto it = shardIndices_.find(shardName);
-        if (it == shardIndices_.end()) {
-            throw std::runtime_error("Shard does not exist: " + shardName);  // Throw an error if the shard does not exist
-        }
-        shards_[it->second].chain = shardChain;  // Join the shard by assigning the shard chain to the corresponding shard
+        Shard& shard = findShard(shardName);
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+        shard.chain = shardChain;  // Join the shard by assigning the shard chain to the corresponding shard
     }
 
     // Transfer funds from the main chain to a shard
     void Chain::transferToShard(const std::string& shardName, const std::string& senderAddress, const std::string& recipientAddress, double amount) {
-        auto it = shardIndices_.find(shardName);
-        if (it == shardIndices_.end()) {
-            throw std::runtime_error("Shard does not exist: " + shardName);  // Throw an error if the shard does not exist
-        }
-        Shard& shard = shards_[it->second];  // Get the reference to the shard
+        Shard& shard = findShard(shardName);  // Get the reference to the shard
         double senderBalance = getBalance(senderAddress);
         if (amount > senderBalance) {
             throw std::runtime_error("Sender does not have enough funds");  // Throw an error if the sender doesn't have enough funds
@@ -631,32 +2336,26 @@ public:
             throw std::runtime_error("Authentication failed");  // Throw an error if authentication fails
         }
 
-        SPHINXHybridKey::HybridKeypair keyPair = SPHINXKey::generate_and_perform_key_exchange();  // Generate and perform a key exchange
-        SPHINXKey::SPHINXPubKey publicKey = SPHINXKey::calculatePublicKey(keyPair.merged_key.kyber_private_key.data());  // Calculate the public key
         SPHINXTrx::Transaction transferTransaction = createTransaction(shard.bridgeAddress, senderAddress, amount);  // Create a transaction to the shard bridge address
         signTransaction(transferTransaction);  // Sign the transaction
         broadcastTransaction(transferTransaction);  // Broadcast the transaction
-        shard.chain.handleShardTransfer(shardName, transferTransaction);  // Handle the shard transfer in the shard chain
+        {
+            std::lock_guard<std::mutex> shardLock(shard.mutex);  // Only this shard is serialized
+            shard.chain.handleShardTransfer(shardName, transferTransaction);  // Handle the shard transfer in the shard chain
+        }
         updateBalance(senderAddress, -amount);  // Update the balance of the sender address
     }
 
     // Handle a shard transfer transaction in the shard chain by updating the balance of the recipient address
     void Chain::handleShardTransfer(const std::string& shardName, const SPHINXTrx::Transaction& transaction) {
-        auto it = shardIndices_.find(shardName);
-        if (it == shardIndices_.end()) {
-            throw std::runtime_error("Shard does not exist: " + shardName);  // Throw an error if the shard does not exist
-        }
-        Shard& shard = shards_[it->second];  // Get the reference to the shard
+        Shard& shard = findShard(shardName);  // Get the reference to the shard
+        std::lock_guard<std::mutex> shardLock(shard.mutex);  // Transfers on other shards run concurrently
         shard.chain.handleTransfer(transaction);  // Handle the transfer in the shard chain
     }
 
     // Handle a shard bridge transaction in the shard chain by updating the balances of the recipient and sender addresses
     void Chain::handleShardBridgeTransaction(const std::string& shardName, const std::string& bridgeAddress, const std::string& recipientAddress, double amount) {
-        auto it = shardIndices_.find(shardName);
-        if (it == shardIndices_.end()) {
-            throw std::runtime_error("Shard does not exist: " + shardName);  // Throw an error if the shard does not exist
-        }
-        Shard& shard = shards_[it->second];  // Get the reference to the shard
+        Shard& shard = findShard(shardName);  // Get the reference to the shard
         if (!shard.bridge.verifyTransaction(bridgeAddress, amount)) {
             // Throw an error if the bridge transaction is invalid
             throw std::runtime_error("Invalid bridge transaction");
@@ -666,29 +2365,17 @@ public:
             throw std::runtime_error("Authentication failed");  // Throw an error if authentication fails
         }
 
-        SPHINXHybridKey::HybridKeypair keyPair = SPHINXKey::generate_and_perform_key_exchange();  // Generate and perform a key exchange
-        SPHINXKey::SPHINXPubKey publicKey = SPHINXKey::calculatePublicKey(keyPair.merged_key.kyber_private_key.data());  // Calculate the public key
-        std::string transactionData = shard.bridge.getTransactionData(bridgeAddress);  // Get the transaction data from the shard bridge
-        std::string signature = SPHINXSign::sign(transactionData, keyPair.merged_key.kyber_private_key.data());  // Sign the transaction data
-
-        if (!SPHINXVerify::verifySignature(transactionData, signature, publicKey)) {
-            throw std::runtime_error("Authentication failed");  // Throw an error if authentication fails
-        }
-
+        std::string transactionData = shard.bridge.getTransactionData(bridgeAddress);  // Get the transaction data from the shard bridge, checked by verifyTransaction above
         std::string transactionHash = SPHINXHash::SPHINX_256(transactionData);
+        std::lock_guard<std::mutex> shardLock(shard.mutex);  // The bridge calls above run unlocked
         shard.chain.updateBalance(recipientAddress, amount);  // Update the balance of the recipient address in the shard chain
         shard.chain.updateBalance(senderAddress, -amount);  // Update the balance of the sender address in the shard chain
     }
 
     // Perform an atomic swap between the current shard and the target shard
-    void Chain::performShardAtomicSwap(const std::string& shardName, const Chain& targetShard, const std::string& senderAddress, const std::string& receiverAddress, double amount) {
-        auto it = shardIndices_.find(shardName);
-        if (it == shardIndices_.end()) {
-            throw std::runtime_error("Shard does not exist: " + shardName);  // Throw an error if the shard does not exist
-        }
-        Shard& shard = shards_[it->second];  // Get the reference to the shard
+    std::shared_future<SPHINXSwap::SwapState> Chain::performShardAtomicSwap(const std::string& shardName, const Chain& targetShard, const std::string& senderAddress, const std::string& receiverAddress, double amount) {
+        Shard& shard = findShard(shardName);  // Get the reference to the shard
         double senderBalance = getBalance(senderAddress);
-        double receiverBalance = targetShard.getBalance(receiverAddress);
         if (senderBalance < amount) {
             throw std::runtime_error("Sender does not have enough funds");  // Throw an error if the sender does not have enough funds
         }
@@ -697,49 +2384,214 @@ public:
             throw std::runtime_error("Authentication failed");  // Throw an error if authentication fails
         }
 
-        SPHINXTrx::Transaction senderTransaction = createTransaction(senderAddress, shard.bridgeAddress, amount);  // Create a transaction from the sender to the shard bridge
-        SPHINXTrx::Transaction receiverTransaction = targetShard.createTransaction(receiverAddress, senderAddress, amount);  // Create a transaction from the shard bridge to the receiver
-
-        signTransaction(senderTransaction);  // Sign the sender transaction
-        signTransaction(receiverTransaction);  // Sign the receiver transaction
-        broadcastTransaction(senderTransaction);  // Broadcast the sender transaction
-        targetShard.broadcastTransaction(receiverTransaction);  // Broadcast the receiver transaction
-
-        while (true) {
-            if (senderTransaction.isConfirmed() && receiverTransaction.isConfirmed()) {
-                break;  // Wait until both transactions are confirmed
+        auto senderTransaction = std::make_shared<SPHINXTrx::Transaction>(createTransaction(senderAddress, shard.bridgeAddress, amount));  // Create a transaction from the sender to the shard bridge
+        auto receiverTransaction = std::make_shared<SPHINXTrx::Transaction>(targetShard.createTransaction(receiverAddress, senderAddress, amount));  // Create a transaction from the shard bridge to the receiver
+
+        signTransaction(*senderTransaction);  // Sign the sender transaction
+        signTransaction(*receiverTransaction);  // Sign the receiver transaction
+
+        SPHINXSwap::SwapRecord record;
+        record.senderAddress = senderAddress;
+        record.receiverAddress = receiverAddress;
+        record.amount = SPHINXLedger::toAmount(amount);
+        record.senderTransactionId = transactionId(*senderTransaction);
+        record.receiverTransactionId = transactionId(*receiverTransaction);
+
+        const Chain* target = &targetShard;  // Must outlive the swap
+        Chain* shardChain = shard.chain;  // Copied so the callbacks do not keep the shard entry locked
+        SPHINXSwap::SwapCallbacks callbacks;
+        callbacks.broadcast = [this, target, senderTransaction, receiverTransaction](const SPHINXSwap::SwapRecord&) {
+            broadcastTransaction(*senderTransaction);  // Broadcast the sender transaction
+            target->broadcastTransaction(*receiverTransaction);  // Broadcast the receiver transaction
+        };
+        callbacks.senderConfirmed = [senderTransaction] { return senderTransaction->isConfirmed(); };
+        callbacks.receiverConfirmed = [receiverTransaction] { return receiverTransaction->isConfirmed(); };
+        callbacks.settle = [this, target, shardChain, senderTransaction, receiverTransaction](const SPHINXSwap::SwapRecord& swap) {
+            if (!verifyAtomicSwap(*senderTransaction, *shardChain) || !target->verifyAtomicSwap(*receiverTransaction, *shardChain)) {
+                throw std::runtime_error("Atomic swap verification failed");  // The engine refunds the swap
             }
-            std::this_thread::sleep_for(std::chrono::seconds(10));  // Sleep for 10 seconds before checking confirmation status again
-        }
-
-        if (!verifyAtomicSwap(senderTransaction, shard.chain) || !targetShard.verifyAtomicSwap(receiverTransaction, shard.chain)) {
-            throw std::runtime_error("Atomic swap verification failed");  // Throw an error if atomic swap verification fails
-        }
-
-        updateBalance(senderAddress, -amount);  // Update the balance of the sender address
-        targetShard.updateBalance(receiverAddress, amount);  // Update the balance of the receiver address in the target shard
+            applyDelta(swap.senderAddress, -swap.amount, true);  // Re-checked and debited under the write lock
+            try {
+                target->updateBalance(swap.receiverAddress, SPHINXLedger::toDouble(swap.amount));  // Update the balance of the receiver address in the target shard
+            } catch (...) {
+                applyDelta(swap.senderAddress, swap.amount, false);  // Credit the debit back as a delta, keeping what other writers changed meanwhile
+                throw;
+            }
+        };
+        return swapEngine().start(std::move(record), std::move(callbacks));
     }
 
     // Update the balance of a given address in the specified shard by adding the specified amount
     void Chain::updateShardBalance(const std::string& shardName, const std::string& address, double amount) {
-        auto it = shardIndices_.find(shardName);
-        if (it == shardIndices_.end()) {
-            throw std::runtime_error("Shard does not exist: " + shardName);  // Throw an error if the shard does not exist
-        }
-        Shard& shard = shards_[it->second];  // Get the reference to the shard
-        shard.balances[address] += amount;  // Update the balance of the given address in the shard
+        Shard& shard = findShard(shardName);  // Get the reference to the shard
+        const SPHINXLedger::Amount units = SPHINXLedger::toAmount(amount);
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+        const SPHINXLedger::AddressId id = shard.balances.intern(address);
+        shard.undo.save(shard.balances, id, nextHeight());  // Previous balance, for rollbackTo
+        shard.balances.add(id, units);  // Update the balance of the given address in the shard
     }
 
     // Get the balance of a given address in the specified shard
     double Chain::getShardBalance(const std::string& shardName, const std::string& address) const {
+        const Shard& shard = findShard(shardName);  // Get the reference to the shard
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+        return SPHINXLedger::toDouble(shard.balances.balance(address));  // Unknown addresses have a zero balance in the shard
+    }
+
+    // Find a shard by name; shards are never removed and live behind unique_ptr, so the reference stays valid
+    const Chain::Shard& Chain::findShard(const std::string& shardName) const {
+        std::shared_lock<std::shared_mutex> lock(*shardsMutex_);
         auto it = shardIndices_.find(shardName);
         if (it == shardIndices_.end()) {
             throw std::runtime_error("Shard does not exist: " + shardName);  // Throw an error if the shard does not exist
         }
-        const Shard& shard = shards_[it->second];  // Get the reference to the shard
-        if (shard.balances.count(address) > 0) {
-            return shard.balances.at(address);  // Return the balance of the given address in the shard if it exists
+        return *shards_[it->second];
+    }
+
+    Chain::Shard& Chain::findShard(const std::string& shardName) {
+        return const_cast<Shard&>(std::as_const(*this).findShard(shardName));  // The chain is not const, neither is its shard
+    }
+
+    // Move funds between two shards under both shard locks, so the debit and the credit are seen together
+    void Chain::transferBetweenShards(const std::string& fromShard, const std::string& toShard, const std::string& senderAddress, const std::string& recipientAddress, double amount) {
+        if (!(amount > 0.0)) {
+            throw std::invalid_argument("Cross-shard transfer amount must be positive");
+        }
+        const SPHINXLedger::Amount units = SPHINXLedger::toAmount(amount);
+        Shard& source = findShard(fromShard);
+        Shard& destination = findShard(toShard);
+
+        // Lock the shards in address order, as snapshot() does, so opposite transfers cannot deadlock
+        const bool sourceFirst = std::less<const Shard*>()(&source, &destination);
+        std::unique_lock<std::mutex> firstLock(sourceFirst ? source.mutex : destination.mutex);
+        std::unique_lock<std::mutex> secondLock;
+        if (&source != &destination) {
+            secondLock = std::unique_lock<std::mutex>(sourceFirst ? destination.mutex : source.mutex);
+        }
+
+        if (source.balances.balance(senderAddress) < units) {
+            throw std::runtime_error("Sender does not have enough funds in shard: " + fromShard);
+        }
+        if (&source == &destination) {
+            if (senderAddress != recipientAddress) {
+                const SPHINXLedger::BalanceDelta deltas[] = {{senderAddress, -units}, {recipientAddress, units}};
+                source.undo.save(source.balances, deltas, nextHeight());
+                source.balances.applyBatch(deltas);
+            }
+            return;
+        }
+
+        // Prepare: everything that can fail before a balance changes
+        const SPHINXLedger::AddressId sender = source.balances.intern(senderAddress);
+        const SPHINXLedger::AddressId recipient = destination.balances.intern(recipientAddress);
+        source.undo.save(source.balances, sender, nextHeight());
+        destination.undo.save(destination.balances, recipient, nextHeight());
+
+        // Commit: debit, then credit. Nobody can look at either shard in between, so an overflowing credit only has to
+        // give the debit back before the locks go
+        source.balances.add(sender, -units);
+        try {
+            destination.balances.add(recipient, units);
+        } catch (...) {
+            source.balances.add(sender, units);
+            throw;
+        }
+    }
+
+    // Apply per-shard transfer batches, running batches of different shards in parallel
+    std::vector<std::string> Chain::executeShardBatches(std::span<const ShardBatch> batches) {
+        std::vector<std::string> failures(batches.size());
+        SPHINXPool::ThreadPool::shared().parallelFor(0, batches.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                try {
+                    Shard& shard = findShard(batches[i].shardName);
+                    std::vector<std::string> recipients;
+                    std::vector<SPHINXLedger::BalanceDelta> deltas;
+                    coalesceTransfers(batches[i].transactions, recipients, deltas);  // Validate and coalesce before locking
+                    std::lock_guard<std::mutex> shardLock(shard.mutex);
+                    shard.undo.save(shard.balances, deltas, nextHeight());
+                    shard.balances.applyBatch(deltas);
+                } catch (const std::exception& e) {
+                    failures[i] = e.what();  // The batch was not applied; other batches are unaffected
+                }
+            }
+        });
+        return failures;
+    }
+
+    // Get the shard an address belongs to
+    size_t SPHINXChain::Sharding::shardForAddress(const std::string& address, size_t shardCount) {
+        return ringFor(shardCount).shardFor(address);  // The ring is built on the first call for a shard count only
+    }
+
+    // Split the account state of a chain into shards on a consistent-hash ring
+    std::vector<SPHINXChain> SPHINXChain::Sharding::shardBlockchain(const SPHINXChain& chain, size_t shardCount, ShardingReport* report) {
+        if (shardCount == 0) {
+            throw std::invalid_argument("Shard count must be positive");
+        }
+        const auto started = std::chrono::steady_clock::now();
+        const SPHINXShard::HashRing& ring = ringFor(shardCount);
+        const SPHINXLedger::Ledger& source = chain.balances_;
+        const size_t accountCount = source.accountCount();
+        const size_t chunkCount = (accountCount + PARTITION_GRAIN - 1) / PARTITION_GRAIN;
+        SPHINXPool::ThreadPool& pool = SPHINXPool::ThreadPool::shared();
+
+        // Pass 1: hash every account onto the ring; each chunk fills its own buckets, so no task waits on another
+        std::vector<std::vector<std::vector<SPHINXLedger::AddressId>>> buckets(chunkCount, std::vector<std::vector<SPHINXLedger::AddressId>>(shardCount));
+        pool.parallelFor(0, chunkCount, 1, [&](size_t firstChunk, size_t lastChunk) {
+            for (size_t chunk = firstChunk; chunk < lastChunk; ++chunk) {
+                const size_t last = std::min(accountCount, (chunk + 1) * PARTITION_GRAIN);
+                for (size_t id = chunk * PARTITION_GRAIN; id < last; ++id) {
+                    const auto accountId = static_cast<SPHINXLedger::AddressId>(id);
+                    buckets[chunk][ring.shardFor(source.address(accountId))].push_back(accountId);
+                }
+            }
+        });
+
+        std::vector<SPHINXChain> shards;
+        shards.reserve(shardCount);
+        for (size_t i = 0; i < shardCount; ++i) {
+            shards.emplace_back(MainParams{});
+        }
+
+        // Pass 2: build every shard in parallel, merging the chunk buckets in chunk order so the result is deterministic
+        std::vector<ShardLoad> loads(shardCount);
+        pool.parallelFor(0, shardCount, 1, [&](size_t firstShard, size_t lastShard) {
+            for (size_t index = firstShard; index < lastShard; ++index) {
+                SPHINXChain& shard = shards[index];
+                shard.attachBlockSource(chain.blockSource_);  // Shared block file, nothing is copied
+                shard.blocks_ = SPHINXView::BlockList(chain.blocks_.snapshot());  // Blocks held in memory, shared segment by segment
+                shard.rebuildBlockIndex();
+                for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+                    for (SPHINXLedger::AddressId id : buckets[chunk][index]) {
+                        const SPHINXLedger::Amount amount = source.balance(id);
+                        shard.balances_.add(source.address(id), amount);
+                        loads[index].accounts += 1;
+                        if (__builtin_add_overflow(loads[index].balance, amount, &loads[index].balance)) {
+                            loads[index].balance = std::numeric_limits<SPHINXLedger::Amount>::max();  // Only the report saturates
+                        }
+                    }
+                }
+                shard.undo_.reset(shard.nextHeight());  // The history of a shard starts with its partition
+                shard.balancesChanged_ = true;
+                shard.publishView();
+            }
+        });
+
+        if (report != nullptr) {
+            size_t maxAccounts = 0;
+            long double totalBalance = 0;
+            long double maxBalance = 0;
+            for (const ShardLoad& load : loads) {
+                maxAccounts = std::max(maxAccounts, load.accounts);
+                totalBalance += load.balance;
+                maxBalance = std::max<long double>(maxBalance, load.balance);
+            }
+            report->shards = loads;
+            report->accountSkew = accountCount == 0 ? 1.0 : static_cast<double>(maxAccounts) * shardCount / accountCount;
+            report->balanceSkew = totalBalance <= 0 ? 1.0 : static_cast<double>(maxBalance * shardCount / totalBalance);
+            report->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
         }
-        return 0.0;  // Return 0.0 if the address balance is not found in the shard
+        return shards;
     }
 } // namespace SPHINXChain
@@ -19,9 +19,23 @@
 
 #include <stdexcept>
 #include <fstream>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <future>
 #include <iostream>
+#include <limits>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "Params.hpp"
@@ -34,6 +48,26 @@
 #include "Transaction.hpp"
 #include "Consensus/Contract.hpp"
 #include "PoW.hpp"
+#include "BlockStore.hpp"
+#include "Journal.hpp"
+#include "ColdStore.hpp"
+#include "Archive.hpp"
+#include "JsonImport.hpp"
+#include "JsonExport.hpp"
+#include "BlockIndex.hpp"
+#include "Ledger.hpp"
+#include "UndoLog.hpp"
+#include "ChainView.hpp"
+#include "Snapshot.hpp"
+#include "AtomicSwap.hpp"
+#include "Broadcast.hpp"
+#include "Mempool.hpp"
+#include "BlockTemplate.hpp"
+#include "BlockTree.hpp"
+#include "ShardRing.hpp"
+#include "KeyManager.hpp"
+#include "SignatureBatch.hpp"
+#include "SignatureCache.hpp"
 
 using json = nlohmann::json;
 
@@ -61,49 +95,179 @@ public:
     // Constructor to create a new chain instance with provided MainParams.
     explicit SPHINXChain(const MainParams& mainParams);
 
-    // Add a new block to the chain.
-    void addBlock(const SPHINXBlock::Block& block) {
-        // Add block to the blockchain
-        // Calculate the hash of the block's data
-        std::string blockHash = block.calculateBlockHash();
+    // Add a new block to the chain and apply its transfers to the balances; throws if they overdraw an address. With forks
+    // enabled the block goes through acceptBlock and may end up on a side branch.
+    void addBlock(const SPHINXBlock::Block& block);
 
-        // Sign the block's hash using the private key (Note: you need to define privateKey and transactionData somewhere)
-        std::string signature = SPHINXVerify::sign_data(std::vector<uint8_t>(transactionData.begin(), transactionData.end()), privateKey);
+    // Get the hash of a block at a specific block height. It is a view (valid while the block is part of the chain) when
+    // Block::getBlockHash returns a reference, and a copy otherwise (SPHINXView::BlockHash).
+    SPHINXView::BlockHash getBlockHash(uint32_t blockHeight) const;
 
-        // Add the block and its signature to the chain
-        blocks_.emplace_back(block, signature);
-    }
+    // Constant for block not found
+    static constexpr uint32_t BLOCK_NOT_FOUND = SPHINXIndex::BlockIndex::NOT_FOUND;
 
-    // Get the hash of a block at a specific block height.
-    std::string getBlockHash(uint32_t blockHeight) const;
+    // Get the height of the block with the given hash in O(1), or BLOCK_NOT_FOUND.
+    uint32_t findBlockByHash(const std::string& blockHash) const;
 
     // Transfer tokens from the sidechain to the main chain using a block hash.
     void transferFromSidechain(const SPHINXChain::Chain& sidechain, const std::string& blockHash);
 
-    // Handle a bridge transaction for cross-chain communication.
+    // Handle a bridge transaction for cross-chain communication. The payload is one transaction as JSON text, or a batch
+    // sent by a broadcaster (SPHINXBroadcast::isBatch), which is decoded and added only if every transaction in it is valid.
     void handleBridgeTransaction(const std::string& bridge, const std::string& targetChain, const std::string& transaction);
 
     // Convert the chain data to a JSON format.
     nlohmann::json toJson() const;
 
-    // Load chain data from a JSON object.
+    // Load chain data from a JSON object. The block list is replaced under the write lock, then one view is published.
     void fromJson(const nlohmann::json& chainJson);
 
-    // Save chain data to a file with the given filename.
+    // Load chain data from JSON text without building a DOM for the whole document. Blocks are decoded in parallel
+    // chunks, or with options.lazy kept as undecoded text and decoded on first access. Like fromJson, the block list is
+    // replaced under the write lock; only the scan of the text runs outside it.
+    void fromJsonText(std::string text, SPHINXStore::JsonImportOptions options = {});
+
+    // Import a chain exported with exportJson.
+    static Chain importJson(const std::string& filename, SPHINXStore::JsonImportOptions options = {});
+
+    // Save chain data to a binary block file with the given filename.
     bool save(const std::string& filename) const;
 
-    // Load chain data from a file with the given filename.
+    // Load chain data from a binary block file with the given filename. Every block is decoded once to replay its
+    // transfers into the balances; after that blocks are decoded lazily.
     static Chain load(const std::string& filename);
 
+    // Save chain data to a compressed block archive: blocks are grouped into independently compressed frames with a
+    // frame index (Archive.hpp), so reading one block later decompresses one frame.
+    bool saveArchive(const std::string& filename, SPHINXStore::ArchiveOptions options = {}) const;
+
+    // Load chain data from a block archive. Every frame is decompressed once to replay the transfers into the balances;
+    // after that blocks are decoded lazily one frame at a time.
+    static Chain loadArchive(const std::string& filename);
+
+    // Export chain data to a JSON file with the given filename. Blocks are written one at a time (no DOM of the whole
+    // chain); options select compact output and a range of heights [from, to).
+    bool exportJson(const std::string& filename, SPHINXStore::JsonExportOptions options = {}) const;
+
+    // Stream chain data as JSON to an output stream; throws std::runtime_error if writing fails.
+    void writeJson(std::ostream& out, SPHINXStore::JsonExportOptions options = {}) const;
+
+    // Stream chain data as JSON to an open file descriptor (file, pipe or socket); the descriptor is not closed.
+    void writeJson(int fd, SPHINXStore::JsonExportOptions options = {}) const;
+
+    // Attach an append-only journal; every block added afterwards is appended to it with a checksum.
+    void openJournal(const std::string& filename, SPHINXStore::JournalOptions options = {});
+
+    // Make every block appended to the journal durable now.
+    void flushJournal();
+
     // Get the genesis block of the chain.
-    SPHINXBlock::Block getGenesisBlock() const;
+    std::shared_ptr<const SPHINXBlock::Block> getGenesisBlock() const;
+
+    // Get the block at the specified index. The block is shared, not copied, and the pointer keeps it alive whatever the
+    // chain does afterwards: pruning, rollbacks and the eviction of cold blocks from the decoded cache.
+    std::shared_ptr<const SPHINXBlock::Block> getBlockAt(size_t index) const;
+
+    // Keep only the most recent options.hotBlocks blocks decoded in memory. Older bodies are compressed into a cold
+    // scratch file (ColdStore.hpp), hashes stay in memory, and getBlockAt pages cold blocks back in through an LRU of
+    // options.cacheBlocks blocks.
+    void enablePruning(SPHINXStore::PruneOptions options);
+
+    // Hold competing branches instead of only appending. addBlock then accepts any block whose parent is known, keeps the
+    // branch with the most work as the chain (reorganizing when another branch overtakes it) and parks blocks with an
+    // unknown parent in a bounded orphan pool. Blocks move balances by their transfers (BlockTree.hpp); a reorg puts back
+    // the balances saved at the fork point (UndoLog.hpp) and applies the new branch's deltas. The tree starts at the current
+    // tip. A journaled chain cannot be fork-aware, because the journal is append-only.
+    void enableForks(SPHINXTree::ForkOptions options = {});
+
+    // Offer a block to a fork-aware chain and report what became of it. Throws std::runtime_error if forks are not
+    // enabled or the block is invalid: a bad signature, or transfers that overdraw a sender when it is connected.
+    SPHINXTree::AcceptResult acceptBlock(const SPHINXBlock::Block& block);
+
+    // Tree, orphan and reorg counters (all zero while forks are disabled).
+    SPHINXTree::ForkStats forkStats() const;
+
+    // Roll the chain back so the block at height is the tip. The later blocks are removed and the chain and shard
+    // balances are put back as they were when that block was added, from per-block undo records (UndoLog.hpp), so the
+    // cost is the accounts changed since then rather than a replay of the chain. Throws std::out_of_range past the tip and
+    // std::runtime_error when the undo records or the in-memory blocks do not reach back that far (see setUndoDepth and
+    // enablePruning) or the chain is journaled, because the journal is append-only.
+    void rollbackTo(uint32_t height);
+
+    // Set how many recent blocks keep undo records (SPHINXLedger::UNDO_DEPTH by default); a fork-aware chain keeps at
+    // least its reorg window.
+    void setUndoDepth(size_t blocks);
+
+    // Forward iterator over the blocks of a chain; dereferencing yields a const reference, never a copy. The iterator
+    // holds the block it points at, so the reference stays valid until the iterator moves on.
+    class BlockIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = SPHINXBlock::Block;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const SPHINXBlock::Block*;
+        using reference = const SPHINXBlock::Block&;
+
+        BlockIterator() = default;
+        BlockIterator(const Chain* chain, size_t height) : chain_(chain), height_(height) {}
+
+        reference operator*() const { return *held(); }
+        pointer operator->() const { return held().get(); }
+        BlockIterator& operator++() { ++height_; block_.reset(); return *this; }
+        BlockIterator operator++(int) { BlockIterator previous = *this; ++*this; return previous; }
+        bool operator==(const BlockIterator& other) const { return height_ == other.height_; }
+        bool operator!=(const BlockIterator& other) const { return height_ != other.height_; }
+
+        // Height of the block the iterator points at.
+        size_t height() const { return height_; }
+
+    private:
+        const std::shared_ptr<const SPHINXBlock::Block>& held() const {
+            if (!block_) {
+                block_ = chain_->blockPtr(height_);
+            }
+            return block_;
+        }
+
+        const Chain* chain_ = nullptr;
+        size_t height_ = 0;
+        mutable std::shared_ptr<const SPHINXBlock::Block> block_;  // Block at height_, loaded on first dereference
+    };
+
+    // Half-open range of blocks [from, to) for range-based for loops.
+    class BlockRange {
+    public:
+        BlockRange(const Chain* chain, size_t from, size_t to) : chain_(chain), from_(from), to_(to) {}
+
+        BlockIterator begin() const { return BlockIterator(chain_, from_); }
+        BlockIterator end() const { return BlockIterator(chain_, to_); }
+        size_t size() const { return to_ - from_; }
+        bool empty() const { return from_ == to_; }
+
+    private:
+        const Chain* chain_;
+        size_t from_;
+        size_t to_;
+    };
 
-    // Get the block at the specified index.
-    SPHINXBlock::Block getBlockAt(size_t index) const;
+    // Get the blocks with heights in [from, to) as a range of const references.
+    BlockRange blocks(size_t from, size_t to) const;
+
+    // Get every block of the chain as a range of const references.
+    BlockRange blocks() const;
 
     // Get the length of the chain (number of blocks).
     size_t getChainLength() const;
 
+    // Get the current read view: the blocks up to the tip and the balances as of the last block or transfer batch.
+    // Any thread may call this while one writer adds blocks and applies balances. It takes none of the chain's locks,
+    // and the view stays consistent and valid for as long as the caller holds it, whatever the writer does meanwhile.
+    std::shared_ptr<const SPHINXView::ChainView> view() const;
+
+    // Publish a new read view now. addBlock, applyTransfers, restoreSnapshot and the loaders publish on their own;
+    // updateBalance does not, so call this to make single balance updates visible to readers before the next block.
+    void publishView();
+
     // Visualize the chain, printing its details to the console.
     void visualizeChain() const;
 
@@ -119,14 +283,71 @@ public:
     // Handle a bridge transaction between this chain and the target chain.
     void handleBridgeTransaction(const std::string& bridgeAddress, const std::string& recipientAddress, double amount);
 
-    // Perform an atomic swap between this chain and the target chain.
-    void performAtomicSwap(const Chain& targetChain, const std::string& senderAddress, const std::string& receiverAddress, double amount);
+    // Perform an atomic swap between this chain and the target chain. Returns immediately; the future resolves with
+    // Settled or Refunded. Both chains must stay alive until it is ready.
+    std::shared_future<SPHINXSwap::SwapState> performAtomicSwap(const Chain& targetChain, const std::string& senderAddress, const std::string& receiverAddress, double amount);
+
+    // Persist atomic swaps to a journal and resume the ones that were in flight.
+    void openSwapStore(const std::string& filename);
+
+    // Use the signing key stored in filename, generating and storing one if the file does not exist yet.
+    void openKeyStore(const std::string& filename);
+
+    // Get the key manager that signs for this chain (its counters give signatures/sec).
+    SPHINXKeys::KeyManager& keyManager() { return *keyManager_; }
+
+    // Report a confirmed transaction; returns false if no atomic swap waits for it.
+    bool onTransactionConfirmed(const std::string& transactionId);
 
     // Sign a transaction before broadcasting it.
     void signTransaction(SPHINXTrx::Transaction& transaction);
 
-    // Broadcast a signed transaction to the network.
-    void broadcastTransaction(const SPHINXTrx::Transaction& transaction);
+    // Broadcast a signed transaction to the network. The transaction is admitted to the mempool (see submitTransaction) and
+    // queued for the background broadcaster (Broadcast.hpp), which sends it with others in one binary batch; the call
+    // returns in microseconds. A transaction that is already pending is not sent again; one the mempool rejects throws
+    // std::runtime_error.
+    void broadcastTransaction(const SPHINXTrx::Transaction& transaction, double fee = 0.0, std::optional<uint64_t> nonce = std::nullopt);
+
+    // Admit a transaction to the mempool without broadcasting it. The nonce orders the sender's transactions and defaults
+    // to the one after the sender's last pending transaction, taken atomically with admission; the amounts and fees of a sender's pending transactions may
+    // not exceed its balance.
+    SPHINXTxPool::AddResult submitTransaction(const SPHINXTrx::Transaction& transaction, double fee = 0.0, std::optional<uint64_t> nonce = std::nullopt);
+
+    // Pick pending transactions for the next block by fee rate, each sender's in nonce order, up to maxBytes of encoded
+    // transactions; 0 or anything above the transaction budget of a block means the whole budget (see buildBlockTemplate).
+    std::vector<SPHINXTrx::Transaction> selectForBlock(size_t maxBytes = 0) const;
+
+    // Remove transactions that went into a block from the mempool; returns the number removed.
+    size_t removeFromMempool(std::span<const SPHINXTrx::Transaction> transactions);
+
+    // Evict pending transactions that their senders can no longer pay for after balances went down; returns the number evicted.
+    size_t pruneMempool();
+
+    // Size and admission counters of the mempool.
+    SPHINXTxPool::PoolStats mempoolStats() const;
+
+    // Assemble the next block on top of the tip from the mempool, up to maxBytes of transactions (0 or anything above
+    // the budget means the whole budget). The budget is MainParams::getMaxBlockSize() minus the block overhead: the header,
+    // previous hash and Merkle root, and room for the signature (SPHINXTemplate::blockOverhead). The block carries its transactions and Merkle root and
+    // is ready to be signed and passed to addBlock; the pool is left unchanged until removeFromMempool.
+    SPHINXTemplate::BlockTemplate buildBlockTemplate(size_t maxBytes = 0) const;
+
+    // Assemble the next block from the given candidates instead of the mempool, packed greedily by fee density.
+    SPHINXTemplate::BlockTemplate buildBlockTemplate(std::span<const SPHINXTxPool::PoolEntry> candidates, size_t maxBytes = 0) const;
+
+    // Maximum encoded size of a block, header and signature included, from MainParams. addBlock and acceptBlock reject
+    // larger blocks.
+    size_t getMaxBlockSize() const { return maxBlockSize_; }
+
+    // Send broadcast batches to the given sink instead of the bridge (for example a SPHINXBroadcast::LoopbackBridge) and/or
+    // with other batching options. Call before broadcasting; a previous broadcaster sends what it still holds first.
+    void openBroadcast(SPHINXBroadcast::BatchSink sink, SPHINXBroadcast::BroadcastOptions options = {});
+
+    // Wait until every transaction broadcast so far has been handed to the bridge.
+    void flushBroadcasts();
+
+    // Queue depth, batching and backpressure counters of the broadcaster (all zero before the first broadcast).
+    SPHINXBroadcast::BroadcastMetrics broadcastMetrics() const;
 
     // Update the balance of an address with the specified amount.
     void updateBalance(const std::string& address, double amount);
@@ -137,9 +358,40 @@ public:
     // Verify an atomic swap transaction with the target chain.
     bool verifyAtomicSwap(const SPHINXTrx::Transaction& transaction, const Chain& targetChain) const;
 
-    // Handle a transfer transaction.
+    // Verify an atomic swap against the committed state of a remote chain instead of a local Chain object: the
+    // signature must be valid and the proof must show, under stateRoot, that the transaction's sender holds the amount.
+    // The proof is only as good as the root: stateRoot must come from a trusted source, such as a validated header of
+    // the remote chain, never from the party presenting the proof.
+    bool verifyAtomicSwap(const SPHINXTrx::Transaction& transaction, const std::string& stateRoot, const SPHINXLedger::StateProof& senderProof) const;
+
+    // Root of the sparse Merkle commitment over the chain balances (64 hex characters).
+    std::string stateRoot() const;
+
+    // Proof of the balance of an address against stateRoot(), so another chain can check it without querying this one.
+    SPHINXLedger::StateProof proveBalance(const std::string& address) const;
+
+    // Root of the commitment over the balances of a shard.
+    std::string shardStateRoot(const std::string& shardName) const;
+
+    // Proof of the balance of an address in a shard against shardStateRoot(shardName).
+    SPHINXLedger::StateProof proveShardBalance(const std::string& shardName, const std::string& address) const;
+
+    // Check a balance proof against a state root; returns the proven balance (0 for a proven absent address), or nothing if the proof does not match.
+    static std::optional<double> verifyBalanceProof(const std::string& stateRoot, const std::string& address, const SPHINXLedger::StateProof& proof);
+
+    // Verify the bridge signatures of many transactions in one call: repeated sender keys are parsed once and the
+    // checks run on the thread pool. Returns one entry per transaction, 1 when its signature is valid.
+    std::vector<uint8_t> verifyBridgeSignatures(std::span<const SPHINXTrx::Transaction> transactions) const;
+
+    // Handle a transfer transaction as a batch of one (applyTransfers), which publishes one view. Throws
+    // std::invalid_argument if the amount is not positive or the recipient is empty.
     void handleTransfer(const SPHINXTrx::Transaction& transaction);
 
+    // Apply a batch of transfer transactions all-or-nothing: the batch is validated first, updates are coalesced per recipient,
+    // and either every transfer is applied or none is. Only the recipients are credited; the senders were debited on the
+    // sending chain. Transfers inside blocks move both sides. One view is published per batch, however large.
+    void applyTransfers(std::span<const SPHINXTrx::Transaction> transactions);
+
     // Get the address of the bridge.
     std::string getBridgeAddress() const;
 
@@ -162,7 +414,7 @@ public:
     void handleShardBridgeTransaction(const std::string& shardName, const std::string& bridgeAddress, const std::string& recipientAddress, double amount);
 
     // Perform an atomic swap with a shard.
-    void performShardAtomicSwap(const std::string& shardName, const Chain& targetShard, const std::string& senderAddress, const std::string& receiverAddress, double amount);
+    std::shared_future<SPHINXSwap::SwapState> performShardAtomicSwap(const std::string& shardName, const Chain& targetShard, const std::string& senderAddress, const std::string& receiverAddress, double amount);
 
     // Update the balance of an address in a shard.
     void updateShardBalance(const std::string& shardName, const std::string& address, double amount);
@@ -170,126 +422,271 @@ public:
     // Get the balance of an address in a shard.
     double getShardBalance(const std::string& shardName, const std::string& address) const;
 
+    // Move funds from an address in one shard to an address in another. Only the two shard locks are held, taken in
+    // address order: the funds are checked and the undo records saved first, then the sender is debited and the
+    // recipient credited, so a snapshot never sees one without the other. Nothing of it survives a crash, like the shard balances.
+    void transferBetweenShards(const std::string& fromShard, const std::string& toShard, const std::string& senderAddress, const std::string& recipientAddress, double amount);
+
+    // Transfers to apply to one shard's balances.
+    struct ShardBatch {
+        std::string shardName;
+        std::vector<SPHINXTrx::Transaction> transactions;
+    };
+
+    // Apply shard batches in parallel; batches of different shards never wait on each other. Each batch is applied
+    // all-or-nothing; the result holds one entry per batch, empty on success or the reason the batch was rejected.
+    std::vector<std::string> executeShardBatches(std::span<const ShardBatch> batches);
+
     // Check if the chain is valid.
     bool isChainValid() const;
 
+    // Result of a full-chain validation run.
+    struct ValidationReport {
+        bool valid = true;  // True when every block passed
+        uint32_t firstInvalidHeight = std::numeric_limits<uint32_t>::max();  // BLOCK_NOT_FOUND when the chain is valid
+        size_t blocksChecked = 0;  // Number of validated blocks below the first invalid height
+        double elapsedSeconds = 0.0;  // Wall-clock time of the run
+
+        // Validation throughput in blocks per second.
+        double blocksPerSecond() const {
+            return elapsedSeconds > 0.0 ? static_cast<double>(blocksChecked) / elapsedSeconds : 0.0;
+        }
+    };
+
+    // Validate the chain in parallel and report the first invalid height and the throughput. Blocks below fromHeight
+    // are trusted (a snapshot or checkpoint covers them); the block at fromHeight is linked to the stored hash of its parent.
+    ValidationReport validateChain(size_t fromHeight = 0) const;
+
+    // Capture the account state (chain and shard balances) at the current tip, with its commitment.
+    SPHINXStore::StateSnapshot snapshot() const;
+
+    // Write a snapshot of the current state to a file and return its commitment.
+    std::string saveSnapshot(const std::string& filename) const;
+
+    // Replace the account state with a snapshot; throws std::runtime_error if its tip is not the block of this chain at that height.
+    void restoreSnapshot(const SPHINXStore::StateSnapshot& snapshot);
+
+    // Write a snapshot to options.directory whenever addBlock makes the chain length a multiple of options.interval.
+    // A snapshot that cannot be written does not fail addBlock; it is counted in snapshotStats.
+    void enableSnapshots(SPHINXStore::SnapshotOptions options);
+
+    // Counters of the periodic snapshots, with the latest write error.
+    SPHINXStore::SnapshotStats snapshotStats() const;
+
+    // Options of a fast load.
+    struct SyncOptions {
+        std::string snapshotDirectory;  // Restore the state from the newest snapshot here that matches the block file
+        std::string checkpointHash;  // Trusted block hash; the history below it is not validated again
+        std::string snapshotCommitment;  // Trusted commitment of the snapshot to restore, from the same source as checkpointHash
+    };
+
+    // Load a block file, restore the newest matching snapshot and validate only the blocks above the snapshot tip or the
+    // checkpoint, whichever is higher. Throws std::runtime_error if the checkpoint is not in the file or a block is invalid.
+    // The commitment inside a snapshot file only catches damage: with snapshotCommitment set, only the snapshot with that
+    // commitment is restored (none matching means a full validation); without it, the snapshot directory must be trusted.
+    static Chain load(const std::string& filename, const SyncOptions& options, ValidationReport* report = nullptr);
+
     private:
     // Structure to represent a shard with its chain, bridge address, bridge secret, and balances.
     struct Shard {
         SPHINXChain* chain;  // Use a pointer to SPHINXChain.
         std::string bridgeAddress;
         std::string bridgeSecret;
-        std::unordered_map<std::string, double> balances;
+        SPHINXLedger::Ledger balances;  // Fixed-point balances of addresses in the shard
+        SPHINXLedger::UndoLog undo;  // Shard balances before each block of the chain
+        mutable std::mutex mutex;  // Guards chain, balances and undo; several are only ever held together in address order
     };
 
-    std::vector<Shard> shards_;  // Shards in the chain
-    std::vector<SPHINXBlock::Block> blocks_;  // Blocks in the chain
+    std::vector<std::unique_ptr<Shard>> shards_;  // Shards in the chain, stable addresses so a shard can be used without the directory lock
+    std::unique_ptr<std::shared_mutex> shardsMutex_ = std::make_unique<std::shared_mutex>();  // Guards shards_ and shardIndices_
+    SPHINXView::BlockList blocks_;  // Blocks in the chain; segmented, so read views share them instead of copying
     SPHINXHybridKey::HybridKeypair SPHINXKeyPub; // Public key of the chain
-    static constexpr uint32_t BLOCK_NOT_FOUND = std::numeric_limits<uint32_t>::max();  // Constant for block not found
+    static constexpr size_t VALIDATION_GRAIN = 64;  // Blocks per validation task
+    static constexpr size_t IMPORT_GRAIN = 64;  // Blocks per JSON decoding task
     std::unordered_map<std::string, uint32_t> shardIndices_;  // Indices of shards in the chain
 
-    std::unordered_map<std::string, double> balances_;  // Balances of addresses on the chain
+    SPHINXLedger::Ledger balances_;  // Fixed-point balances of addresses on the chain
+    SPHINXLedger::UndoLog undo_;  // Balances before each block's changes, for rollbackTo and reorgs
     std::string bridgeAddress_;  // Address of the bridge
     std::string bridgeSecret_;  // Secret key for the bridge
     // Target chain for atomic swaps
     SPHINXChain* targetChain_;  // Use a pointer to SPHINXChain.
-    Chain::Chain(const SPHINXParams::MainParams& mainParams) : mainParams_(mainParams) {
-        // Create the genesis block with the provided message
-        SPHINXBlock::Block genesisBlock(mainParams_.genesisMessage);
+    std::shared_ptr<const SPHINXStore::BlockSource> blockSource_;  // Blocks [0, blockSource_->size()) live in a block file, blocks_ holds the rest
+    std::unique_ptr<SPHINXStore::BlockJournal> journal_;  // Append-only journal, null when the chain is not journaled
+    SPHINXIndex::BlockIndex blockIndex_;  // Block hash -> height, kept in step with the block list
+    SPHINXStore::SnapshotOptions snapshotOptions_;  // Periodic snapshot policy, disabled while the directory is empty
+    SPHINXStore::SnapshotStats snapshotStats_;  // Written by takePeriodicSnapshot under the write lock
+
+    using ViewSlot = std::atomic<std::shared_ptr<const SPHINXView::ChainView>>;
+    std::unique_ptr<ViewSlot> view_ = std::make_unique<ViewSlot>();  // Current read view, replaced by publishView
+    std::shared_ptr<const SPHINXLedger::Ledger> publishedBalances_;  // Balances of the current view
+    bool balancesChanged_ = true;  // balances_ differ from publishedBalances_
+    uint64_t viewVersion_ = 0;  // Version of the last published view
+    std::unique_ptr<std::recursive_mutex> writeMutex_ = std::make_unique<std::recursive_mutex>();  // Serializes blocks_ and balances_ between the owner and swap settlement on the swap pool
+
+    // Add delta to the balance of an address under the write lock, saving the previous balance for rollbackTo. With
+    // requireFunds, throws instead if the balance would go below zero.
+    void applyDelta(const std::string& address, SPHINXLedger::Amount delta, bool requireFunds);
+
+    // Rebuild blockIndex_ from scratch; block-file hashes are read without decoding the blocks.
+    void rebuildBlockIndex();
+
+    // Append a block that is about to be added to blocks_ to the journal, if there is one.
+    void appendToJournal(const SPHINXBlock::Block& block);
+
+    // Append a verified block to a linear chain. The effect is checked and the block journaled first; the balances, the
+    // hash index and the block list change only once the journal has taken it, so a failed append leaves no trace.
+    void appendBlock(const SPHINXBlock::Block& block);
+
+    // Write a periodic snapshot if snapshots are enabled and the chain length is on the interval. Never throws: the block
+    // is already applied, so a failed write is only recorded in snapshotStats_.
+    void takePeriodicSnapshot();
+
+    // Height of the next block: balance changes are saved in its undo record.
+    uint32_t nextHeight() const { return static_cast<uint32_t>(getChainLength()); }
+
+    // Restart the undo history of the chain and its shards from the current balances.
+    void resetUndo();
+
+    // Recompute the balances from the transfers of the blocks at fromHeight and above, on top of the current balances
+    // (an empty ledger when fromHeight is 0), saving undo records on the way. Every path that replaces the block list
+    // ends here, so the balances, their state tree and the undo history always match the blocks. Throws if a block
+    // overdraws an address.
+    void rebuildState(size_t fromHeight);
+
+    // Open a binary block file and index its blocks without replaying them; the balances are left empty for the
+    // caller to restore or rebuild.
+    static SPHINXChain openBlockFile(const std::string& filename);
+
+    // Number of blocks served by blockSource_.
+    size_t storedBlockCount() const;
+
+    // Get the block at the given height, decoding it into scratch if it is not held in memory.
+    const SPHINXBlock::Block& blockAt(size_t index, SPHINXBlock::Block& scratch) const;
+
+    // Blocks decoded from blockSource_, so repeated reads do not decode again. Callers hold their own pointers, so an
+    // evicted block lives on until they let go. The cache is unbounded unless pruning is enabled; then it is an LRU of
+    // PruneOptions::cacheBlocks blocks.
+    struct DecodedBlocks {
+        std::mutex mutex;
+        size_t capacity = std::numeric_limits<size_t>::max();
+        std::list<size_t> recent;  // Heights of the decoded blocks, most recently used first
+        std::unordered_map<size_t, std::pair<std::shared_ptr<const SPHINXBlock::Block>, std::list<size_t>::iterator>> blocks;  // Height -> block, position in recent
+    };
+    std::unique_ptr<DecodedBlocks> decodedBlocks_;  // Null when there is no block file
 
-        // Add the genesis block to the chain
-        blocks_.push_back(genesisBlock);
-    }
+    // Replace the block list with a block file (or nothing), dropping blocks_ and the decoded cache.
+    void attachBlockSource(std::shared_ptr<const SPHINXStore::BlockSource> source);
 
-    void Chain::addBlock(const SPHINXBlock::Block& block) {
-        // Add block to the blockchain
-        // Calculate the hash of the block's data
-        std::string blockHash = block.calculateBlockHash();
+    // With pruning enabled, move the blocks below the hot window from blocks_ to the cold store.
+    void pruneHotBlocks();
 
-        // Sign the block's hash using the private key (Note: you need to define privateKey and transactionData somewhere)
-        std::string signature = SPHINXVerify::sign_data(std::vector<uint8_t>(transactionData.begin(), transactionData.end()), privateKey);
+    std::shared_ptr<SPHINXStore::ColdBlockStore> coldStore_;  // Cold tier of a pruned chain, null when pruning is off
+    SPHINXStore::PruneOptions pruneOptions_;
 
-        // Add the block and its signature to the chain
-        blocks_.emplace_back(block, signature);
-    }
+    // Fork-aware state: the tree of recent blocks, the blocks held off the best chain and the orphans.
+    struct ForkState {
+        explicit ForkState(SPHINXTree::ForkOptions forkOptions) : options(std::move(forkOptions)), orphans(options.maxOrphans) {}
 
-    bool Chain::isChainValid() const {
-        // Validate the integrity of the blockchain
-        for (size_t i = 1; i < blocks_.size(); ++i) {
-            const SPHINXBlock::Block& currentBlock = blocks_[i];
-            const SPHINXBlock::Block& previousBlock = blocks_[i - 1];
+        SPHINXTree::ForkOptions options;
+        SPHINXTree::BlockTree tree;
+        std::unordered_map<SPHINXIndex::BlockDigest, SPHINXBlock::Block, SPHINXIndex::BlockDigestHasher> sideBlocks;  // Every tree block off the best chain
+        SPHINXTree::OrphanPool orphans;
+        SPHINXTree::ForkStats stats;
+    };
+    std::unique_ptr<ForkState> forks_;  // Null while forks are disabled
 
-            // Verify the block's hash and previous block hash
-            if (currentBlock.getBlockHash() != currentBlock.calculateBlockHash() ||
-                currentBlock.getPreviousHash() != previousBlock.calculateBlockHash()) {
-                return false;
-            }
+    // Start the block tree over at the current tip, dropping side branches and orphans.
+    void resetForkTree();
 
-            // Verify the signature of the block
-            if (!SPHINXVerify::verifySPHINXBlock(currentBlock, currentBlock.getSignature(), publicKey_)) {
-                return false;
-            }
-        }
+    // Put a block whose parent is in the tree into the tree, connecting it, or reorganizing to its branch if that has the most work.
+    SPHINXTree::AcceptResult insertIntoTree(const SPHINXBlock::Block& block);
 
-        return true;
-    }
+    // Apply the balance effect of a block, saving the previous balances, and append it to the best chain; throws if the
+    // effect overdraws an address.
+    void connectBlock(const SPHINXBlock::Block& block);
 
-    SPHINXBlock::Block Chain::getGenesisBlock() const {
-        // Get the first block in the blockchain
-        return blocks_.front();
-    }
+    // Compute the balance effect of a block that is about to be appended; throws if it overdraws an address. Every path
+    // that appends a block checks it before changing anything.
+    SPHINXTree::BlockEffect checkBlockEffect(const SPHINXBlock::Block& block) const;
 
-    SPHINXBlock::Block Chain::getBlockAt(size_t index) const {
-        // Get the block at the specified index
-        if (index < blocks_.size()) {
-            return blocks_[index];
-        } else {
-            throw std::out_of_range("Index out of range");
-        }
-    }
+    // Apply a checked block effect, saving the previous balances in the record of the next block.
+    void applyBlockEffect(const SPHINXTree::BlockEffect& effect);
 
-    size_t Chain::getChainLength() const {
-        // Get the length or size of the chain
-        return blocks_.size();
-    }
+    // Link a block whose balance effect is already applied in as the tip of the best chain.
+    void pushTip(const SPHINXBlock::Block& block);
 
-    void Chain::visualizeChain() const {
-        // Visualize the blockchain for analysis or presentation purposes
-        for (size_t i = 0; i < blocks_.size(); ++i) {
-            const SPHINXBlock::Block& block = blocks_[i];
-            std::cout << "Block " << i << " - Hash: " << block.getBlockHash() << std::endl;
-            // Print or display other block details as desired
-        }
-    }
+    // Take the blocks above height off the best chain, tip first, with one copy-on-write truncate so read views keep
+    // them; the caller puts their balances back from the undo records.
+    std::vector<SPHINXBlock::Block> disconnectAbove(uint32_t height);
 
-    json Chain::toJson() const {
-        json chainJson;
-        chainJson["blocks"] = json::array();
-        for (const SPHINXBlock::Block& block : blocks_) {
-            chainJson["blocks"].push_back(block.toJson());
-        }
-        return chainJson;
-    }
+    // Make the branch ending at tip the best chain; false if it forks too deep. A block of the branch that does not apply
+    // drops the rest of the branch, restores the previous chain and throws.
+    bool reorganizeTo(const SPHINXIndex::BlockDigest& tip);
 
-    void Chain::fromJson(const json& chainJson) {
-        blocks_.clear();
-        if (chainJson.contains("blocks") && chainJson["blocks"].is_array()) {
-            const json& blocksJson = chainJson["blocks"];
-            for (const json& blockJson : blocksJson) {
-                SPHINXBlock::Block block;
-                block.fromJson(blockJson);
-                blocks_.push_back(block);
-            }
-        } else {
-            throw std::invalid_argument("Invalid JSON structure or missing fields");
-        }
-    }
+    // Get a block by height without a range check; stored blocks are decoded once and cached.
+    std::shared_ptr<const SPHINXBlock::Block> blockPtr(size_t index) const;
+
+    // Find a shard by name under the directory lock; throws if it does not exist.
+    Shard& findShard(const std::string& shardName);
+    const Shard& findShard(const std::string& shardName) const;
+
+    // Validate a batch of transfers and coalesce it into one delta per recipient (deltas point into recipients).
+    static void coalesceTransfers(std::span<const SPHINXTrx::Transaction> transactions, std::vector<std::string>& recipients, std::vector<SPHINXLedger::BalanceDelta>& deltas);
+
+    std::shared_ptr<SPHINXKeys::KeyManager> keyManager_ = std::make_shared<SPHINXKeys::KeyManager>();  // Signing key, generated once on first use
+    std::shared_ptr<SPHINXSwap::SwapEngine> swapEngine_;  // Atomic swap state machine, created on first use
+
+    // Get the swap engine, creating an in-memory one if openSwapStore was not called.
+    SPHINXSwap::SwapEngine& swapEngine();
+
+    std::unique_ptr<SPHINXTxPool::TransactionPool> mempool_ = std::make_unique<SPHINXTxPool::TransactionPool>();  // Pending transactions, indexed by id, sender nonce and fee rate
+    size_t maxBlockSize_ = 0;  // MainParams::getMaxBlockSize()
+
+    // Clamp a requested transaction size to what fits in a block on top of the tip, 0 meaning all of it.
+    size_t blockBudget(size_t maxBytes) const;
+
+    // Throw std::runtime_error if the encoded block is larger than maxBlockSize_.
+    void checkBlockSize(const SPHINXBlock::Block& block) const;
+
+    std::unique_ptr<SPHINXBroadcast::Broadcaster> broadcaster_;  // Background transaction broadcaster, created on first use
+    std::unique_ptr<std::once_flag> broadcasterOnce_ = std::make_unique<std::once_flag>();  // Broadcasts may start on several threads
+
+    // Get the broadcaster, creating one that sends to the bridge if openBroadcast was not called.
+    SPHINXBroadcast::Broadcaster& broadcaster();
+
+    public:
+    // Load of one shard after partitioning.
+    struct ShardLoad {
+        size_t accounts = 0;
+        SPHINXLedger::Amount balance = 0;  // Sum of the balances assigned to the shard
+    };
+
+    // Outcome of Sharding::shardBlockchain, used to tune the shard count.
+    struct ShardingReport {
+        std::vector<ShardLoad> shards;
+        double accountSkew = 0.0;  // Largest shard / average shard, by account count (1.0 is perfectly even)
+        double balanceSkew = 0.0;  // Same, by balance
+        double seconds = 0.0;  // Wall time of the partitioning
+    };
 
     // Sharding class for horizontal partitioning of the blockchain network
     class Sharding {
     public:
-        static std::vector<SPHINXChain> shardBlockchain(const SPHINXChain& chain, size_t shardCount);
+        // Split the account state of a chain into shardCount chains. Addresses are assigned through a consistent-hash
+        // ring (ShardRing.hpp), so changing the shard count moves as few accounts as possible; the partitioning runs
+        // in parallel on the shared thread pool. Every shard keeps the block history of the source chain without a copy:
+        // a block file is shared and the blocks in memory share segments, so only the last, partly filled segment is
+        // copied per shard. If report is given it receives the load of every shard and the skew.
+        static std::vector<SPHINXChain> shardBlockchain(const SPHINXChain& chain, size_t shardCount, ShardingReport* report = nullptr);
+
+        // Get the shard an address belongs to when a chain is split into shardCount shards. The ring of each shard count
+        // is built once and reused.
+        static size_t shardForAddress(const std::string& address, size_t shardCount);
     };
+
+    private:
+    static constexpr size_t PARTITION_GRAIN = 4096;  // Accounts per partitioning task
 }; // namespace SPHINXChain
 
 #endif // SPHINXCHAIN_HPP
@@ -0,0 +1,76 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the read views that a chain publishes for concurrent readers.
+
+// Publication:
+    // The writer builds a view after each commit and stores it in an atomic shared pointer; readers load that pointer and never touch the chain itself.
+    // A view that is no longer current stays valid for as long as some reader holds it, and is freed with the last reference.
+
+// Blocks:
+    // Stored blocks come from the block source the chain had at publication time (block file, archive or a fixed-size cold view), which never changes size.
+    // In-memory blocks come from a snapshot of the chain's segmented block list: O(1) to take, no block is copied, and appends after it are never seen.
+
+// Balances:
+    // A view shares the balances of the previous one until they change; then the writer publishes a copy of the ledger without its commitment cache.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <stdexcept>
+#include <utility>
+
+#include "ChainView.hpp"
+
+namespace SPHINXView {
+
+    ChainView::ChainView(uint64_t version, std::shared_ptr<const SPHINXStore::BlockSource> storedBlocks, BlockList::Snapshot hotBlocks,
+                         std::shared_ptr<const SPHINXLedger::Ledger> balances)
+        : version_(version), storedBlocks_(std::move(storedBlocks)), storedCount_(storedBlocks_ ? storedBlocks_->size() : 0),
+          hotBlocks_(std::move(hotBlocks)), balances_(std::move(balances)) {}
+
+    // Get a block hash from the block source or the in-memory snapshot
+    BlockHash ChainView::getBlockHash(size_t height) const {
+        if (height >= getChainLength()) {
+            throw std::out_of_range("Block height out of range.");
+        }
+        if (height < storedCount_) {
+            return BlockHash(storedBlocks_->blockHash(height));
+        }
+        return hotBlocks_[height - storedCount_].getBlockHash();  // A view only if the block hands out a reference
+    }
+
+    // Get the hash of the tip
+    BlockHash ChainView::getTipHash() const {
+        const size_t length = getChainLength();
+        return length == 0 ? BlockHash() : getBlockHash(length - 1);
+    }
+
+    // Get a block, decoding it into scratch when it is not held in memory
+    const SPHINXBlock::Block& ChainView::getBlockAt(size_t index, SPHINXBlock::Block& scratch) const {
+        if (index >= getChainLength()) {
+            throw std::out_of_range("Index out of range");
+        }
+        if (index < storedCount_) {
+            scratch = storedBlocks_->decodeBlock(index);
+            return scratch;
+        }
+        return hotBlocks_[index - storedCount_];
+    }
+
+    // Get a balance as of the view
+    double ChainView::getBalance(const std::string& address) const {
+        return balances_ ? SPHINXLedger::toDouble(balances_->balance(address)) : 0.0;
+    }
+} // namespace SPHINXView
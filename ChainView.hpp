@@ -0,0 +1,84 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXCHAINVIEW_HPP
+#define SPHINXCHAINVIEW_HPP
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "Block.hpp"
+#include "BlockStore.hpp"
+#include "Ledger.hpp"
+#include "SegmentedList.hpp"
+
+namespace SPHINXView {
+
+    // In-memory blocks of a chain.
+    using BlockList = SPHINXStore::SegmentedList<SPHINXBlock::Block>;
+
+    // Block hash as handed out by a chain or a view: a view of the hash when Block::getBlockHash returns a reference to
+    // its member, a copy when it returns by value, so the result never points into a destroyed temporary.
+    using BlockHash = std::conditional_t<std::is_lvalue_reference_v<decltype(std::declval<const SPHINXBlock::Block&>().getBlockHash())>, std::string_view, std::string>;
+
+    // Immutable picture of a chain at one commit: the blocks up to the tip and the balances as of the same commit.
+    // The chain publishes a new view after every block or transfer batch; readers pick up the current one without
+    // taking any lock of the chain and may keep using it, from any thread, while the chain moves on.
+    class ChainView {
+    public:
+        // View of an empty chain.
+        ChainView() = default;
+
+        ChainView(uint64_t version, std::shared_ptr<const SPHINXStore::BlockSource> storedBlocks, BlockList::Snapshot hotBlocks,
+                  std::shared_ptr<const SPHINXLedger::Ledger> balances);
+
+        // Publication number; a later view of the same chain has a higher version.
+        uint64_t version() const { return version_; }
+
+        // Number of blocks in the view.
+        size_t getChainLength() const { return storedCount_ + hotBlocks_.size(); }
+
+        // Hash of the block at the given height; throws std::out_of_range past the tip.
+        BlockHash getBlockHash(size_t height) const;
+
+        // Hash of the last block, or an empty hash for an empty chain.
+        BlockHash getTipHash() const;
+
+        // Get the block at the given height. Blocks held in memory are returned by reference; stored blocks are
+        // decoded into scratch. Throws std::out_of_range past the tip.
+        const SPHINXBlock::Block& getBlockAt(size_t index, SPHINXBlock::Block& scratch) const;
+
+        // Balance of an address as of this view (zero for unknown addresses).
+        double getBalance(const std::string& address) const;
+
+        // Number of addresses with a balance entry.
+        size_t accountCount() const { return balances_ ? balances_->accountCount() : 0; }
+
+    private:
+        uint64_t version_ = 0;
+        std::shared_ptr<const SPHINXStore::BlockSource> storedBlocks_;  // Heights [0, storedCount_), may be null
+        size_t storedCount_ = 0;
+        BlockList::Snapshot hotBlocks_;  // Heights [storedCount_, getChainLength())
+        std::shared_ptr<const SPHINXLedger::Ledger> balances_;  // Shared with later views until the balances change
+    };
+} // namespace SPHINXView
+
+#endif // SPHINXCHAINVIEW_HPP
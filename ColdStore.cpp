@@ -0,0 +1,215 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the cold tier of pruned chains.
+
+// Record Format:
+    // u32 compressedLength | u32 bodyLength | u32 crc32(body) | compressed body, where body is the block file record body (u16 hashLength | hash | CBOR block).
+    // The CRC is checked after decompression, so a damaged record is reported instead of decoded.
+
+// Scratch File:
+    // The file is created with mkstemp and unlinked right away: it needs no clean-up after a crash and two stores never share a name.
+    // Records are appended with write and read back with pread, which needs no lock and no shared file position.
+
+// Views:
+    // A view serves a fixed prefix of the store, so a chain that grows its cold tier never changes what another chain sharing the store sees.
+    // Offsets and hashes are kept in segmented lists (SegmentedList.hpp); a view holds snapshots of them, so it can be read from other threads while the store grows.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "ColdStore.hpp"
+#include "Compress.hpp"
+
+namespace SPHINXStore {
+
+    namespace {
+        void putU32(uint8_t* out, uint32_t value) {
+            for (int i = 0; i < 4; ++i) {
+                out[i] = static_cast<uint8_t>(value >> (8 * i));
+            }
+        }
+
+        uint32_t getU32(const uint8_t* in) {
+            return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+                   (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+        }
+
+        void readAt(int fd, uint8_t* out, size_t length, uint64_t offset) {
+            while (length > 0) {
+                const ssize_t count = ::pread(fd, out, length, static_cast<off_t>(offset));
+                if (count < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (count <= 0) {
+                    throw std::runtime_error("Failed to read cold block record");
+                }
+                out += count;
+                length -= static_cast<size_t>(count);
+                offset += static_cast<uint64_t>(count);
+            }
+        }
+
+        // Read, decompress, check and decode the record at offset
+        SPHINXBlock::Block readColdBlock(int fd, uint64_t offset, size_t height) {
+            uint8_t header[COLD_RECORD_HEADER_SIZE];
+            readAt(fd, header, sizeof(header), offset);
+            std::vector<uint8_t> compressed(getU32(header));
+            readAt(fd, compressed.data(), compressed.size(), offset + COLD_RECORD_HEADER_SIZE);
+
+            const std::vector<uint8_t> body = SPHINXCompress::decompress(compressed.data(), compressed.size(), getU32(header + 4));
+            if (crc32(body.data(), body.size()) != getU32(header + 8)) {
+                throw std::runtime_error("Cold block record checksum mismatch at height " + std::to_string(height));
+            }
+            return decodeRecordBody(body.data(), body.size());
+        }
+    } // namespace
+
+    // Fixed-size prefix of a cold store. It reads through snapshots of the offsets and hashes, never through the
+    // store's own lists, so the owner may append while other threads read the view.
+    class ColdBlockStore::View : public BlockSource {
+    public:
+        View(const ColdBlockStore& store, size_t count)
+            : store_(store.shared_from_this()), base_(store.base_), baseCount_(store.baseSize()),
+              offsets_(store.offsets_.snapshot()), hashes_(store.hashes_.snapshot()), count_(count) {}
+
+        size_t size() const override { return count_; }
+
+        std::string_view blockHash(size_t index) const override {
+            checkIndex(index);
+            return index < baseCount_ ? base_->blockHash(index) : std::string_view(hashes_[index - baseCount_]);
+        }
+
+        SPHINXBlock::Block decodeBlock(size_t index) const override {
+            checkIndex(index);
+            return index < baseCount_ ? base_->decodeBlock(index) : readColdBlock(store_->fd_, offsets_[index - baseCount_], index);
+        }
+
+    private:
+        void checkIndex(size_t index) const {
+            if (index >= count_) {
+                throw std::out_of_range("Cold block index out of range");
+            }
+        }
+
+        std::shared_ptr<const ColdBlockStore> store_;  // Keeps the scratch file open
+        std::shared_ptr<const BlockSource> base_;
+        size_t baseCount_;
+        SegmentedList<uint64_t>::Snapshot offsets_;
+        SegmentedList<std::string>::Snapshot hashes_;
+        size_t count_;
+    };
+
+    ColdBlockStore::~ColdBlockStore() {
+        ::close(fd_);
+    }
+
+    // Create an unlinked scratch file for the cold bodies
+    std::shared_ptr<ColdBlockStore> ColdBlockStore::create(const std::string& directory, std::shared_ptr<const BlockSource> base) {
+        const std::filesystem::path folder = directory.empty() ? std::filesystem::temp_directory_path() : std::filesystem::path(directory);
+        std::string pattern = (folder / "sphinx-cold-XXXXXX").string();
+        const int fd = ::mkstemp(pattern.data());
+        if (fd < 0) {
+            throw std::runtime_error("Failed to create cold block file in " + folder.string());
+        }
+        ::unlink(pattern.c_str());  // Only the descriptor keeps the file alive
+        return std::shared_ptr<ColdBlockStore>(new ColdBlockStore(fd, std::move(base)));
+    }
+
+    // Compress a block and append its record
+    void ColdBlockStore::append(const SPHINXBlock::Block& block) {
+        const std::vector<uint8_t> record = encodeRecord(block);
+        const uint8_t* body = record.data() + RECORD_HEADER_SIZE;
+        const size_t bodyLength = record.size() - RECORD_HEADER_SIZE;
+        const std::vector<uint8_t> compressed = SPHINXCompress::compress(body, bodyLength);
+
+        std::vector<uint8_t> coldRecord(COLD_RECORD_HEADER_SIZE);
+        putU32(coldRecord.data(), static_cast<uint32_t>(compressed.size()));
+        putU32(coldRecord.data() + 4, static_cast<uint32_t>(bodyLength));
+        putU32(coldRecord.data() + 8, getU32(record.data() + 4));  // The CRC encodeRecord already computed
+        coldRecord.insert(coldRecord.end(), compressed.begin(), compressed.end());
+
+        const uint64_t offset = diskBytes_;  // Records are back to back
+        const uint8_t* data = coldRecord.data();
+        size_t remaining = coldRecord.size();
+        while (remaining > 0) {
+            const ssize_t count = ::pwrite(fd_, data, remaining, static_cast<off_t>(offset + (coldRecord.size() - remaining)));
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                throw std::runtime_error("Failed to write cold block record");
+            }
+            data += count;
+            remaining -= static_cast<size_t>(count);
+        }
+
+        offsets_.push_back(offset);
+        hashes_.push_back(block.getBlockHash());
+        rawBytes_ += bodyLength;
+        diskBytes_ += coldRecord.size();
+    }
+
+    // Forget appended records; their bytes are overwritten by the next append
+    void ColdBlockStore::truncate(size_t count) {
+        const size_t keep = count > baseSize() ? count - baseSize() : 0;
+        while (offsets_.size() > keep) {
+            diskBytes_ = offsets_[offsets_.size() - 1];
+            offsets_.pop_back();  // Never part of a view: views are only taken of committed appends
+            hashes_.pop_back();
+        }
+    }
+
+    size_t ColdBlockStore::size() const {
+        return baseSize() + offsets_.size();
+    }
+
+    // Get a block hash from memory
+    std::string_view ColdBlockStore::blockHash(size_t index) const {
+        const size_t baseCount = baseSize();
+        if (index < baseCount) {
+            return base_->blockHash(index);
+        }
+        if (index - baseCount >= hashes_.size()) {
+            throw std::out_of_range("Cold block index out of range");
+        }
+        return hashes_[index - baseCount];
+    }
+
+    // Read, decompress, check and decode one block
+    SPHINXBlock::Block ColdBlockStore::decodeBlock(size_t index) const {
+        const size_t baseCount = baseSize();
+        if (index < baseCount) {
+            return base_->decodeBlock(index);
+        }
+        if (index - baseCount >= offsets_.size()) {
+            throw std::out_of_range("Cold block index out of range");
+        }
+        return readColdBlock(fd_, offsets_[index - baseCount], index);
+    }
+
+    std::shared_ptr<const BlockSource> ColdBlockStore::view(size_t count) const {
+        return std::make_shared<View>(*this, std::min(count, size()));
+    }
+} // namespace SPHINXStore
@@ -0,0 +1,93 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXCOLDSTORE_HPP
+#define SPHINXCOLDSTORE_HPP
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "Block.hpp"
+#include "BlockStore.hpp"
+#include "SegmentedList.hpp"
+
+namespace SPHINXStore {
+
+    // Pruning policy of a chain: how many blocks stay decoded in memory and where older bodies go.
+    struct PruneOptions {
+        std::string directory;  // Directory of the cold scratch file; empty uses the system temporary directory
+        size_t hotBlocks = 1024;  // Most recent blocks kept decoded in memory
+        size_t cacheBlocks = 256;  // Cold blocks kept decoded after being paged in (LRU)
+    };
+
+    // Size of the fixed cold record header: u32 compressed length + u32 body length + u32 CRC-32 of the body.
+    constexpr size_t COLD_RECORD_HEADER_SIZE = 12;
+
+    // Storage for the blocks that fell out of a chain's hot window. Bodies are compressed (Compress.hpp) into an
+    // unlinked scratch file that disappears with the store, while block hashes stay in memory, so blockHash never
+    // touches the disk. The store serves the blocks of an optional base source first (the block file the chain was
+    // loaded from), then the blocks appended to it. The store itself is used by one thread at a time, like the rest of
+    // the chain, but views may be read from any thread while the owner keeps appending.
+    class ColdBlockStore : public std::enable_shared_from_this<ColdBlockStore> {
+    public:
+        ~ColdBlockStore();
+
+        ColdBlockStore(const ColdBlockStore&) = delete;
+        ColdBlockStore& operator=(const ColdBlockStore&) = delete;
+
+        // Create an empty store on top of base (may be null).
+        static std::shared_ptr<ColdBlockStore> create(const std::string& directory, std::shared_ptr<const BlockSource> base);
+
+        // Compress one block and append it.
+        void append(const SPHINXBlock::Block& block);
+
+        // Drop the appended blocks at and above count (used to undo a partly failed batch of appends).
+        void truncate(size_t count);
+
+        // Number of blocks, base included.
+        size_t size() const;
+
+        std::string_view blockHash(size_t index) const;
+        SPHINXBlock::Block decodeBlock(size_t index) const;
+
+        // Source over the first count blocks. It keeps its size while the store grows, so it can be shared with other chains
+        // and read concurrently with appends.
+        std::shared_ptr<const BlockSource> view(size_t count) const;
+
+        // Body bytes appended before and after compression, to report the compression ratio.
+        uint64_t rawBytes() const { return rawBytes_; }
+        uint64_t diskBytes() const { return diskBytes_; }
+
+    private:
+        class View;
+
+        ColdBlockStore(int fd, std::shared_ptr<const BlockSource> base) : fd_(fd), base_(std::move(base)) {}
+
+        size_t baseSize() const { return base_ ? base_->size() : 0; }
+
+        int fd_;
+        std::shared_ptr<const BlockSource> base_;
+        SegmentedList<uint64_t> offsets_;  // File offset of every appended record
+        SegmentedList<std::string> hashes_;  // Hash of every appended block; segments never move, so views survive appends
+        uint64_t rawBytes_ = 0;
+        uint64_t diskBytes_ = 0;
+    };
+} // namespace SPHINXStore
+
+#endif // SPHINXCOLDSTORE_HPP
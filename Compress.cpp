@@ -0,0 +1,197 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the block compressor used by the SPHINX block storage.
+
+// Format:
+    // Output follows the LZ4 block format, so stored data can be inspected with standard LZ4 tools: a sequence is a token (literal length and match length, 4 bits each), extra length bytes, the literals, a 16-bit little-endian offset and extra match length bytes.
+    // The last sequence only has literals; the last 5 bytes are always literals and the last match starts at least 12 bytes before the end, as the format requires.
+
+// Compressor:
+    // A single pass with a 4096-entry hash table of recent positions (greedy matching, 64 KiB window), which is fast and finds most of the repetition in hex hashes, keys and JSON field names.
+
+// Decompressor:
+    // Every length and offset is bounds-checked, so damaged data raises an error instead of reading or writing out of bounds.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "Compress.hpp"
+
+namespace SPHINXCompress {
+
+    namespace {
+        constexpr size_t MIN_MATCH = 4;
+        constexpr size_t LAST_LITERALS = 5;  // The last 5 bytes are always literals
+        constexpr size_t MATCH_FIND_LIMIT = 12;  // No match may start in the last 12 bytes
+        constexpr size_t MAX_OFFSET = 65535;
+        constexpr int HASH_BITS = 12;
+
+        uint32_t read32(const uint8_t* in) {
+            uint32_t value;
+            std::memcpy(&value, in, sizeof(value));
+            return value;
+        }
+
+        uint32_t hashOf(uint32_t sequence) {
+            return (sequence * 2654435761u) >> (32 - HASH_BITS);
+        }
+
+        // Write the extra bytes of a length that does not fit in its 4-bit token field
+        void putLength(std::vector<uint8_t>& out, size_t length) {
+            for (; length >= 255; length -= 255) {
+                out.push_back(255);
+            }
+            out.push_back(static_cast<uint8_t>(length));
+        }
+
+        void putSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength) {
+            const size_t matchCode = matchLength - MIN_MATCH;
+            out.push_back(static_cast<uint8_t>((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchCode, 15)));
+            if (literalLength >= 15) {
+                putLength(out, literalLength - 15);
+            }
+            out.insert(out.end(), literals, literals + literalLength);
+            out.push_back(static_cast<uint8_t>(offset));
+            out.push_back(static_cast<uint8_t>(offset >> 8));
+            if (matchCode >= 15) {
+                putLength(out, matchCode - 15);
+            }
+        }
+
+        void putLastLiterals(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalLength) {
+            out.push_back(static_cast<uint8_t>(std::min<size_t>(literalLength, 15) << 4));
+            if (literalLength >= 15) {
+                putLength(out, literalLength - 15);
+            }
+            out.insert(out.end(), literals, literals + literalLength);
+        }
+
+        // Read the extra bytes of a length whose token field was 15
+        size_t readLength(const uint8_t* data, size_t length, size_t& position) {
+            size_t value = 0;
+            uint8_t byte;
+            do {
+                if (position >= length) {
+                    throw std::runtime_error("Truncated compressed data");
+                }
+                byte = data[position++];
+                value += byte;
+            } while (byte == 255);
+            return value;
+        }
+    } // namespace
+
+    size_t compressBound(size_t length) {
+        return length + length / 255 + 16;
+    }
+
+    // Compress in one greedy pass
+    std::vector<uint8_t> compress(const uint8_t* data, size_t length) {
+        std::vector<uint8_t> out;
+        out.reserve(compressBound(length));
+        size_t anchor = 0;  // Start of the pending literals
+
+        if (length > MATCH_FIND_LIMIT) {
+            std::vector<uint32_t> table(size_t{1} << HASH_BITS, 0);  // Position + 1 of the last sequence with each hash, 0 when empty
+            const size_t matchLimit = length - LAST_LITERALS;
+            const size_t searchLimit = length - MATCH_FIND_LIMIT;
+            size_t position = 0;
+            while (position < searchLimit) {
+                const uint32_t sequence = read32(data + position);
+                uint32_t& slot = table[hashOf(sequence)];
+                const size_t candidate = slot;
+                slot = static_cast<uint32_t>(position + 1);
+                if (candidate == 0 || position - (candidate - 1) > MAX_OFFSET || read32(data + candidate - 1) != sequence) {
+                    position += 1 + ((position - anchor) >> 6);  // Skip faster through data that does not compress
+                    continue;
+                }
+
+                const size_t match = candidate - 1;
+                size_t matchLength = MIN_MATCH;
+                while (position + matchLength < matchLimit && data[match + matchLength] == data[position + matchLength]) {
+                    ++matchLength;
+                }
+                putSequence(out, data + anchor, position - anchor, position - match, matchLength);
+                position += matchLength;
+                anchor = position;
+            }
+        }
+
+        putLastLiterals(out, data + anchor, length - anchor);
+        return out;
+    }
+
+    // Decompress with every length and offset checked
+    std::vector<uint8_t> decompress(const uint8_t* data, size_t length, size_t originalLength) {
+        std::vector<uint8_t> out(originalLength);
+        size_t input = 0;
+        size_t output = 0;
+        while (true) {
+            if (input >= length) {
+                throw std::runtime_error("Truncated compressed data");
+            }
+            const uint8_t token = data[input++];
+
+            size_t literalLength = token >> 4;
+            if (literalLength == 15) {
+                literalLength += readLength(data, length, input);
+            }
+            if (literalLength > length - input || literalLength > originalLength - output) {
+                throw std::runtime_error("Corrupt compressed data: literals out of bounds");
+            }
+            if (literalLength > 0) {
+                std::memcpy(out.data() + output, data + input, literalLength);
+            }
+            input += literalLength;
+            output += literalLength;
+            if (input == length) {
+                break;  // The last sequence has no match
+            }
+
+            if (length - input < 2) {
+                throw std::runtime_error("Truncated compressed data");
+            }
+            const size_t offset = data[input] | (static_cast<size_t>(data[input + 1]) << 8);
+            input += 2;
+            if (offset == 0 || offset > output) {
+                throw std::runtime_error("Corrupt compressed data: bad match offset");
+            }
+            size_t matchLength = token & 0x0F;
+            if (matchLength == 15) {
+                matchLength += readLength(data, length, input);
+            }
+            matchLength += MIN_MATCH;
+            if (matchLength > originalLength - output) {
+                throw std::runtime_error("Corrupt compressed data: match out of bounds");
+            }
+            if (offset >= matchLength) {
+                std::memcpy(out.data() + output, out.data() + output - offset, matchLength);
+                output += matchLength;
+            } else {
+                for (size_t i = 0; i < matchLength; ++i, ++output) {
+                    out[output] = out[output - offset];  // Byte by byte: the match overlaps its own output
+                }
+            }
+        }
+        if (output != originalLength) {
+            throw std::runtime_error("Corrupt compressed data: wrong decompressed size");
+        }
+        return out;
+    }
+} // namespace SPHINXCompress
@@ -0,0 +1,38 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXCOMPRESS_HPP
+#define SPHINXCOMPRESS_HPP
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SPHINXCompress {
+
+    // Compress a byte range into the LZ4 block format (no frame header, no checksum). Output never exceeds
+    // compressBound(length); incompressible input grows by about 0.4%.
+    std::vector<uint8_t> compress(const uint8_t* data, size_t length);
+
+    // Largest possible output of compress for an input of the given length.
+    size_t compressBound(size_t length);
+
+    // Decompress LZ4 block data whose decompressed size is known; throws std::runtime_error on malformed input
+    // or if the output would not be exactly originalLength bytes.
+    std::vector<uint8_t> decompress(const uint8_t* data, size_t length, size_t originalLength);
+} // namespace SPHINXCompress
+
+#endif // SPHINXCOMPRESS_HPP
@@ -0,0 +1,275 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the append-only block journal used by the SPHINX chain for incremental persistence.
+
+// Appending:
+    // Each new block is encoded as one checksummed record (the same format as the block file, see BlockStore.hpp) and written at the end of the file.
+    // Nothing that is already on disk is rewritten, so the cost of persisting a block depends only on the size of that block.
+
+// Group Commit:
+    // Appends do not fsync themselves. A background thread syncs once maxPendingRecords records are waiting or maxPendingDelay has passed since the first unsynced record.
+    // Callers that need durability wait on the sequence number returned by append; all appends that arrived before the sync share the same fsync.
+
+// Recovery:
+    // When a journal is opened, every record is checked against its length prefix and CRC-32.
+    // The first short or damaged record marks a torn tail from a crash; the file is truncated back to the last complete record.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Journal.hpp"
+
+namespace SPHINXStore {
+
+    namespace {
+        // Read exactly length bytes at offset, returning false on a short read
+        bool readAt(int fd, void* buffer, size_t length, uint64_t offset) {
+            uint8_t* out = static_cast<uint8_t*>(buffer);
+            while (length > 0) {
+                ssize_t count = ::pread(fd, out, length, static_cast<off_t>(offset));
+                if (count < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (count <= 0) {
+                    return false;
+                }
+                out += count;
+                offset += static_cast<uint64_t>(count);
+                length -= static_cast<size_t>(count);
+            }
+            return true;
+        }
+
+        // Write the whole buffer, retrying on partial writes
+        bool writeAll(int fd, const uint8_t* data, size_t length) {
+            while (length > 0) {
+                ssize_t count = ::write(fd, data, length);
+                if (count < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (count <= 0) {
+                    return false;
+                }
+                data += count;
+                length -= static_cast<size_t>(count);
+            }
+            return true;
+        }
+
+        uint32_t getU32(const uint8_t* in) {
+            return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+                   (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+        }
+    } // namespace
+
+    BlockJournal::BlockJournal(const std::string& filename, JournalOptions options)
+        : filename_(filename), options_(options) {
+    }
+
+    BlockJournal::~BlockJournal() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        pendingChanged_.notify_all();
+        if (syncThread_.joinable()) {
+            syncThread_.join();  // The sync thread drains every pending record before it exits
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    // Open or create the journal, recover it and start the group-commit thread
+    std::unique_ptr<BlockJournal> BlockJournal::open(const std::string& filename, const nlohmann::json& metadata, JournalOptions options) {
+        std::unique_ptr<BlockJournal> journal(new BlockJournal(filename, options));
+        journal->fd_ = ::open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+        if (journal->fd_ < 0) {
+            throw std::runtime_error("Failed to open block journal: " + filename);
+        }
+        journal->recover(metadata);
+        journal->syncThread_ = std::thread([raw = journal.get()] { raw->syncLoop(); });
+        return journal;
+    }
+
+    // Walk the records, drop a torn tail and position the file for appending
+    void BlockJournal::recover(const nlohmann::json& metadata) {
+        struct stat info;
+        if (::fstat(fd_, &info) != 0) {
+            throw std::runtime_error("Failed to stat block journal: " + filename_);
+        }
+        const uint64_t fileSize = static_cast<uint64_t>(info.st_size);
+
+        // Check the header; an empty or headerless file gets a fresh one
+        uint64_t offset = 0;
+        uint8_t prefix[sizeof(FILE_MAGIC) + 4];
+        bool hasHeader = fileSize >= sizeof(prefix) && readAt(fd_, prefix, sizeof(prefix), 0) &&
+                         std::memcmp(prefix, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0 &&
+                         sizeof(prefix) + getU32(prefix + sizeof(FILE_MAGIC)) <= fileSize;
+        if (hasHeader) {
+            offset = sizeof(prefix) + getU32(prefix + sizeof(FILE_MAGIC));
+        } else {
+            uint8_t magic[sizeof(FILE_MAGIC)];
+            if (fileSize >= sizeof(magic) && readAt(fd_, magic, sizeof(magic), 0) &&
+                std::memcmp(magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+                throw std::runtime_error("Not a SPHINX block journal: " + filename_);  // Never wipe a foreign file
+            }
+            if (fileSize > 0 && ::ftruncate(fd_, 0) != 0) {
+                throw std::runtime_error("Failed to reset block journal: " + filename_);
+            }
+            truncatedBytes_ = fileSize;  // Only a torn header can get here
+            const std::vector<uint8_t> encodedMetadata = nlohmann::json::to_cbor(metadata);
+            std::vector<uint8_t> header(FILE_MAGIC, FILE_MAGIC + sizeof(FILE_MAGIC));
+            for (int shift = 0; shift < 32; shift += 8) {
+                header.push_back(static_cast<uint8_t>(encodedMetadata.size() >> shift));
+            }
+            header.insert(header.end(), encodedMetadata.begin(), encodedMetadata.end());
+            if (::lseek(fd_, 0, SEEK_SET) < 0 || !writeAll(fd_, header.data(), header.size()) || ::fsync(fd_) != 0) {
+                throw std::runtime_error("Failed to write block journal header: " + filename_);
+            }
+            return;
+        }
+
+        // Keep every complete record whose checksum matches
+        std::vector<uint8_t> body;
+        uint64_t records = 0;
+        while (offset + RECORD_HEADER_SIZE <= fileSize) {
+            uint8_t recordHeader[RECORD_HEADER_SIZE];
+            if (!readAt(fd_, recordHeader, RECORD_HEADER_SIZE, offset)) {
+                break;
+            }
+            const uint32_t bodyLength = getU32(recordHeader);
+            if (offset + RECORD_HEADER_SIZE + bodyLength > fileSize) {
+                break;  // Record extends past the end of the file
+            }
+            body.resize(bodyLength);
+            if (!readAt(fd_, body.data(), bodyLength, offset + RECORD_HEADER_SIZE) ||
+                crc32(body.data(), bodyLength) != getU32(recordHeader + 4)) {
+                break;  // Damaged record, everything from here on is the torn tail
+            }
+            offset += RECORD_HEADER_SIZE + bodyLength;
+            ++records;
+        }
+
+        if (offset < fileSize) {
+            if (::ftruncate(fd_, static_cast<off_t>(offset)) != 0 || ::fsync(fd_) != 0) {
+                throw std::runtime_error("Failed to truncate torn block journal tail: " + filename_);
+            }
+            truncatedBytes_ = fileSize - offset;
+        }
+        if (::lseek(fd_, static_cast<off_t>(offset), SEEK_SET) < 0) {
+            throw std::runtime_error("Failed to seek block journal: " + filename_);
+        }
+        written_ = records;
+        durable_ = records;
+    }
+
+    // Append one record; durability is handled by the sync thread
+    uint64_t BlockJournal::append(const SPHINXBlock::Block& block) {
+        const std::vector<uint8_t> record = encodeRecord(block);  // Encode outside the lock
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            throw std::runtime_error("Block journal is closed: " + filename_);
+        }
+        const off_t start = ::lseek(fd_, 0, SEEK_CUR);
+        if (!writeAll(fd_, record.data(), record.size())) {
+            // Never leave a partial record behind, later appends would follow garbage
+            if (start >= 0 && ::ftruncate(fd_, start) == 0) {
+                ::lseek(fd_, start, SEEK_SET);
+            }
+            throw std::runtime_error("Failed to append to block journal: " + filename_);
+        }
+        if (written_ == durable_) {
+            firstPending_ = std::chrono::steady_clock::now();  // Start of a new commit group
+        }
+        ++written_;
+        pendingChanged_.notify_one();
+        return written_;
+    }
+
+    // Wait until the given record has been synced
+    void BlockJournal::waitDurable(uint64_t sequence) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        durableChanged_.wait(lock, [&] { return durable_ >= sequence || stopping_; });
+        if (durable_ < sequence) {
+            throw std::runtime_error("Block journal closed before the record was synced: " + filename_);
+        }
+    }
+
+    // Sync everything that has been appended so far
+    void BlockJournal::flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const uint64_t target = written_;
+        if (durable_ >= target) {
+            return;
+        }
+        flushRequested_ = true;
+        pendingChanged_.notify_one();
+        durableChanged_.wait(lock, [&] { return durable_ >= target || stopping_; });
+        if (durable_ < target) {
+            throw std::runtime_error("Block journal closed before flush completed: " + filename_);
+        }
+    }
+
+    // Get the number of complete records in the journal
+    uint64_t BlockJournal::recordCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return written_;
+    }
+
+    // Group-commit loop: one fdatasync per batch of appends
+    void BlockJournal::syncLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            pendingChanged_.wait(lock, [&] { return stopping_ || written_ > durable_; });
+            if (written_ == durable_) {
+                return;  // Stopping and nothing left to sync
+            }
+
+            // Let the batch fill up until the record or time limit is reached
+            const auto deadline = firstPending_ + options_.maxPendingDelay;
+            pendingChanged_.wait_until(lock, deadline, [&] {
+                return stopping_ || flushRequested_ || written_ - durable_ >= options_.maxPendingRecords;
+            });
+
+            const uint64_t target = written_;
+            flushRequested_ = false;
+            lock.unlock();
+            const bool synced = ::fdatasync(fd_) == 0;  // Appends may continue while the disk syncs
+            lock.lock();
+
+            if (!synced) {
+                stopping_ = true;  // Durability can no longer be promised, fail every waiter
+                durableChanged_.notify_all();
+                return;
+            }
+            durable_ = target;
+            if (written_ > durable_) {
+                firstPending_ = std::chrono::steady_clock::now();
+            }
+            durableChanged_.notify_all();
+        }
+    }
+} // namespace SPHINXStore
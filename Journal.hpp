@@ -0,0 +1,95 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXJOURNAL_HPP
+#define SPHINXJOURNAL_HPP
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "json.hpp"
+#include "Block.hpp"
+#include "BlockStore.hpp"
+
+namespace SPHINXStore {
+
+    // Group-commit policy of a journal: records are fsync'ed together once either limit is reached.
+    struct JournalOptions {
+        size_t maxPendingRecords = 64;  // Sync after this many unsynced records
+        std::chrono::milliseconds maxPendingDelay{20};  // Sync at the latest this long after the first unsynced record
+    };
+
+    // Append-only block journal. It uses the same record format as the block file, so a journal can be opened
+    // with BlockStore::open at any time. Appends are written immediately and made durable in batches by a
+    // background thread, so one fsync covers many blocks and the cost per block does not grow with the chain.
+    class BlockJournal {
+    public:
+        ~BlockJournal();
+
+        BlockJournal(const BlockJournal&) = delete;
+        BlockJournal& operator=(const BlockJournal&) = delete;
+
+        // Open or create a journal. A torn or damaged tail left by a crash is truncated away.
+        static std::unique_ptr<BlockJournal> open(const std::string& filename, const nlohmann::json& metadata, JournalOptions options = {});
+
+        // Append one block record and return its sequence number (1-based).
+        uint64_t append(const SPHINXBlock::Block& block);
+
+        // Block until the record with the given sequence number is on stable storage.
+        void waitDurable(uint64_t sequence);
+
+        // Sync every appended record now.
+        void flush();
+
+        // Number of complete records in the journal.
+        uint64_t recordCount() const;
+
+        // Number of bytes dropped from the tail during recovery.
+        uint64_t truncatedBytes() const { return truncatedBytes_; }
+
+        // Path of the journal file.
+        const std::string& filename() const { return filename_; }
+
+    private:
+        BlockJournal(const std::string& filename, JournalOptions options);
+
+        void recover(const nlohmann::json& metadata);
+        void syncLoop();
+
+        std::string filename_;
+        JournalOptions options_;
+        int fd_ = -1;
+        uint64_t truncatedBytes_ = 0;
+
+        mutable std::mutex mutex_;  // Guards the counters below and serializes writes
+        std::condition_variable pendingChanged_;  // Wakes the sync thread
+        std::condition_variable durableChanged_;  // Wakes callers of waitDurable
+        uint64_t written_ = 0;  // Records written to the file
+        uint64_t durable_ = 0;  // Records known to be on stable storage
+        bool flushRequested_ = false;
+        bool stopping_ = false;
+        std::chrono::steady_clock::time_point firstPending_;  // Time of the oldest unsynced record
+        std::thread syncThread_;
+    };
+} // namespace SPHINXStore
+
+#endif // SPHINXJOURNAL_HPP
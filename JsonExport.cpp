@@ -0,0 +1,124 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the streaming JSON export of the SPHINX chain.
+
+// Streaming:
+    // The document frame is written by hand and every block is serialized on its own and written immediately, so no DOM of the whole chain is ever built.
+    // Indented output reproduces the layout of nlohmann::json::dump(4) by shifting each block's own dump(4) by two levels; compact output has no whitespace at all.
+
+// File Descriptors:
+    // FdOutputBuffer is a std::streambuf over a raw descriptor (pipes, sockets, files opened elsewhere) with a fixed-size buffer.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <cerrno>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include "JsonExport.hpp"
+#include "json.hpp"
+
+namespace SPHINXStore {
+
+    JsonChainWriter::JsonChainWriter(std::ostream& out, bool compact) : out_(out), compact_(compact) {
+    }
+
+    // Write the opening of the document and the public key
+    void JsonChainWriter::begin(const std::string& publicKey) {
+        const std::string key = nlohmann::json(publicKey).dump();  // Quoted and escaped
+        if (compact_) {
+            out_ << "{\"SPHINXPubKey\":" << key << ",\"blocks\":[";
+        } else {
+            out_ << "{\n    \"SPHINXPubKey\": " << key << ",\n    \"blocks\": [";
+        }
+    }
+
+    // Serialize one block and write it out
+    void JsonChainWriter::writeBlock(const SPHINXBlock::Block& block) {
+        if (compact_) {
+            out_ << (written_ > 0 ? "," : "") << block.toJson().dump();
+        } else {
+            std::string text = block.toJson().dump(4);
+            std::string shifted;
+            shifted.reserve(text.size() + text.size() / 8);
+            for (char c : text) {
+                shifted.push_back(c);
+                if (c == '\n') {
+                    shifted.append(8, ' ');  // Two levels deep: document -> "blocks" -> block
+                }
+            }
+            out_ << (written_ > 0 ? ",\n        " : "\n        ") << shifted;
+        }
+        ++written_;
+    }
+
+    // Close the array and the document
+    void JsonChainWriter::finish() {
+        if (compact_) {
+            out_ << "]}";
+        } else {
+            out_ << (written_ > 0 ? "\n    ]\n}" : "]\n}");
+        }
+        out_.flush();
+        if (!out_) {
+            throw std::runtime_error("Failed to write JSON chain export");
+        }
+    }
+
+    FdOutputBuffer::FdOutputBuffer(int fd, size_t bufferSize) : fd_(fd), buffer_(bufferSize) {
+        setp(buffer_.data(), buffer_.data() + buffer_.size());
+    }
+
+    FdOutputBuffer::~FdOutputBuffer() {
+        drain();  // Errors are reported through sync()/flush(), not from a destructor
+    }
+
+    // Buffer full: write it out and keep the pending character
+    FdOutputBuffer::int_type FdOutputBuffer::overflow(int_type c) {
+        if (!drain()) {
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int FdOutputBuffer::sync() {
+        return drain() ? 0 : -1;
+    }
+
+    // Write everything buffered, retrying on partial writes
+    bool FdOutputBuffer::drain() {
+        const char* data = pbase();
+        size_t length = static_cast<size_t>(pptr() - pbase());
+        while (length > 0) {
+            const ssize_t count = ::write(fd_, data, length);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                return false;
+            }
+            data += count;
+            length -= static_cast<size_t>(count);
+        }
+        setp(buffer_.data(), buffer_.data() + buffer_.size());
+        return true;
+    }
+} // namespace SPHINXStore
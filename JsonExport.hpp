@@ -0,0 +1,77 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXJSONEXPORT_HPP
+#define SPHINXJSONEXPORT_HPP
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "Block.hpp"
+
+namespace SPHINXStore {
+
+    // What a JSON export contains and how it is laid out.
+    struct JsonExportOptions {
+        bool compact = false;  // No indentation or newlines (indented output matches nlohmann::json::dump(4))
+        size_t from = 0;  // First height to export
+        size_t to = std::numeric_limits<size_t>::max();  // One past the last height to export (clamped to the chain length)
+    };
+
+    // Writes a chain document ({"SPHINXPubKey": ..., "blocks": [...]}) block by block. Only the block being written
+    // is held as JSON, so memory stays bounded and output reaches the stream while the export is still running.
+    class JsonChainWriter {
+    public:
+        JsonChainWriter(std::ostream& out, bool compact);
+
+        // Write the document header; must be called once, before the first block.
+        void begin(const std::string& publicKey);
+
+        // Append one block to the "blocks" array.
+        void writeBlock(const SPHINXBlock::Block& block);
+
+        // Close the document and flush the stream; throws std::runtime_error if any write failed.
+        void finish();
+
+    private:
+        std::ostream& out_;
+        bool compact_;
+        size_t written_ = 0;
+    };
+
+    // Unbuffered-to-buffered adapter so a std::ostream can write straight to a file descriptor.
+    class FdOutputBuffer : public std::streambuf {
+    public:
+        explicit FdOutputBuffer(int fd, size_t bufferSize = 1 << 16);
+        ~FdOutputBuffer() override;
+
+    protected:
+        int_type overflow(int_type c) override;
+        int sync() override;
+
+    private:
+        bool drain();
+
+        int fd_;
+        std::vector<char> buffer_;
+    };
+} // namespace SPHINXStore
+
+#endif // SPHINXJSONEXPORT_HPP
@@ -0,0 +1,177 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the JSON import path of the SPHINX chain.
+
+// Scanning:
+    // A chain document is scanned once, byte by byte, to find the range of every element of "blocks"; strings, escapes and nesting are tracked but no DOM is built.
+    // Knowing every range up front lets the blocks be decoded independently.
+
+// Decoding:
+    // Eager imports decode the ranges in parallel chunks on the shared thread pool into a vector reserved to the final size.
+    // Lazy imports keep the text and the ranges (JsonBlockSource) and decode a block when it is first accessed.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <stdexcept>
+
+#include "JsonImport.hpp"
+#include "ThreadPool.hpp"
+#include "json.hpp"
+
+namespace SPHINXStore {
+
+    namespace {
+        class Scanner {
+        public:
+            explicit Scanner(std::string_view text) : text_(text) {}
+
+            void skipSpace() {
+                while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\n' || text_[pos_] == '\r' || text_[pos_] == '\t')) {
+                    ++pos_;
+                }
+            }
+
+            bool consume(char c) {
+                skipSpace();
+                if (pos_ < text_.size() && text_[pos_] == c) {
+                    ++pos_;
+                    return true;
+                }
+                return false;
+            }
+
+            void expect(char c) {
+                if (!consume(c)) {
+                    fail(std::string("expected '") + c + "'");
+                }
+            }
+
+            // Skip a string starting at the current quote and return its raw contents
+            std::string_view string() {
+                skipSpace();
+                if (pos_ >= text_.size() || text_[pos_] != '"') {
+                    fail("expected a string");
+                }
+                const size_t start = ++pos_;
+                while (pos_ < text_.size() && text_[pos_] != '"') {
+                    pos_ += (text_[pos_] == '\\') ? 2 : 1;
+                }
+                if (pos_ >= text_.size()) {
+                    fail("unterminated string");
+                }
+                return text_.substr(start, pos_++ - start);
+            }
+
+            // Skip one value and return its range
+            JsonRange value() {
+                skipSpace();
+                const size_t start = pos_;
+                if (pos_ >= text_.size()) {
+                    fail("unexpected end of document");
+                }
+                if (text_[pos_] == '"') {
+                    string();
+                } else if (text_[pos_] == '{' || text_[pos_] == '[') {
+                    size_t depth = 0;
+                    do {
+                        const char c = text_[pos_];
+                        if (c == '"') {
+                            string();
+                            continue;
+                        }
+                        depth += (c == '{' || c == '[');
+                        depth -= (c == '}' || c == ']');
+                        ++pos_;
+                    } while (depth > 0 && pos_ < text_.size());
+                    if (depth > 0) {
+                        fail("unterminated object or array");
+                    }
+                } else {
+                    while (pos_ < text_.size() && text_[pos_] != ',' && text_[pos_] != '}' && text_[pos_] != ']' &&
+                           text_[pos_] != ' ' && text_[pos_] != '\n' && text_[pos_] != '\r' && text_[pos_] != '\t') {
+                        ++pos_;
+                    }
+                }
+                return JsonRange(start, pos_);
+            }
+
+            [[noreturn]] void fail(const std::string& reason) const {
+                throw std::runtime_error("Malformed chain JSON at byte " + std::to_string(pos_) + ": " + reason);
+            }
+
+        private:
+            std::string_view text_;
+            size_t pos_ = 0;
+        };
+    } // namespace
+
+    // Locate the blocks and the public key of a chain document
+    JsonChainLayout scanChainJson(std::string_view text) {
+        JsonChainLayout layout;
+        Scanner scanner(text);
+        scanner.expect('{');
+        if (scanner.consume('}')) {
+            return layout;
+        }
+        do {
+            const std::string_view key = scanner.string();
+            scanner.expect(':');
+            if (key == "blocks") {
+                scanner.expect('[');
+                if (!scanner.consume(']')) {
+                    do {
+                        layout.blocks.push_back(scanner.value());
+                    } while (scanner.consume(','));
+                    scanner.expect(']');
+                }
+            } else if (key == "SPHINXPubKey") {
+                layout.publicKey = scanner.value();
+            } else {
+                scanner.value();  // Unknown member, ignored like fromJson does
+            }
+        } while (scanner.consume(','));
+        scanner.expect('}');
+        return layout;
+    }
+
+    // Decode one block from its JSON text
+    SPHINXBlock::Block decodeJsonBlock(std::string_view blockText) {
+        SPHINXBlock::Block block("");
+        block.fromJson(nlohmann::json::parse(blockText.begin(), blockText.end()));
+        return block;
+    }
+
+    // Keep the document and take every block hash in parallel
+    std::shared_ptr<JsonBlockSource> JsonBlockSource::create(std::string text, std::vector<JsonRange> ranges, size_t grain) {
+        std::shared_ptr<JsonBlockSource> source(new JsonBlockSource());
+        source->text_ = std::move(text);
+        source->ranges_ = std::move(ranges);
+        source->hashes_.resize(source->ranges_.size());
+        const JsonBlockSource& self = *source;
+        SPHINXPool::ThreadPool::shared().parallelFor(0, self.ranges_.size(), grain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                source->hashes_[i] = self.decodeBlock(i).getBlockHash();  // The decoded block is dropped right away
+            }
+        });
+        return source;
+    }
+
+    // Decode a block from its range of the document
+    SPHINXBlock::Block JsonBlockSource::decodeBlock(size_t index) const {
+        const JsonRange& range = ranges_[index];
+        return decodeJsonBlock(std::string_view(text_).substr(range.first, range.second - range.first));
+    }
+} // namespace SPHINXStore
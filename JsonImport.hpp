@@ -0,0 +1,72 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXJSONIMPORT_HPP
+#define SPHINXJSONIMPORT_HPP
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Block.hpp"
+#include "BlockStore.hpp"
+
+namespace SPHINXStore {
+
+    // How a JSON chain document is imported.
+    struct JsonImportOptions {
+        bool lazy = false;  // Keep blocks as undecoded JSON text and decode each one on first access
+        size_t grain = 64;  // Blocks per decoding task
+    };
+
+    // Byte range [first, second) of one value in a JSON document.
+    using JsonRange = std::pair<size_t, size_t>;
+
+    // Top-level layout of a chain document ({"blocks": [...], "SPHINXPubKey": "..."}), found without building a DOM.
+    struct JsonChainLayout {
+        std::vector<JsonRange> blocks;  // One range per element of "blocks"
+        JsonRange publicKey{0, 0};  // Range of the "SPHINXPubKey" value (a JSON string), empty if absent
+    };
+
+    // Scan a chain document and locate its blocks; throws std::runtime_error on malformed JSON.
+    JsonChainLayout scanChainJson(std::string_view text);
+
+    // Decode the block whose JSON text is given.
+    SPHINXBlock::Block decodeJsonBlock(std::string_view blockText);
+
+    // Blocks kept as ranges of the original JSON text and decoded on access. Hashes are taken once at import (in
+    // parallel, see JsonImportOptions::grain) because the hash index needs them; the decoded blocks are not kept.
+    class JsonBlockSource : public BlockSource {
+    public:
+        static std::shared_ptr<JsonBlockSource> create(std::string text, std::vector<JsonRange> ranges, size_t grain);
+
+        size_t size() const override { return ranges_.size(); }
+        std::string_view blockHash(size_t index) const override { return hashes_[index]; }
+        SPHINXBlock::Block decodeBlock(size_t index) const override;
+
+    private:
+        JsonBlockSource() = default;
+
+        std::string text_;  // The whole document; blocks are views into it
+        std::vector<JsonRange> ranges_;
+        std::vector<std::string> hashes_;
+    };
+} // namespace SPHINXStore
+
+#endif // SPHINXJSONIMPORT_HPP
@@ -0,0 +1,108 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the key manager that holds the signing identity of a SPHINX chain.
+
+// Loading:
+    // The keypair is loaded from the key file on first use; if there is no key file yet, one hybrid keypair is generated and stored so the chain keeps its identity across restarts.
+    // Loading happens exactly once per manager (std::call_once), even when several threads sign concurrently.
+
+// Signing:
+    // The encoded private key and the merged Curve448 + Kyber public key are computed once and cached; every signature reuses them instead of generating a new keypair.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "KeyManager.hpp"
+#include "Sign.hpp"
+#include "json.hpp"
+
+namespace SPHINXKeys {
+
+    KeyManager::KeyManager(std::string keyFilename) : keyFilename_(std::move(keyFilename)) {
+    }
+
+    // Sign data with the cached private key
+    std::string KeyManager::sign(const std::string& data) {
+        ensureLoaded();
+        signatures_.fetch_add(1, std::memory_order_relaxed);
+        return SPHINXSign::signTransactionData(data, privateKey_);
+    }
+
+    // Get the cached public key
+    const SPHINXKey::SPHINXPubKey& KeyManager::publicKey() {
+        ensureLoaded();
+        return publicKey_;
+    }
+
+    // Get the cached encoded public key
+    const std::string& KeyManager::encodedPublicKey() {
+        ensureLoaded();
+        return encodedPublicKey_;
+    }
+
+    // Get the cached encoded private key
+    const std::string& KeyManager::privateKey() {
+        ensureLoaded();
+        return privateKey_;
+    }
+
+    void KeyManager::ensureLoaded() {
+        std::call_once(loaded_, [this] { loadOrGenerate(); });
+    }
+
+    // Read the key file, or generate a keypair and write it
+    void KeyManager::loadOrGenerate() {
+        if (!keyFilename_.empty()) {
+            std::ifstream input(keyFilename_);
+            if (input.is_open()) {
+                const nlohmann::json keyJson = nlohmann::json::parse(input);
+                privateKey_ = keyJson.at("privateKey").get<std::string>();
+                encodedPublicKey_ = keyJson.at("publicKey").get<std::string>();
+                publicKey_ = SPHINXHybridKey::sphinxKeyFromString(encodedPublicKey_);
+                return;
+            }
+        }
+
+        SPHINXHybridKey::HybridKeypair keyPair = SPHINXKey::generate_hybrid_keypair();  // The only keygen of this manager
+        generations_.fetch_add(1, std::memory_order_relaxed);
+        privateKey_ = SPHINXKey::sphinxKeyToString(keyPair.merged_key.sphinxPrivKey);
+        publicKey_ = SPHINXKey::mergePublicKeys(keyPair.merged_key.curve448_public_key, keyPair.merged_key.kyber_public_key);
+        encodedPublicKey_ = SPHINXHybridKey::sphinxKeyToString(publicKey_);
+
+        if (!keyFilename_.empty()) {
+            nlohmann::json keyJson;
+            keyJson["privateKey"] = privateKey_;
+            keyJson["publicKey"] = encodedPublicKey_;
+            const std::string contents = keyJson.dump();
+            const std::string tmpFilename = keyFilename_ + ".tmp";
+            const int fd = ::open(tmpFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);  // Private key: owner only
+            bool written = fd >= 0 && ::write(fd, contents.data(), contents.size()) == static_cast<ssize_t>(contents.size()) && ::fsync(fd) == 0;
+            if (fd >= 0) {
+                written = (::close(fd) == 0) && written;
+            }
+            if (!written || std::rename(tmpFilename.c_str(), keyFilename_.c_str()) != 0) {
+                throw std::runtime_error("Failed to write key file: " + keyFilename_);
+            }
+        }
+    }
+} // namespace SPHINXKeys
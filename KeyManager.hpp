@@ -0,0 +1,73 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXKEYMANAGER_HPP
+#define SPHINXKEYMANAGER_HPP
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "Key.hpp"
+
+namespace SPHINXKeys {
+
+    // Signing identity of a chain. The hybrid keypair is loaded from the key file or generated once, on first use,
+    // and the encoded private key and the merged public key are cached, so signing never runs post-quantum keygen.
+    // Thread-safe: any number of threads may sign at the same time.
+    class KeyManager {
+    public:
+        // Keys are read from keyFilename if it exists, otherwise generated and written there (mode 0600).
+        // With an empty filename the keys are generated and kept in memory only.
+        explicit KeyManager(std::string keyFilename = "");
+
+        KeyManager(const KeyManager&) = delete;
+        KeyManager& operator=(const KeyManager&) = delete;
+
+        // Sign data with the chain's private key.
+        std::string sign(const std::string& data);
+
+        // Public key matching sign().
+        const SPHINXKey::SPHINXPubKey& publicKey();
+
+        // Encoded public key (sphinxKeyToString form), e.g. for signature cache keys.
+        const std::string& encodedPublicKey();
+
+        // Encoded private key, as expected by SPHINXSign::signTransactionData.
+        const std::string& privateKey();
+
+        // Number of signatures made, for measuring signatures/sec.
+        uint64_t signatureCount() const { return signatures_.load(std::memory_order_relaxed); }
+
+        // Number of keypairs generated (0 or 1 over the lifetime of the manager).
+        uint64_t keyGenerations() const { return generations_.load(std::memory_order_relaxed); }
+
+    private:
+        void ensureLoaded();
+        void loadOrGenerate();
+
+        std::string keyFilename_;
+        std::once_flag loaded_;
+        std::string privateKey_;  // Written once under loaded_, read-only afterwards
+        SPHINXKey::SPHINXPubKey publicKey_;
+        std::string encodedPublicKey_;
+        std::atomic<uint64_t> signatures_{0};
+        std::atomic<uint64_t> generations_{0};
+    };
+} // namespace SPHINXKeys
+
+#endif // SPHINXKEYMANAGER_HPP
@@ -0,0 +1,253 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the balance ledger used by the SPHINX chain and its shards.
+
+// Fixed-Point Amounts:
+    // Balances are 64-bit integers counting 1e-8 SPX units. Adding and subtracting is exact, so repeated updateBalance calls no longer drift the way doubles do.
+    // Overflow is detected and reported instead of wrapping.
+
+// Address Interning:
+    // Every address string is stored once in a contiguous arena and mapped to a dense 32-bit id through an open-addressing hash table with linear probing.
+    // A table slot is 8 bytes (id + 32 hash bits), so a lookup usually touches one cache line and compares the address bytes only when the hash bits match.
+
+// Balances:
+    // Balances live in a dense array indexed by address id: no per-account heap node, no bucket pointers.
+
+// Copies:
+    // The table, the arena, the address refs and the balances are kept in chunks shared between copies (ChunkedArray). A copy for a read view costs a pointer per chunk instead of the whole ledger, and the writer copies a chunk only the first time it writes to it after the copy, so publishing a view costs the chunks touched since the last one.
+
+// State Commitment:
+    // Once a root or proof has been asked for, add() records the changed id (once) and the state tree is brought up to date lazily, so a burst of updates to the same account is hashed once.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+#include "Ledger.hpp"
+
+namespace SPHINXLedger {
+
+    namespace {
+        constexpr size_t INITIAL_SLOTS = 64;
+
+        uint64_t hashAddress(std::string_view address) {
+            uint64_t hash = std::hash<std::string_view>{}(address);
+            return hash ^ (hash >> 29);  // Mix the high bits into the low ones used for the slot index
+        }
+    } // namespace
+
+    // Convert a decimal amount to fixed point
+    Amount toAmount(double value) {
+        const double scaled = std::round(value * static_cast<double>(AMOUNT_SCALE));
+        if (!std::isfinite(scaled) || std::fabs(scaled) >= 9.2e18) {
+            throw std::out_of_range("Amount out of range");
+        }
+        return static_cast<Amount>(scaled);
+    }
+
+    // Convert a fixed-point amount to a decimal value
+    double toDouble(Amount amount) {
+        return static_cast<double>(amount) / static_cast<double>(AMOUNT_SCALE);
+    }
+
+    // Find the slot holding an address, or the empty slot where it would go
+    size_t Ledger::findSlot(std::string_view address, uint64_t hash) const {
+        const size_t mask = slots_.size() - 1;
+        const uint32_t tag = static_cast<uint32_t>(hash >> 32);
+        for (size_t index = hash & mask;; index = (index + 1) & mask) {
+            const Slot& slot = slots_[index];
+            if (slot.id == NO_ADDRESS || (slot.tag == tag && this->address(slot.id) == address)) {
+                return index;
+            }
+        }
+    }
+
+    // Double the table and reinsert every id
+    void Ledger::grow() {
+        const ChunkedArray<Slot, SLOT_CHUNK> previous = std::move(slots_);
+        slots_ = ChunkedArray<Slot, SLOT_CHUNK>();
+        slots_.resize(previous.empty() ? INITIAL_SLOTS : previous.size() * 2);  // Every new slot is empty
+        const size_t mask = slots_.size() - 1;
+        for (size_t i = 0; i < previous.size(); ++i) {
+            const Slot& slot = previous[i];
+            if (slot.id == NO_ADDRESS) {
+                continue;
+            }
+            const uint64_t hash = hashAddress(address(slot.id));
+            size_t index = hash & mask;
+            while (slots_[index].id != NO_ADDRESS) {
+                index = (index + 1) & mask;
+            }
+            slots_.mutableAt(index) = slot;
+        }
+    }
+
+    // Get or create the id of an address
+    AddressId Ledger::intern(std::string_view address) {
+        if ((balances_.size() + 1) * 10 > slots_.size() * 7) {
+            grow();  // Keep the load factor under 70% so probe sequences stay short
+        }
+        const uint64_t hash = hashAddress(address);
+        const size_t index = findSlot(address, hash);
+        if (slots_[index].id != NO_ADDRESS) {
+            return slots_[index].id;
+        }
+        if (address.size() > MAX_ADDRESS_LENGTH) {
+            throw std::length_error("Address longer than " + std::to_string(MAX_ADDRESS_LENGTH) + " bytes");
+        }
+        size_t offset = arena_.size();
+        if (offset % ARENA_CHUNK + address.size() > ARENA_CHUNK) {
+            offset += ARENA_CHUNK - offset % ARENA_CHUNK;  // Start the next chunk so the address stays contiguous
+        }
+        if (balances_.size() >= NO_ADDRESS || offset + address.size() > std::numeric_limits<uint32_t>::max()) {
+            throw std::length_error("Ledger address table is full");
+        }
+
+        const AddressId id = static_cast<AddressId>(balances_.size());
+        arena_.resize(offset + address.size());
+        if (!address.empty()) {
+            std::memcpy(&arena_.mutableAt(offset), address.data(), address.size());
+        }
+        addresses_.push_back(AddressRef{static_cast<uint32_t>(offset), static_cast<uint32_t>(address.size())});
+        balances_.push_back(0);
+        slots_.mutableAt(index) = Slot{id, static_cast<uint32_t>(hash >> 32)};
+        markChanged(id);  // A new account is a new (zero) leaf of the state tree
+        return id;
+    }
+
+    // Look up the id of an address without adding it
+    AddressId Ledger::find(std::string_view address) const {
+        if (slots_.empty()) {
+            return NO_ADDRESS;
+        }
+        return slots_[findSlot(address, hashAddress(address))].id;
+    }
+
+    // Get the address string of an id
+    std::string_view Ledger::address(AddressId id) const {
+        const AddressRef ref = addresses_[id];
+        return ref.length == 0 ? std::string_view() : std::string_view(&arena_[ref.offset], ref.length);
+    }
+
+    // Apply a delta to a balance with overflow checking
+    void Ledger::add(AddressId id, Amount delta) {
+        if (id >= balances_.size()) {
+            throw std::out_of_range("Unknown ledger address id");
+        }
+        Amount result;
+        if (__builtin_add_overflow(balances_[id], delta, &result)) {
+            throw std::overflow_error("Balance overflow for address " + std::string(address(id)));
+        }
+        balances_.mutableAt(id) = result;
+        markChanged(id);
+    }
+
+    // Replace a balance
+    void Ledger::set(AddressId id, Amount amount) {
+        if (id >= balances_.size()) {
+            throw std::out_of_range("Unknown ledger address id");
+        }
+        balances_.mutableAt(id) = amount;
+        markChanged(id);
+    }
+
+    // Remember that a balance has to be rehashed into the state tree
+    void Ledger::markChanged(AddressId id) {
+        if (!committed_) {
+            return;  // No commitment requested yet, the tree is built from scratch on first use
+        }
+        if (id >= changedFlags_.size()) {
+            changedFlags_.resize(balances_.size(), 0);
+        }
+        if (!changedFlags_[id]) {
+            changedFlags_[id] = 1;
+            changed_.push_back(id);
+        }
+    }
+
+    // Build the state tree, or rehash the balances changed since the last call
+    void Ledger::syncStateTree() const {
+        if (!committed_) {
+            stateTree_.clear();
+            for (AddressId id = 0; id < balances_.size(); ++id) {
+                stateTree_.update(address(id), balances_[id]);
+            }
+            changedFlags_.assign(balances_.size(), 0);
+            committed_ = true;
+            return;
+        }
+        for (AddressId id : changed_) {
+            stateTree_.update(address(id), balances_[id]);  // The current balance, so rolled-back changes are handled too
+            changedFlags_[id] = 0;
+        }
+        changed_.clear();
+    }
+
+    // Get the root of the state commitment
+    std::string Ledger::stateRoot() const {
+        syncStateTree();
+        return stateTree_.root();
+    }
+
+    // Prove the balance of an address against the state root
+    StateProof Ledger::prove(std::string_view address) const {
+        syncStateTree();
+        return stateTree_.prove(address);
+    }
+
+    // Apply coalesced deltas atomically: check every result first, then commit, undoing the commit if it is interrupted
+    void Ledger::applyBatch(std::span<const BalanceDelta> deltas) {
+        for (const BalanceDelta& delta : deltas) {
+            Amount result;
+            if (__builtin_add_overflow(balance(delta.first), delta.second, &result)) {
+                throw std::overflow_error("Balance overflow for address " + std::string(delta.first));
+            }
+        }
+
+        size_t applied = 0;
+        try {
+            for (; applied < deltas.size(); ++applied) {
+                add(intern(deltas[applied].first), deltas[applied].second);  // Only intern() can still fail (allocation)
+            }
+        } catch (...) {
+            while (applied > 0) {
+                --applied;
+                balances_.mutableAt(find(deltas[applied].first)) -= deltas[applied].second;
+            }
+            throw;
+        }
+    }
+
+    // Share the address table and balances; the state tree is left out and rebuilt by the copy if it is ever asked for
+    Ledger Ledger::copyAccounts() const {
+        Ledger copy;
+        copy.slots_ = slots_;
+        copy.arena_ = arena_;
+        copy.addresses_ = addresses_;
+        copy.balances_ = balances_;
+        return copy;
+    }
+
+    // Get the heap bytes used by the ledger
+    size_t Ledger::memoryUsage() const {
+        return slots_.memoryUsage() + arena_.memoryUsage() + addresses_.memoryUsage() + balances_.memoryUsage() +
+               changed_.capacity() * sizeof(AddressId) + changedFlags_.capacity();
+    }
+} // namespace SPHINXLedger
@@ -0,0 +1,191 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXLEDGER_HPP
+#define SPHINXLEDGER_HPP
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "StateTree.hpp"
+
+namespace SPHINXLedger {
+
+    // Balance in fixed-point units: 1 SPX = AMOUNT_SCALE units, so sums never lose precision.
+    using Amount = int64_t;
+    constexpr Amount AMOUNT_SCALE = 100000000;  // 8 decimal places
+
+    // Balance change of one address.
+    using BalanceDelta = std::pair<std::string_view, Amount>;
+
+    // Interned address: a dense index into the ledger's address table.
+    using AddressId = uint32_t;
+    constexpr AddressId NO_ADDRESS = std::numeric_limits<AddressId>::max();
+
+    // Convert a decimal amount to fixed point (rounded to the nearest unit); throws if it does not fit.
+    Amount toAmount(double value);
+
+    // Convert a fixed-point amount back to a decimal value.
+    double toDouble(Amount amount);
+
+    // Array kept in fixed-size chunks that copies share: copying costs one pointer per chunk, and a write copies only
+    // the chunk it lands in, and only while another copy still holds it. One thread writes a given copy; copies handed
+    // to readers are never written, so the readers need no lock.
+    template <typename T, size_t ChunkSize>
+    class ChunkedArray {
+        using Chunk = std::array<T, ChunkSize>;
+
+    public:
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        const T& operator[](size_t index) const { return (*chunks_[index / ChunkSize])[index % ChunkSize]; }
+
+        // Writable element; the chunk is copied first if another copy of the array shares it.
+        T& mutableAt(size_t index) {
+            std::shared_ptr<Chunk>& chunk = chunks_[index / ChunkSize];
+            if (chunk.use_count() > 1) {
+                chunk = std::make_shared<Chunk>(*chunk);
+            } else {
+                std::atomic_thread_fence(std::memory_order_acquire);  // Pairs with the release of the last other owner
+            }
+            return (*chunk)[index % ChunkSize];
+        }
+
+        // Grow to count elements; new elements are value-initialized.
+        void resize(size_t count) {
+            while (chunks_.size() * ChunkSize < count) {
+                chunks_.push_back(std::make_shared<Chunk>());
+            }
+            size_ = std::max(size_, count);
+        }
+
+        void push_back(const T& value) {
+            resize(size_ + 1);
+            mutableAt(size_ - 1) = value;
+        }
+
+        // Heap bytes held, counting shared chunks in full.
+        size_t memoryUsage() const { return chunks_.capacity() * sizeof(std::shared_ptr<Chunk>) + chunks_.size() * sizeof(Chunk); }
+
+    private:
+        std::vector<std::shared_ptr<Chunk>> chunks_;
+        size_t size_ = 0;
+    };
+
+    // Longest address the ledger stores; an address never straddles two chunks of the address arena.
+    constexpr size_t MAX_ADDRESS_LENGTH = 4096;
+
+    // Account balances keyed by address. Every address is stored once in a contiguous arena and gets a fixed-width id
+    // through an open-addressing hash table; balances are a dense array indexed by that id. All of it is chunked and
+    // shared between copies, so a copy costs a pointer per chunk and the original then copies only the chunks it writes.
+    class Ledger {
+    public:
+        // Get the id of an address, adding the address with a zero balance if it is new; throws std::length_error for
+        // an address longer than MAX_ADDRESS_LENGTH.
+        AddressId intern(std::string_view address);
+
+        // Get the id of an address, or NO_ADDRESS if it has never been seen.
+        AddressId find(std::string_view address) const;
+
+        // Get the address of an id.
+        std::string_view address(AddressId id) const;
+
+        // Add a (possibly negative) amount to a balance; throws on overflow.
+        void add(AddressId id, Amount delta);
+        void add(std::string_view address, Amount delta) { add(intern(address), delta); }
+
+        // Overwrite a balance, e.g. to put back a value saved before a change (UndoLog.hpp).
+        void set(AddressId id, Amount amount);
+
+        // Apply a set of balance changes all-or-nothing: if any change would overflow, nothing is applied.
+        // Every address must appear at most once (coalesce the deltas first).
+        void applyBatch(std::span<const BalanceDelta> deltas);
+
+        // Get a balance (zero for unknown addresses).
+        Amount balance(AddressId id) const { return id < balances_.size() ? balances_[id] : 0; }
+        Amount balance(std::string_view address) const { return balance(find(address)); }
+
+        // Number of addresses in the ledger.
+        size_t accountCount() const { return balances_.size(); }
+
+        // Copy of the accounts and balances without the commitment cache, for read-only snapshots of the balances. The
+        // chunks are shared, so it costs a pointer per chunk, and later writes here copy only the chunks they touch.
+        Ledger copyAccounts() const;
+
+        // Heap bytes used by the ledger, for sizing (bytes per account = memoryUsage() / accountCount()).
+        size_t memoryUsage() const;
+
+        // Root of the sparse Merkle commitment over every balance (StateTree.hpp). The tree is built on first use and
+        // kept up to date from then on: a changed balance costs O(log n) hashes the next time a root or proof is asked for.
+        std::string stateRoot() const;
+
+        // Proof of the balance of an address against stateRoot().
+        StateProof prove(std::string_view address) const;
+
+        // Visit every account in id order as fn(address, amount).
+        template <typename Fn>
+        void forEach(Fn&& fn) const {
+            for (AddressId id = 0; id < balances_.size(); ++id) {
+                fn(address(id), balances_[id]);
+            }
+        }
+
+    private:
+        struct Slot {
+            AddressId id = NO_ADDRESS;  // Empty slot when NO_ADDRESS
+            uint32_t tag = 0;  // High hash bits, compared before the address bytes
+        };
+
+        // Where the bytes of an address sit in the arena.
+        struct AddressRef {
+            uint32_t offset = 0;
+            uint32_t length = 0;
+        };
+
+        static constexpr size_t SLOT_CHUNK = 1024;
+        static constexpr size_t ARENA_CHUNK = MAX_ADDRESS_LENGTH;
+        static constexpr size_t ACCOUNT_CHUNK = 512;
+
+        size_t findSlot(std::string_view address, uint64_t hash) const;
+        void grow();
+        void markChanged(AddressId id);
+        void syncStateTree() const;
+
+        ChunkedArray<Slot, SLOT_CHUNK> slots_;  // Open-addressing table (linear probing, power-of-two size)
+        ChunkedArray<char, ARENA_CHUNK> arena_;  // Every address, back to back; one that would straddle a chunk starts the next
+        ChunkedArray<AddressRef, ACCOUNT_CHUNK> addresses_;  // Address id -> bytes in arena_
+        ChunkedArray<Amount, ACCOUNT_CHUNK> balances_;  // Address id -> balance
+
+        // Commitment cache; like the rest of the ledger it is not thread-safe, callers serialize access
+        mutable bool committed_ = false;  // stateTree_ has been built and changes are tracked
+        mutable StateTree stateTree_;
+        mutable std::vector<AddressId> changed_;  // Ids changed since the tree was last brought up to date
+        mutable std::vector<uint8_t> changedFlags_;  // Address id -> listed in changed_
+    };
+} // namespace SPHINXLedger
+
+#endif // SPHINXLEDGER_HPP
@@ -0,0 +1,403 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the pool of pending transactions used to fill blocks.
+
+// Indexes:
+    // Entries live in a slot vector reused through a free list; the id index maps the 32-byte binary digest of the id to a slot.
+    // Each sender has a nonce-ordered map of its slots and the running total it would spend, which is checked against its balance on every add (double-spend detection).
+    // A binary min-heap of slots ordered by fee rate (fee / encoded size, compared by compareFeeRates with overflow-checked 64-bit cross products) records each slot's position, so any entry can be removed in O(log n).
+
+// Eviction:
+    // When the pool is over its transaction or byte budget, the cheapest transaction goes first together with the later nonces of its sender, which could not be mined without it.
+
+// Selection:
+    // The lowest pending nonce of every sender is kept in a set ordered by fee rate, updated when a sender's first transaction changes. selectForBlock walks that set from the best rate and merges it with a small heap of follow-up nonces: taking a transaction makes the sender's next nonce a candidate.
+    // A transaction that does not fit drops its sender from this block, since its later nonces depend on it. After MAX_SELECT_MISSES misses in a row the block counts as full, so a nearly full block does not scan every sender.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <algorithm>
+#include <utility>
+
+#include "Mempool.hpp"
+
+namespace SPHINXTxPool {
+
+    namespace {
+        // Exact comparison of fee / size between two transactions
+        bool lowerRate(const PoolEntry& a, const PoolEntry& b) {
+            return compareFeeRates(a.fee, a.size, b.fee, b.size) < 0;
+        }
+    } // namespace
+
+    int compareFeeRates(SPHINXLedger::Amount feeA, uint64_t sizeA, SPHINXLedger::Amount feeB, uint64_t sizeB, uint64_t scaleA, uint64_t scaleB) {
+        const uint64_t unsignedA = static_cast<uint64_t>(feeA);
+        const uint64_t unsignedB = static_cast<uint64_t>(feeB);
+        uint64_t left;
+        uint64_t right;
+        if (!__builtin_mul_overflow(unsignedA, sizeB, &left) && !__builtin_mul_overflow(left, scaleA, &left) &&
+            !__builtin_mul_overflow(unsignedB, sizeA, &right) && !__builtin_mul_overflow(right, scaleB, &right)) {
+            return (left > right) - (left < right);
+        }
+        // Past 64 bits the products are compared as long double, which only loses precision beyond any realistic fee
+        const long double wideLeft = static_cast<long double>(unsignedA) * sizeB * scaleA;
+        const long double wideRight = static_cast<long double>(unsignedB) * sizeA * scaleB;
+        return (wideLeft > wideRight) - (wideLeft < wideRight);
+    }
+
+    const char* toString(AddResult result) {
+        switch (result) {
+            case AddResult::Added: return "Added";
+            case AddResult::Replaced: return "Replaced";
+            case AddResult::Duplicate: return "Duplicate";
+            case AddResult::NonceConflict: return "NonceConflict";
+            case AddResult::InsufficientBalance: return "InsufficientBalance";
+            case AddResult::PoolFull: return "PoolFull";
+            case AddResult::TooLarge: return "TooLarge";
+        }
+        return "Unknown";
+    }
+
+    TransactionPool::TransactionPool(PoolOptions options) : options_(options) {
+        options_.maxTransactions = std::max<size_t>(options_.maxTransactions, 1);
+    }
+
+    // Admit a transaction after the duplicate, nonce and balance checks, then trim the pool back to its budget
+    AddResult TransactionPool::add(PoolEntry entry, SPHINXLedger::Amount senderBalance, bool assignNonce) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const SPHINXIndex::BlockDigest digest = SPHINXIndex::toDigest(entry.id);
+        if (byId_.count(digest) > 0) {
+            ++counters_.rejected;
+            return AddResult::Duplicate;
+        }
+        if (entry.size > options_.maxBytes) {
+            ++counters_.rejected;
+            return AddResult::TooLarge;
+        }
+        SPHINXLedger::Amount spend;
+        if (entry.amount < 0 || entry.fee < 0 || __builtin_add_overflow(entry.amount, entry.fee, &spend)) {
+            ++counters_.rejected;
+            return AddResult::InsufficientBalance;
+        }
+
+        // Same sender and nonce: only a clearly better fee rate replaces the pending transaction
+        uint32_t replaced = NOT_IN_HEAP;
+        SPHINXLedger::Amount pending = 0;
+        auto account = bySender_.find(entry.sender);
+        if (assignNonce) {
+            entry.nonce = account == bySender_.end() ? 0 : account->second.byNonce.rbegin()->first + 1;
+        }
+        if (account != bySender_.end()) {
+            pending = account->second.pending;
+            auto sameNonce = account->second.byNonce.find(entry.nonce);
+            if (sameNonce != account->second.byNonce.end()) {
+                const PoolEntry& previous = slots_[sameNonce->second].entry;
+                // Replace only if fee / size beats the previous rate by replaceBumpPercent
+                if (compareFeeRates(entry.fee, entry.size, previous.fee, previous.size, 100, 100 + options_.replaceBumpPercent) <= 0) {
+                    ++counters_.rejected;
+                    return AddResult::NonceConflict;
+                }
+                replaced = sameNonce->second;
+                pending -= previous.amount + previous.fee;
+            }
+        }
+        SPHINXLedger::Amount total;
+        if (__builtin_add_overflow(pending, spend, &total) || total > senderBalance) {
+            ++counters_.rejected;
+            return AddResult::InsufficientBalance;
+        }
+
+        if (replaced != NOT_IN_HEAP) {
+            erase(replaced);
+        }
+        const uint32_t slot = insert(std::move(entry), digest);
+
+        // Over budget: evict the cheapest transactions (with their sender's later nonces), possibly the new one
+        while (count_ > options_.maxTransactions || bytes_ > options_.maxBytes) {
+            counters_.evicted += evictFrom(feeHeap_.front());
+        }
+        if (!slots_[slot].used || slots_[slot].digest != digest) {
+            ++counters_.rejected;
+            return AddResult::PoolFull;
+        }
+        ++counters_.added;
+        if (replaced != NOT_IN_HEAP) {
+            ++counters_.replaced;
+            return AddResult::Replaced;
+        }
+        return AddResult::Added;
+    }
+
+    bool TransactionPool::contains(std::string_view id) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return byId_.count(SPHINXIndex::toDigest(id)) > 0;
+    }
+
+    std::optional<PoolEntry> TransactionPool::find(std::string_view id) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = byId_.find(SPHINXIndex::toDigest(id));
+        if (it == byId_.end()) {
+            return std::nullopt;
+        }
+        return slots_[it->second].entry;
+    }
+
+    uint64_t TransactionPool::nextNonce(std::string_view sender) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto account = bySender_.find(std::string(sender));
+        return account == bySender_.end() ? 0 : account->second.byNonce.rbegin()->first + 1;
+    }
+
+    // Remove the transactions of a block
+    size_t TransactionPool::remove(std::span<const std::string> ids) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t removed = 0;
+        for (const std::string& id : ids) {
+            auto it = byId_.find(SPHINXIndex::toDigest(id));
+            if (it != byId_.end()) {
+                erase(it->second);
+                ++removed;
+            }
+        }
+        counters_.removed += removed;
+        return removed;
+    }
+
+    // Evict the newest transactions of every sender whose pending spend exceeds its balance
+    size_t TransactionPool::dropUnaffordable(const std::function<SPHINXLedger::Amount(std::string_view sender)>& balanceOf) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::string> overdrawn;
+        for (const auto& [sender, account] : bySender_) {
+            if (account.pending > balanceOf(sender)) {
+                overdrawn.push_back(sender);
+            }
+        }
+        size_t evicted = 0;
+        for (const std::string& sender : overdrawn) {
+            const SPHINXLedger::Amount balance = balanceOf(sender);
+            for (auto account = bySender_.find(sender); account != bySender_.end() && account->second.pending > balance; account = bySender_.find(sender)) {
+                erase(account->second.byNonce.rbegin()->second);  // Erases the account with its last transaction
+                ++evicted;
+            }
+        }
+        counters_.evicted += evicted;
+        return evicted;
+    }
+
+    // Greedy fee-rate selection: the best remaining sender head or follow-up nonce, until the block is full
+    std::vector<PoolEntry> TransactionPool::selectForBlock(size_t maxBytes) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const BetterHead better;
+        const auto worse = [&better](const Head& a, const Head& b) { return better(b, a); };
+        std::vector<Head> followers;  // Max-heap of next nonces of senders already in the block
+
+        std::vector<PoolEntry> selected;
+        size_t remaining = maxBytes;
+        size_t misses = 0;
+        auto head = heads_.begin();
+        while (remaining > 0 && misses < MAX_SELECT_MISSES) {
+            Head best;
+            if (!followers.empty() && (head == heads_.end() || better(followers.front(), *head))) {
+                std::pop_heap(followers.begin(), followers.end(), worse);
+                best = followers.back();
+                followers.pop_back();
+            } else if (head != heads_.end()) {
+                best = *head++;
+            } else {
+                break;
+            }
+            const PoolEntry& entry = slots_[best.slot].entry;
+            if (entry.size > remaining) {
+                ++misses;
+                continue;  // The sender's later nonces cannot go in without this one
+            }
+            misses = 0;
+            selected.push_back(entry);
+            remaining -= entry.size;
+
+            const Account& account = bySender_.find(entry.sender)->second;
+            auto next = account.byNonce.upper_bound(entry.nonce);
+            if (next != account.byNonce.end() && next->first == entry.nonce + 1) {
+                followers.push_back(headOf(next->second));
+                std::push_heap(followers.begin(), followers.end(), worse);
+            }
+        }
+        return selected;
+    }
+
+    PoolStats TransactionPool::stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        PoolStats result = counters_;
+        result.transactions = count_;
+        result.bytes = bytes_;
+        result.senders = bySender_.size();
+        return result;
+    }
+
+    size_t TransactionPool::size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return count_;
+    }
+
+    // Put a transaction into every index
+    uint32_t TransactionPool::insert(PoolEntry entry, const SPHINXIndex::BlockDigest& digest) {
+        uint32_t slot;
+        if (!freeSlots_.empty()) {
+            slot = freeSlots_.back();
+            freeSlots_.pop_back();
+        } else {
+            slot = static_cast<uint32_t>(slots_.size());
+            slots_.emplace_back();
+        }
+        Account& account = bySender_[entry.sender];
+        if (!account.byNonce.empty() && entry.nonce < account.byNonce.begin()->first) {
+            heads_.erase(headOf(account.byNonce.begin()->second));  // No longer the sender's first transaction
+        }
+        account.byNonce[entry.nonce] = slot;
+        account.pending += entry.amount + entry.fee;  // Checked against the balance by add
+        bytes_ += entry.size;
+        ++count_;
+
+        Slot& target = slots_[slot];
+        target.entry = std::move(entry);
+        target.digest = digest;
+        target.sequence = nextSequence_++;
+        target.used = true;
+        byId_.emplace(digest, slot);
+        heapPush(slot);
+        if (account.byNonce.begin()->second == slot) {
+            heads_.insert(headOf(slot));
+        }
+        return slot;
+    }
+
+    // Take a transaction out of every index and recycle its slot
+    void TransactionPool::erase(uint32_t slot) {
+        Slot& target = slots_[slot];
+        heapErase(slot);
+        byId_.erase(target.digest);
+        auto account = bySender_.find(target.entry.sender);
+        const bool wasHead = account->second.byNonce.begin()->second == slot;
+        if (wasHead) {
+            heads_.erase(headOf(slot));
+        }
+        account->second.byNonce.erase(target.entry.nonce);
+        account->second.pending -= target.entry.amount + target.entry.fee;
+        if (account->second.byNonce.empty()) {
+            bySender_.erase(account);
+        } else if (wasHead) {
+            heads_.insert(headOf(account->second.byNonce.begin()->second));  // The sender's next transaction leads now
+        }
+        bytes_ -= target.entry.size;
+        --count_;
+        target.entry = PoolEntry{};  // Release the strings and the transaction now
+        target.used = false;
+        freeSlots_.push_back(slot);
+    }
+
+    // Remove a transaction and every later nonce of the same sender
+    size_t TransactionPool::evictFrom(uint32_t slot) {
+        const std::string sender = slots_[slot].entry.sender;
+        const uint64_t nonce = slots_[slot].entry.nonce;
+        size_t evicted = 0;
+        for (auto account = bySender_.find(sender); account != bySender_.end() && account->second.byNonce.rbegin()->first >= nonce; account = bySender_.find(sender)) {
+            erase(account->second.byNonce.rbegin()->second);  // Newest first, the account disappears with its last entry
+            ++evicted;
+        }
+        return evicted;
+    }
+
+    bool TransactionPool::BetterHead::operator()(const Head& a, const Head& b) const {
+        const int order = compareFeeRates(a.fee, a.size, b.fee, b.size);
+        if (order != 0) {
+            return order > 0;
+        }
+        return a.sequence < b.sequence;  // Equal rates: first come, first served
+    }
+
+    TransactionPool::Head TransactionPool::headOf(uint32_t slot) const {
+        const Slot& target = slots_[slot];
+        return Head{target.entry.fee, target.entry.size, target.sequence, slot};
+    }
+
+    bool TransactionPool::cheaper(uint32_t a, uint32_t b) const {
+        const Slot& left = slots_[a];
+        const Slot& right = slots_[b];
+        if (lowerRate(left.entry, right.entry)) {
+            return true;
+        }
+        if (lowerRate(right.entry, left.entry)) {
+            return false;
+        }
+        return left.sequence > right.sequence;  // Equal rates: the newcomer goes first
+    }
+
+    void TransactionPool::place(size_t index, uint32_t slot) {
+        feeHeap_[index] = slot;
+        slots_[slot].heapIndex = static_cast<uint32_t>(index);
+    }
+
+    void TransactionPool::heapPush(uint32_t slot) {
+        feeHeap_.push_back(slot);
+        place(feeHeap_.size() - 1, slot);
+        siftUp(feeHeap_.size() - 1);
+    }
+
+    void TransactionPool::heapErase(uint32_t slot) {
+        const size_t index = slots_[slot].heapIndex;
+        const uint32_t last = feeHeap_.back();
+        feeHeap_.pop_back();
+        slots_[slot].heapIndex = NOT_IN_HEAP;
+        if (index < feeHeap_.size()) {
+            place(index, last);
+            siftUp(index);
+            siftDown(slots_[last].heapIndex);
+        }
+    }
+
+    void TransactionPool::siftUp(size_t index) {
+        const uint32_t slot = feeHeap_[index];
+        while (index > 0) {
+            const size_t parent = (index - 1) / 2;
+            if (!cheaper(slot, feeHeap_[parent])) {
+                break;
+            }
+            place(index, feeHeap_[parent]);
+            index = parent;
+        }
+        place(index, slot);
+    }
+
+    void TransactionPool::siftDown(size_t index) {
+        const uint32_t slot = feeHeap_[index];
+        const size_t count = feeHeap_.size();
+        for (;;) {
+            size_t child = 2 * index + 1;
+            if (child >= count) {
+                break;
+            }
+            if (child + 1 < count && cheaper(feeHeap_[child + 1], feeHeap_[child])) {
+                ++child;
+            }
+            if (!cheaper(feeHeap_[child], slot)) {
+                break;
+            }
+            place(index, feeHeap_[child]);
+            index = child;
+        }
+        place(index, slot);
+    }
+} // namespace SPHINXTxPool
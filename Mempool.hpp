@@ -0,0 +1,185 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXMEMPOOL_HPP
+#define SPHINXMEMPOOL_HPP
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Transaction.hpp"
+#include "BlockIndex.hpp"
+#include "Ledger.hpp"
+
+namespace SPHINXTxPool {
+
+    // Capacity and replacement policy of a transaction pool.
+    struct PoolOptions {
+        size_t maxTransactions = 200000;  // Pending transactions kept at most
+        size_t maxBytes = 64 * 1024 * 1024;  // Encoded bytes of the pending transactions kept at most
+        unsigned replaceBumpPercent = 10;  // A transaction replaces the one with the same sender and nonce only with a fee rate this much higher
+    };
+
+    // A pending transaction with the fields the pool indexes it by.
+    struct PoolEntry {
+        std::string id;  // Transaction id (SPHINX_256 hex)
+        std::string sender;  // Sender address
+        uint64_t nonce = 0;  // Position in the sender's sequence; a sender's transactions go into blocks in nonce order
+        SPHINXLedger::Amount amount = 0;
+        SPHINXLedger::Amount fee = 0;
+        size_t size = 0;  // Encoded size in bytes, what a block pays for
+        SPHINXTrx::Transaction transaction;
+    };
+
+    // Outcome of adding a transaction.
+    enum class AddResult {
+        Added,
+        Replaced,  // Took the place of a pending transaction with the same sender and nonce and a lower fee rate
+        Duplicate,  // The same transaction is already pending
+        NonceConflict,  // Another transaction of the sender has this nonce and the fee rate is not high enough to replace it
+        InsufficientBalance,  // The sender's pending transactions would spend more than its balance (double spend)
+        PoolFull,  // The pool is full of transactions paying a higher fee rate
+        TooLarge  // Larger than the whole pool
+    };
+
+    // Name of a result, for error messages.
+    const char* toString(AddResult result);
+
+    // Compare the fee rates feeA / sizeA and feeB / sizeB, each side's fee scaled by scaleA or scaleB; negative, zero or
+    // positive like strcmp. Fees must not be negative. Exact while the cross products fit in 64 bits.
+    int compareFeeRates(SPHINXLedger::Amount feeA, uint64_t sizeA, SPHINXLedger::Amount feeB, uint64_t sizeB, uint64_t scaleA = 1, uint64_t scaleB = 1);
+
+    // Counters of a pool.
+    struct PoolStats {
+        size_t transactions = 0;  // Pending now
+        size_t bytes = 0;  // Encoded bytes pending now
+        size_t senders = 0;  // Senders with a pending transaction
+        uint64_t added = 0;  // Admitted, replacements included
+        uint64_t replaced = 0;
+        uint64_t evicted = 0;  // Pushed out by capacity or by dropUnaffordable
+        uint64_t rejected = 0;
+        uint64_t removed = 0;  // Taken out by remove (included in a block)
+    };
+
+    // Pool of pending transactions, indexed three ways: by id (hash map on the binary digest), by sender (nonce-ordered)
+    // and by fee rate (indexed binary min-heap, so the cheapest transaction is evicted in O(log n)). Every call takes
+    // one internal lock, so the pool can be shared by broadcasting threads and the block producer.
+    class TransactionPool {
+    public:
+        explicit TransactionPool(PoolOptions options = {});
+
+        TransactionPool(const TransactionPool&) = delete;
+        TransactionPool& operator=(const TransactionPool&) = delete;
+
+        // Admit a transaction. senderBalance is the sender's confirmed balance: the amounts and fees of all pending
+        // transactions of the sender may not add up to more. When the pool is over capacity, the transactions with the
+        // lowest fee rate are evicted together with the later nonces of their sender, possibly the new one itself.
+        // With assignNonce, entry.nonce is ignored and the transaction takes nextNonce(sender) under the same lock, so
+        // concurrent submissions of one sender get distinct nonces.
+        AddResult add(PoolEntry entry, SPHINXLedger::Amount senderBalance, bool assignNonce = false);
+
+        bool contains(std::string_view id) const;
+
+        // Copy of a pending transaction.
+        std::optional<PoolEntry> find(std::string_view id) const;
+
+        // Nonce after the sender's highest pending one, or 0 for a sender with nothing pending.
+        uint64_t nextNonce(std::string_view sender) const;
+
+        // Remove transactions that went into a block; unknown ids are ignored. Returns the number removed.
+        size_t remove(std::span<const std::string> ids);
+
+        // Evict the transactions that their senders can no longer pay for, latest nonce first, after balances went down.
+        size_t dropUnaffordable(const std::function<SPHINXLedger::Amount(std::string_view sender)>& balanceOf);
+
+        // Pick transactions for a block in fee-rate order: a sender's transactions only in nonce order and without gaps,
+        // and at most maxBytes of encoded transactions in total. Costs O(k log n) for k picked transactions; once the
+        // block is nearly full, it gives up after MAX_SELECT_MISSES transactions in a row that do not fit.
+        std::vector<PoolEntry> selectForBlock(size_t maxBytes) const;
+
+        PoolStats stats() const;
+        size_t size() const;
+
+        static constexpr size_t MAX_SELECT_MISSES = 1000;
+
+    private:
+        static constexpr uint32_t NOT_IN_HEAP = std::numeric_limits<uint32_t>::max();
+
+        struct Slot {
+            PoolEntry entry;
+            SPHINXIndex::BlockDigest digest{};
+            uint64_t sequence = 0;  // Arrival order, the tie-break between equal fee rates
+            uint32_t heapIndex = NOT_IN_HEAP;
+            bool used = false;
+        };
+
+        struct Account {
+            std::map<uint64_t, uint32_t> byNonce;  // Nonce -> slot
+            SPHINXLedger::Amount pending = 0;  // Amount plus fee of every pending transaction
+        };
+
+        // Lowest pending nonce of a sender, ordered best fee rate first (then oldest first).
+        struct Head {
+            SPHINXLedger::Amount fee;
+            size_t size;
+            uint64_t sequence;
+            uint32_t slot;
+        };
+        struct BetterHead {
+            bool operator()(const Head& a, const Head& b) const;
+        };
+
+        Head headOf(uint32_t slot) const;
+
+        // True when a pays a lower fee rate than b (or the same rate and arrived later), so a is evicted first.
+        bool cheaper(uint32_t a, uint32_t b) const;
+        void heapPush(uint32_t slot);
+        void heapErase(uint32_t slot);
+        void siftUp(size_t index);
+        void siftDown(size_t index);
+        void place(size_t index, uint32_t slot);
+
+        uint32_t insert(PoolEntry entry, const SPHINXIndex::BlockDigest& digest);
+        void erase(uint32_t slot);  // Remove one transaction from every index
+        size_t evictFrom(uint32_t slot);  // Remove a transaction and the later nonces of its sender
+
+        PoolOptions options_;
+        mutable std::mutex mutex_;
+        std::vector<Slot> slots_;
+        std::vector<uint32_t> freeSlots_;
+        std::unordered_map<SPHINXIndex::BlockDigest, uint32_t, SPHINXIndex::BlockDigestHasher> byId_;
+        std::unordered_map<std::string, Account> bySender_;
+        std::vector<uint32_t> feeHeap_;  // Slots, cheapest at the top
+        std::set<Head, BetterHead> heads_;  // First transaction of every sender, where block selection starts
+        size_t count_ = 0;
+        size_t bytes_ = 0;
+        uint64_t nextSequence_ = 0;
+        PoolStats counters_;
+    };
+} // namespace SPHINXTxPool
+
+#endif // SPHINXMEMPOOL_HPP
@@ -0,0 +1,109 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXMPSCQUEUE_HPP
+#define SPHINXMPSCQUEUE_HPP
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace SPHINXBroadcast {
+
+    // Bounded multi-producer, single-consumer queue on a ring of cells with per-cell sequence numbers. Producers claim
+    // a cell with one compare-and-swap on the tail and never wait for each other or for the consumer; a full queue is
+    // reported instead of waited on, so the caller chooses the backpressure policy.
+    template <typename T>
+    class MpscQueue {
+    public:
+        // The capacity is rounded up to a power of two.
+        explicit MpscQueue(size_t capacity) : mask_(roundUp(capacity) - 1), cells_(std::make_unique<Cell[]>(mask_ + 1)) {
+            for (size_t i = 0; i <= mask_; ++i) {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpscQueue(const MpscQueue&) = delete;
+        MpscQueue& operator=(const MpscQueue&) = delete;
+
+        size_t capacity() const { return mask_ + 1; }
+
+        // Number of elements ever pushed (including pushes still completing).
+        size_t pushedCount() const { return tail_.load(std::memory_order_acquire); }
+
+        // Append a copy of value; returns false if the queue is full. Safe to call from any number of threads.
+        bool tryPush(const T& value) {
+            size_t position = tail_.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell& cell = cells_[position & mask_];
+                const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+                if (difference == 0) {
+                    if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        cell.value.emplace(value);
+                        cell.sequence.store(position + 1, std::memory_order_release);  // Hand the cell to the consumer
+                        return true;
+                    }
+                } else if (difference < 0) {
+                    return false;  // The cell still holds an element from the previous lap
+                } else {
+                    position = tail_.load(std::memory_order_relaxed);  // Another producer took this cell
+                }
+            }
+        }
+
+        // Take the oldest element, or nothing if the queue is empty. Only the consumer thread may call this.
+        std::optional<T> tryPop() {
+            Cell& cell = cells_[head_ & mask_];
+            if (cell.sequence.load(std::memory_order_acquire) != head_ + 1) {
+                return std::nullopt;
+            }
+            std::optional<T> value = std::move(cell.value);
+            cell.value.reset();
+            cell.sequence.store(head_ + mask_ + 1, std::memory_order_release);  // Free the cell for the next lap
+            ++head_;
+            return value;
+        }
+
+        // True when the next pop would find nothing. Only the consumer thread may call this.
+        bool empty() const {
+            return cells_[head_ & mask_].sequence.load(std::memory_order_acquire) != head_ + 1;
+        }
+
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence{0};
+            std::optional<T> value;
+        };
+
+        static size_t roundUp(size_t capacity) {
+            size_t result = 2;
+            while (result < capacity) {
+                result *= 2;
+            }
+            return result;
+        }
+
+        const size_t mask_;
+        std::unique_ptr<Cell[]> cells_;
+        alignas(64) std::atomic<size_t> tail_{0};  // Next cell a producer claims
+        alignas(64) size_t head_ = 0;  // Next cell the consumer reads
+    };
+} // namespace SPHINXBroadcast
+
+#endif // SPHINXMPSCQUEUE_HPP
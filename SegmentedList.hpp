@@ -0,0 +1,233 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXSEGMENTEDLIST_HPP
+#define SPHINXSEGMENTEDLIST_HPP
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace SPHINXStore {
+
+    // Append-only list kept in fixed-size segments that never move once allocated. A snapshot shares the segments
+    // instead of copying the elements and stays valid, with the same contents, while the list keeps growing: appends
+    // only construct elements behind it, and the segment directory is replaced rather than modified. So one writer can
+    // append while other threads read snapshots without a lock, as long as the snapshot is handed over with
+    // release/acquire ordering (Chain publishes it through an atomic pointer).
+    template <typename T, size_t SegmentSize = 256>
+    class SegmentedList {
+        // Raw storage for SegmentSize elements; only the owning list reads count
+        struct Segment {
+            Segment() : data(static_cast<T*>(::operator new(sizeof(T) * SegmentSize, std::align_val_t(alignof(T))))) {}
+            ~Segment() {
+                for (size_t i = 0; i < count; ++i) {
+                    data[i].~T();
+                }
+                ::operator delete(data, std::align_val_t(alignof(T)));
+            }
+            Segment(const Segment&) = delete;
+            Segment& operator=(const Segment&) = delete;
+
+            T* data;
+            size_t count = 0;  // Constructed elements
+        };
+        using Directory = std::vector<std::shared_ptr<Segment>>;
+
+    public:
+        // Read-only view of the elements a list held when the snapshot was taken.
+        class Snapshot {
+        public:
+            Snapshot() = default;
+
+            size_t size() const { return size_; }
+            bool empty() const { return size_ == 0; }
+
+            // Element at index (unchecked, like std::vector).
+            const T& operator[](size_t index) const {
+                const size_t slot = offset_ + index;
+                return (*directory_)[slot / SegmentSize]->data[slot % SegmentSize];
+            }
+
+        private:
+            friend class SegmentedList;
+
+            std::shared_ptr<const Directory> directory_;
+            size_t offset_ = 0;
+            size_t size_ = 0;
+        };
+
+        SegmentedList() = default;
+
+        // Copies are deep, so two lists never append into the same segment.
+        SegmentedList(const SegmentedList& other) {
+            for (size_t i = 0; i < other.size(); ++i) {
+                push_back(other[i]);
+            }
+        }
+
+        SegmentedList& operator=(const SegmentedList& other) {
+            if (this != &other) {
+                SegmentedList copy(other);
+                *this = std::move(copy);
+            }
+            return *this;
+        }
+
+        // A list that starts with the contents of a snapshot. The full segments are shared with the snapshot instead of
+        // copied; only the partly filled last segment is copied, so the two lists can both append without touching each
+        // other. Costs at most SegmentSize copies.
+        explicit SegmentedList(const Snapshot& snapshot) : offset_(snapshot.offset_), size_(snapshot.size_) {
+            if (size_ > 0) {
+                directory_ = sharePrefix(*snapshot.directory_, offset_ + size_);
+            }
+        }
+
+        SegmentedList(SegmentedList&&) noexcept = default;
+        SegmentedList& operator=(SegmentedList&&) noexcept = default;
+
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        const T& operator[](size_t index) const { return element(index); }
+
+        // Shared ownership of the element at index: it keeps the element's segment, and so the element, alive after the
+        // list truncates or drops it. No element is copied.
+        std::shared_ptr<const T> share(size_t index) const {
+            const size_t slot = offset_ + index;
+            const std::shared_ptr<Segment>& segment = (*directory_)[slot / SegmentSize];
+            return std::shared_ptr<const T>(segment, segment->data + slot % SegmentSize);
+        }
+
+        // Mutable access; only for elements that no snapshot has seen yet (for example right after assign).
+        T& operator[](size_t index) { return element(index); }
+
+        void push_back(T value) {
+            const size_t slot = offset_ + size_;
+            if (!directory_ || slot == directory_->size() * SegmentSize) {
+                auto directory = directory_ ? std::make_shared<Directory>(*directory_) : std::make_shared<Directory>();
+                directory->push_back(std::make_shared<Segment>());
+                directory_ = std::move(directory);  // Snapshots keep the directory they were taken with
+            }
+            Segment& segment = *directory_->back();
+            new (segment.data + segment.count) T(std::move(value));
+            ++segment.count;
+            ++size_;
+        }
+
+        // Remove the last element in place. It must not be visible to any snapshot; use truncate for published elements.
+        void pop_back() {
+            if (size_ == 0) {
+                throw std::out_of_range("pop_back on an empty segmented list");
+            }
+            Segment& segment = *directory_->back();
+            --segment.count;
+            segment.data[segment.count].~T();
+            --size_;
+            if (segment.count == 0) {
+                auto directory = std::make_shared<Directory>(directory_->begin(), directory_->end() - 1);
+                directory_ = directory->empty() ? nullptr : std::move(directory);
+                if (!directory_) {
+                    offset_ = 0;
+                }
+            }
+        }
+
+        // Keep only the first count elements, leaving the removed ones alive for the snapshots that share them: the kept
+        // part of the last segment is copied into a new segment and a new directory is swapped in. Costs at most
+        // SegmentSize copies, so truncate once rather than popping element by element.
+        void truncate(size_t count) {
+            if (count >= size_) {
+                return;
+            }
+            if (count == 0) {
+                clear();
+                return;
+            }
+            directory_ = sharePrefix(*directory_, offset_ + count);
+            size_ = count;
+        }
+
+        // Drop the first count elements. Whole segments are released once no snapshot uses them.
+        void eraseFront(size_t count) {
+            if (count >= size_) {
+                clear();
+                return;
+            }
+            offset_ += count;
+            size_ -= count;
+            const size_t dropped = offset_ / SegmentSize;
+            if (dropped > 0) {
+                directory_ = std::make_shared<Directory>(directory_->begin() + static_cast<std::ptrdiff_t>(dropped), directory_->end());
+                offset_ %= SegmentSize;
+            }
+        }
+
+        // Replace the contents with count copies of value.
+        void assign(size_t count, const T& value) {
+            clear();
+            for (size_t i = 0; i < count; ++i) {
+                push_back(value);
+            }
+        }
+
+        void clear() {
+            directory_.reset();
+            offset_ = 0;
+            size_ = 0;
+        }
+
+        // Take a snapshot of the current contents in O(1).
+        Snapshot snapshot() const {
+            Snapshot result;
+            result.directory_ = directory_;
+            result.offset_ = offset_;
+            result.size_ = size_;
+            return result;
+        }
+
+    private:
+        // Directory holding the slots before end: the full segments are shared, the last one is copied if partly kept.
+        static std::shared_ptr<const Directory> sharePrefix(const Directory& source, size_t end) {
+            const size_t fullSegments = end / SegmentSize;
+            auto directory = std::make_shared<Directory>(source.begin(), source.begin() + static_cast<std::ptrdiff_t>(fullSegments));
+            if (end % SegmentSize > 0) {
+                const Segment& last = *source[fullSegments];
+                auto segment = std::make_shared<Segment>();
+                for (size_t i = 0; i < end % SegmentSize; ++i) {
+                    new (segment->data + i) T(last.data[i]);  // Slots before the offset too, so positions stay the same
+                    ++segment->count;
+                }
+                directory->push_back(std::move(segment));
+            }
+            return directory;
+        }
+
+        T& element(size_t index) const {
+            const size_t slot = offset_ + index;
+            return (*directory_)[slot / SegmentSize]->data[slot % SegmentSize];
+        }
+
+        std::shared_ptr<const Directory> directory_;  // Never modified once shared, replaced when segments come or go
+        size_t offset_ = 0;  // Position of the first element in the first segment
+        size_t size_ = 0;
+    };
+} // namespace SPHINXStore
+
+#endif // SPHINXSEGMENTEDLIST_HPP
@@ -0,0 +1,74 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the consistent-hash ring that assigns addresses to shards.
+
+// Ring:
+    // Each shard is placed on a 64-bit ring at virtualNodes pseudo-random positions derived from its index, so every node builds the same ring.
+    // An address is hashed onto the ring and owned by the next shard position clockwise; lookups are a binary search over the sorted positions.
+
+// Rebalancing:
+    // Adding a shard only inserts new positions, so only the addresses that fall just before them move; all other addresses keep their shard.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "ShardRing.hpp"
+
+namespace SPHINXShard {
+
+    namespace {
+        // Finalizer of splitmix64: spreads every input bit over the whole word
+        uint64_t mix(uint64_t value) {
+            value ^= value >> 30;
+            value *= 0xbf58476d1ce4e5b9ULL;
+            value ^= value >> 27;
+            value *= 0x94d049bb133111ebULL;
+            return value ^ (value >> 31);
+        }
+    } // namespace
+
+    // Hash an address with FNV-1a and mix the result
+    uint64_t hashAddress(std::string_view address) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (unsigned char c : address) {
+            hash = (hash ^ c) * 0x100000001b3ULL;
+        }
+        return mix(hash);
+    }
+
+    HashRing::HashRing(size_t shardCount, size_t virtualNodes) : shardCount_(shardCount) {
+        if (shardCount == 0 || shardCount > UINT32_MAX || virtualNodes == 0) {
+            throw std::invalid_argument("Hash ring needs at least one shard and one virtual node per shard");
+        }
+        points_.reserve(shardCount * virtualNodes);
+        for (uint32_t shard = 0; shard < shardCount; ++shard) {
+            for (uint64_t node = 0; node < virtualNodes; ++node) {
+                points_.emplace_back(mix((static_cast<uint64_t>(shard) << 32) | node), shard);
+            }
+        }
+        std::sort(points_.begin(), points_.end());
+    }
+
+    // Find the first ring position at or after the address hash, wrapping around at the end
+    size_t HashRing::shardFor(std::string_view address) const {
+        const uint64_t hash = hashAddress(address);
+        auto it = std::lower_bound(points_.begin(), points_.end(), hash,
+                                   [](const std::pair<uint64_t, uint32_t>& point, uint64_t value) { return point.first < value; });
+        return it == points_.end() ? points_.front().second : it->second;
+    }
+} // namespace SPHINXShard
@@ -0,0 +1,49 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXSHARDRING_HPP
+#define SPHINXSHARDRING_HPP
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace SPHINXShard {
+
+    // Stable 64-bit hash of an address (FNV-1a with a final mix). Unlike std::hash it is the same on every node.
+    uint64_t hashAddress(std::string_view address);
+
+    // Consistent-hash ring mapping addresses to shards. Every shard owns virtualNodes points on the ring and an
+    // address belongs to the first point at or after its hash, so going from n to n + 1 shards moves only about
+    // 1 / (n + 1) of the addresses and the load per shard stays within about 10% of even.
+    class HashRing {
+    public:
+        explicit HashRing(size_t shardCount, size_t virtualNodes = 128);
+
+        // Get the shard an address belongs to.
+        size_t shardFor(std::string_view address) const;
+
+        size_t shardCount() const { return shardCount_; }
+
+    private:
+        size_t shardCount_;
+        std::vector<std::pair<uint64_t, uint32_t>> points_;  // (ring position, shard), sorted by position
+    };
+} // namespace SPHINXShard
+
+#endif // SPHINXSHARDRING_HPP
@@ -0,0 +1,160 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements batch signature verification for the SPHINX chain.
+
+// Key Deduplication:
+    // A block or a bridge batch usually carries many signatures from few signers. Every distinct public key is decoded once and shared by all checks that use it.
+
+// Cache:
+    // With a SignatureCache, checks that verified before are answered from the cache; only the misses have their keys decoded and their signatures checked, and every new success is recorded.
+
+// Parallel Verification:
+    // Key decoding and signature checks both run on the shared work-stealing pool (ThreadPool.hpp); small batches stay on the calling thread.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+#include "SignatureBatch.hpp"
+#include "ThreadPool.hpp"
+#include "Key.hpp"
+#include "Verify.hpp"
+
+namespace SPHINXBatch {
+
+    namespace {
+        constexpr size_t VERIFY_GRAIN = 8;  // Signatures per pool task
+
+        // Run fn over [0, count) on the pool, or inline when one task would do
+        void forRange(size_t count, const std::function<void(size_t, size_t)>& fn) {
+            if (count <= VERIFY_GRAIN) {
+                fn(0, count);
+            } else {
+                SPHINXPool::ThreadPool::shared().parallelFor(0, count, VERIFY_GRAIN, fn);
+            }
+        }
+
+        // Decoded public keys of the checks that still need verifying, and the key used by each of them
+        struct ParsedKeys {
+            std::vector<SPHINXKey::SPHINXPubKey> keys;
+            std::vector<uint8_t> valid;  // 0 when the key could not be decoded
+            std::vector<uint32_t> keyOf;  // Position in pending -> index into keys
+        };
+
+        ParsedKeys parseKeys(std::span<const SignatureCheck> checks, const std::vector<uint32_t>& pending) {
+            ParsedKeys parsed;
+            std::unordered_map<std::string_view, uint32_t> index;
+            std::vector<std::string_view> unique;
+            parsed.keyOf.reserve(pending.size());
+            for (uint32_t check : pending) {
+                auto [it, inserted] = index.try_emplace(checks[check].publicKey, static_cast<uint32_t>(unique.size()));
+                if (inserted) {
+                    unique.push_back(checks[check].publicKey);
+                }
+                parsed.keyOf.push_back(it->second);
+            }
+
+            parsed.keys.resize(unique.size());
+            parsed.valid.assign(unique.size(), 0);
+            forRange(unique.size(), [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    try {
+                        parsed.keys[i] = SPHINXHybridKey::sphinxKeyFromString(std::string(unique[i]));
+                        parsed.valid[i] = 1;
+                    } catch (const std::exception&) {
+                        // Every check with this key fails
+                    }
+                }
+            });
+            return parsed;
+        }
+
+        bool verifyOne(const SignatureCheck& check, const SPHINXKey::SPHINXPubKey& key) {
+            try {
+                return SPHINXVerify::verifySignature(std::string(check.message), std::string(check.signature), key);
+            } catch (const std::exception&) {
+                return false;  // A malformed signature is an invalid signature
+            }
+        }
+
+        // Verify a batch: cache lookups first, then key parsing and signature checks for the misses only
+        std::vector<uint8_t> run(std::span<const SignatureCheck> checks, SignatureCache* cache, bool stopOnFailure, BatchStats* stats) {
+            std::vector<uint8_t> results(checks.size(), 0);
+            std::vector<CacheKey> cacheKeys(cache != nullptr ? checks.size() : 0);
+            if (cache != nullptr) {
+                forRange(checks.size(), [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        cacheKeys[i] = SignatureCache::makeKey(checks[i].message, checks[i].signature, checks[i].publicKey);
+                        results[i] = cache->contains(cacheKeys[i]) ? 1 : 0;
+                    }
+                });
+            }
+            std::vector<uint32_t> pending;
+            for (uint32_t i = 0; i < checks.size(); ++i) {
+                if (!results[i]) {
+                    pending.push_back(i);
+                }
+            }
+
+            const ParsedKeys parsed = parseKeys(checks, pending);
+            std::atomic<bool> failed{false};
+            forRange(pending.size(), [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    if (stopOnFailure && failed.load(std::memory_order_relaxed)) {
+                        return;
+                    }
+                    const uint32_t check = pending[i];
+                    const uint32_t key = parsed.keyOf[i];
+                    if (parsed.valid[key] && verifyOne(checks[check], parsed.keys[key])) {
+                        results[check] = 1;
+                        if (cache != nullptr) {
+                            cache->insert(cacheKeys[check]);
+                        }
+                    } else {
+                        failed.store(true, std::memory_order_relaxed);
+                    }
+                }
+            });
+
+            if (stats != nullptr) {
+                stats->signatures = checks.size();
+                stats->cacheHits = checks.size() - pending.size();
+                stats->uniqueKeys = parsed.keys.size();
+                stats->invalid = 0;
+                for (uint8_t result : results) {
+                    stats->invalid += (result == 0);
+                }
+            }
+            return results;
+        }
+    } // namespace
+
+    // Verify every signature of the batch
+    std::vector<uint8_t> verifyBatch(std::span<const SignatureCheck> checks, BatchStats* stats, SignatureCache* cache) {
+        return run(checks, cache, false, stats);
+    }
+
+    // Verify every signature of the batch, stopping at the first failure
+    bool verifyAll(std::span<const SignatureCheck> checks, SignatureCache* cache) {
+        const std::vector<uint8_t> results = run(checks, cache, true, nullptr);
+        return std::all_of(results.begin(), results.end(), [](uint8_t result) { return result != 0; });
+    }
+} // namespace SPHINXBatch
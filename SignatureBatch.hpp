@@ -0,0 +1,55 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXSIGNATUREBATCH_HPP
+#define SPHINXSIGNATUREBATCH_HPP
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "SignatureCache.hpp"
+
+namespace SPHINXBatch {
+
+    // One signature to check. The views must stay valid for the duration of the call.
+    struct SignatureCheck {
+        std::string_view message;
+        std::string_view signature;
+        std::string_view publicKey;  // Encoded public key, as returned by Transaction::getSenderPublicKey
+    };
+
+    // Counters of one batch, to see how much deduplication saved.
+    struct BatchStats {
+        size_t signatures = 0;
+        size_t cacheHits = 0;  // Answered by the cache, nothing was parsed or verified for them
+        size_t uniqueKeys = 0;  // Public keys parsed (each distinct key of the cache misses exactly once)
+        size_t invalid = 0;
+    };
+
+    // Verify a batch of signatures. Checks found in the cache (if one is given) are accepted without verifying; for
+    // the rest, repeated public keys are parsed once and the checks are spread over the shared thread pool, and every
+    // success is added to the cache. Returns one entry per check: 1 if the signature is valid, 0 otherwise (including
+    // unparsable keys).
+    std::vector<uint8_t> verifyBatch(std::span<const SignatureCheck> checks, BatchStats* stats = nullptr, SignatureCache* cache = nullptr);
+
+    // Same as verifyBatch, but only reports whether every signature is valid and stops early on the first failure.
+    bool verifyAll(std::span<const SignatureCheck> checks, SignatureCache* cache = nullptr);
+} // namespace SPHINXBatch
+
+#endif // SPHINXSIGNATUREBATCH_HPP
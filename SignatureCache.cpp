@@ -0,0 +1,113 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the verified-signature cache used by the SPHINX chain.
+
+// Keys:
+    // An entry is the SPHINX_256 digest of the message, signature and public key, each prefixed with its length so different splits of the same bytes never collide.
+
+// Eviction:
+    // The cache is split into 16 segments, each a small LRU (list + hash map) under its own mutex. A segment evicts its least recently used entry once it holds capacity / 16 entries.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <algorithm>
+#include <string>
+
+#include "SignatureCache.hpp"
+#include "Hash.hpp"
+
+namespace SPHINXBatch {
+
+    namespace {
+        void appendField(std::string& out, std::string_view field) {
+            const uint64_t length = field.size();
+            for (int shift = 0; shift < 64; shift += 8) {
+                out.push_back(static_cast<char>(length >> shift));
+            }
+            out.append(field.data(), field.size());
+        }
+    } // namespace
+
+    SignatureCache::SignatureCache(size_t capacity)
+        : segmentCapacity_(std::max<size_t>(1, capacity / SEGMENT_COUNT)) {
+    }
+
+    // Get the process-wide cache
+    SignatureCache& SignatureCache::shared() {
+        static SignatureCache cache;
+        return cache;
+    }
+
+    // Digest of one verification
+    CacheKey SignatureCache::makeKey(std::string_view message, std::string_view signature, std::string_view publicKey) {
+        std::string framed;
+        framed.reserve(24 + message.size() + signature.size() + publicKey.size());
+        appendField(framed, message);
+        appendField(framed, signature);
+        appendField(framed, publicKey);
+        return SPHINXIndex::toDigest(SPHINXHash::SPHINX_256(framed));  // 64 hex characters, decoded as is
+    }
+
+    // Look up a verification and move it to the front of its segment
+    bool SignatureCache::contains(const CacheKey& key) {
+        Segment& segment = segmentFor(key);
+        std::lock_guard<std::mutex> lock(segment.mutex);
+        auto it = segment.entries.find(key);
+        if (it == segment.entries.end()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        segment.order.splice(segment.order.begin(), segment.order, it->second);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Record a successful verification
+    void SignatureCache::insert(const CacheKey& key) {
+        Segment& segment = segmentFor(key);
+        std::lock_guard<std::mutex> lock(segment.mutex);
+        auto it = segment.entries.find(key);
+        if (it != segment.entries.end()) {
+            segment.order.splice(segment.order.begin(), segment.order, it->second);
+            return;
+        }
+        if (segment.entries.size() >= segmentCapacity_) {
+            segment.entries.erase(segment.order.back());
+            segment.order.pop_back();
+        }
+        segment.order.push_front(key);
+        segment.entries.emplace(key, segment.order.begin());
+    }
+
+    // Drop every entry; the counters are kept
+    void SignatureCache::clear() {
+        for (Segment& segment : segments_) {
+            std::lock_guard<std::mutex> lock(segment.mutex);
+            segment.entries.clear();
+            segment.order.clear();
+        }
+    }
+
+    // Get the number of cached verifications
+    size_t SignatureCache::size() const {
+        size_t total = 0;
+        for (const Segment& segment : segments_) {
+            std::lock_guard<std::mutex> lock(segment.mutex);
+            total += segment.entries.size();
+        }
+        return total;
+    }
+} // namespace SPHINXBatch
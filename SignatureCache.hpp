@@ -0,0 +1,80 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXSIGNATURECACHE_HPP
+#define SPHINXSIGNATURECACHE_HPP
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+#include "BlockIndex.hpp"
+
+namespace SPHINXBatch {
+
+    // Identity of one verification: SPHINX_256 over the length-prefixed message, signature and public key.
+    using CacheKey = SPHINXIndex::BlockDigest;
+
+    // Bounded LRU of signatures that verified successfully. Only successes are recorded, so a hit can be trusted
+    // and a miss just means "verify it". The entries are spread over independently locked segments so concurrent
+    // validators rarely contend.
+    class SignatureCache {
+    public:
+        explicit SignatureCache(size_t capacity = 1 << 16);
+
+        SignatureCache(const SignatureCache&) = delete;
+        SignatureCache& operator=(const SignatureCache&) = delete;
+
+        // Process-wide cache shared by every chain and validation path.
+        static SignatureCache& shared();
+
+        static CacheKey makeKey(std::string_view message, std::string_view signature, std::string_view publicKey);
+
+        // Check whether a verification succeeded before (counts a hit or a miss and refreshes the entry).
+        bool contains(const CacheKey& key);
+
+        // Record a successful verification, evicting the least recently used entry of its segment when full.
+        void insert(const CacheKey& key);
+
+        void clear();
+        size_t size() const;
+        uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+        uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+    private:
+        static constexpr size_t SEGMENT_COUNT = 16;
+
+        struct Segment {
+            mutable std::mutex mutex;
+            std::list<CacheKey> order;  // Most recently used first
+            std::unordered_map<CacheKey, std::list<CacheKey>::iterator, SPHINXIndex::BlockDigestHasher> entries;
+        };
+
+        Segment& segmentFor(const CacheKey& key) { return segments_[key[31] % SEGMENT_COUNT]; }  // Last byte: independent of the bucket hash
+
+        size_t segmentCapacity_;
+        std::array<Segment, SEGMENT_COUNT> segments_;
+        std::atomic<uint64_t> hits_{0};
+        std::atomic<uint64_t> misses_{0};
+    };
+} // namespace SPHINXBatch
+
+#endif // SPHINXSIGNATURECACHE_HPP
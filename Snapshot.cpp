@@ -0,0 +1,258 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the state snapshots of the SPHINX chain.
+
+// State Encoding:
+    // A snapshot holds the height, the tip hash, the chain balances and the balances of every shard.
+    // The state is encoded canonically (accounts and shards sorted by name, little-endian integers), so two nodes with the same state produce the same bytes and the same commitment.
+
+// Commitment:
+    // The commitment is SPHINX_256 of the canonical encoding. It is stored after the state and recomputed on read, so a damaged snapshot is rejected instead of being restored. It is unkeyed and sits next to the state, so it does not stop a deliberate edit: loads either take the expected commitment from a trusted source or must trust the snapshot directory.
+
+// Snapshot Files:
+    // Files are written to a temporary name, synced and renamed into place, so a crash never leaves a half-written snapshot under the real name.
+    // Periodic snapshots are named snapshot-<height>.snp with a zero-padded height; the directory is listed to find the newest one and pruned to the last few.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string_view>
+
+#include <unistd.h>
+
+#include "Snapshot.hpp"
+#include "Hash.hpp"
+
+namespace SPHINXStore {
+
+    namespace {
+        constexpr std::string_view FILE_PREFIX = "snapshot-";
+        constexpr std::string_view FILE_SUFFIX = ".snp";
+
+        void putInt(std::string& out, uint64_t value, int bytes) {
+            for (int i = 0; i < bytes; ++i) {
+                out.push_back(static_cast<char>(value >> (8 * i)));
+            }
+        }
+
+        void putString(std::string& out, std::string_view value) {
+            if (value.size() > UINT16_MAX) {
+                throw std::runtime_error("String too long for the snapshot format");
+            }
+            putInt(out, value.size(), 2);
+            out.append(value);
+        }
+
+        // Append the accounts of a ledger sorted by address
+        void putAccounts(std::string& out, const SPHINXLedger::Ledger& ledger) {
+            std::vector<SPHINXLedger::AddressId> ids(ledger.accountCount());
+            for (size_t i = 0; i < ids.size(); ++i) {
+                ids[i] = static_cast<SPHINXLedger::AddressId>(i);
+            }
+            std::sort(ids.begin(), ids.end(), [&ledger](SPHINXLedger::AddressId a, SPHINXLedger::AddressId b) {
+                return ledger.address(a) < ledger.address(b);
+            });
+            putInt(out, ids.size(), 4);
+            for (SPHINXLedger::AddressId id : ids) {
+                putString(out, ledger.address(id));
+                putInt(out, static_cast<uint64_t>(ledger.balance(id)), 8);
+            }
+        }
+
+        // Bounds-checked reader over the encoded state
+        class Reader {
+        public:
+            explicit Reader(std::string_view data) : data_(data) {}
+
+            uint64_t readInt(int bytes) {
+                const std::string_view raw = take(static_cast<size_t>(bytes));
+                uint64_t value = 0;
+                for (int i = 0; i < bytes; ++i) {
+                    value |= static_cast<uint64_t>(static_cast<uint8_t>(raw[i])) << (8 * i);
+                }
+                return value;
+            }
+
+            std::string_view readString() {
+                return take(static_cast<size_t>(readInt(2)));
+            }
+
+            void readAccounts(SPHINXLedger::Ledger& ledger) {
+                const uint64_t count = readInt(4);
+                for (uint64_t i = 0; i < count; ++i) {
+                    const std::string_view address = readString();
+                    ledger.add(address, static_cast<SPHINXLedger::Amount>(readInt(8)));
+                }
+            }
+
+            bool done() const { return position_ == data_.size(); }
+
+        private:
+            std::string_view take(size_t length) {
+                if (data_.size() - position_ < length) {
+                    throw std::runtime_error("Truncated snapshot");
+                }
+                const std::string_view part = data_.substr(position_, length);
+                position_ += length;
+                return part;
+            }
+
+            std::string_view data_;
+            size_t position_ = 0;
+        };
+    } // namespace
+
+    // Encode the state of a snapshot canonically
+    std::string encodeState(const StateSnapshot& snapshot) {
+        std::string out;
+        putInt(out, snapshot.height, 8);
+        putString(out, snapshot.tipHash);
+        putAccounts(out, snapshot.balances);
+
+        std::vector<const std::pair<std::string, SPHINXLedger::Ledger>*> shards;
+        shards.reserve(snapshot.shards.size());
+        for (const auto& shard : snapshot.shards) {
+            shards.push_back(&shard);
+        }
+        std::sort(shards.begin(), shards.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+        putInt(out, shards.size(), 4);
+        for (const auto* shard : shards) {
+            putString(out, shard->first);
+            putAccounts(out, shard->second);
+        }
+        return out;
+    }
+
+    // Hash the canonical state encoding
+    std::string stateCommitment(const StateSnapshot& snapshot) {
+        return SPHINXHash::SPHINX_256(encodeState(snapshot));
+    }
+
+    // Write a snapshot file atomically
+    std::string writeSnapshot(const std::string& filename, const StateSnapshot& snapshot) {
+        const std::string state = encodeState(snapshot);
+        const std::string commitment = SPHINXHash::SPHINX_256(state);
+        if (state.size() > UINT32_MAX) {
+            throw std::runtime_error("State too large for the snapshot format");
+        }
+
+        std::string file(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        putInt(file, state.size(), 4);
+        file += state;
+        putString(file, commitment);
+
+        const std::string tempFilename = filename + ".tmp";
+        std::FILE* output = std::fopen(tempFilename.c_str(), "wb");
+        if (output == nullptr) {
+            throw std::runtime_error("Failed to create snapshot file: " + tempFilename);
+        }
+        const bool written = std::fwrite(file.data(), 1, file.size(), output) == file.size() &&
+                             std::fflush(output) == 0 && ::fsync(::fileno(output)) == 0;
+        std::fclose(output);
+        if (!written) {
+            std::remove(tempFilename.c_str());
+            throw std::runtime_error("Failed to write snapshot file: " + tempFilename);
+        }
+        if (std::rename(tempFilename.c_str(), filename.c_str()) != 0) {
+            throw std::runtime_error("Failed to move snapshot file into place: " + filename);
+        }
+        return commitment;
+    }
+
+    // Read a snapshot file and check its commitment
+    StateSnapshot readSnapshot(const std::string& filename) {
+        std::FILE* input = std::fopen(filename.c_str(), "rb");
+        if (input == nullptr) {
+            throw std::runtime_error("Failed to open snapshot file: " + filename);
+        }
+        std::string file;
+        char buffer[1 << 16];
+        size_t count;
+        while ((count = std::fread(buffer, 1, sizeof(buffer), input)) > 0) {
+            file.append(buffer, count);
+        }
+        std::fclose(input);
+
+        if (file.size() < sizeof(SNAPSHOT_MAGIC) || std::memcmp(file.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+            throw std::runtime_error("Not a snapshot file: " + filename);
+        }
+        const std::string_view contents = std::string_view(file).substr(sizeof(SNAPSHOT_MAGIC));
+        const uint64_t stateLength = Reader(contents).readInt(4);
+        if (contents.size() - 4 < stateLength) {
+            throw std::runtime_error("Truncated snapshot: " + filename);
+        }
+        const std::string_view state = contents.substr(4, stateLength);  // Hashed as stored, then decoded
+        Reader tail(contents.substr(4 + stateLength));
+        const std::string commitment(tail.readString());
+        if (!tail.done() || SPHINXHash::SPHINX_256(std::string(state)) != commitment) {
+            throw std::runtime_error("Snapshot commitment mismatch: " + filename);
+        }
+
+        StateSnapshot snapshot;
+        Reader reader(state);
+        snapshot.height = reader.readInt(8);
+        snapshot.tipHash = std::string(reader.readString());
+        reader.readAccounts(snapshot.balances);
+        const uint64_t shardCount = reader.readInt(4);
+        snapshot.shards.resize(shardCount);
+        for (auto& shard : snapshot.shards) {
+            shard.first = std::string(reader.readString());
+            reader.readAccounts(shard.second);
+        }
+        if (!reader.done()) {
+            throw std::runtime_error("Trailing data in snapshot: " + filename);
+        }
+        snapshot.commitment = commitment;
+        return snapshot;
+    }
+
+    // Build the file name of a periodic snapshot
+    std::string snapshotFilename(const std::string& directory, uint64_t height) {
+        char digits[21];
+        std::snprintf(digits, sizeof(digits), "%012llu", static_cast<unsigned long long>(height));
+        return (std::filesystem::path(directory) / (std::string(FILE_PREFIX) + digits + std::string(FILE_SUFFIX))).string();
+    }
+
+    // List the snapshot heights of a directory
+    std::vector<uint64_t> listSnapshots(const std::string& directory) {
+        std::vector<uint64_t> heights;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+            const std::string name = entry.path().filename().string();
+            if (name.size() <= FILE_PREFIX.size() + FILE_SUFFIX.size() || !name.starts_with(FILE_PREFIX) || !name.ends_with(FILE_SUFFIX)) {
+                continue;
+            }
+            const std::string digits = name.substr(FILE_PREFIX.size(), name.size() - FILE_PREFIX.size() - FILE_SUFFIX.size());
+            if (std::all_of(digits.begin(), digits.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+                heights.push_back(std::stoull(digits));
+            }
+        }
+        std::sort(heights.rbegin(), heights.rend());
+        return heights;
+    }
+
+    // Remove the older snapshots of a directory
+    void pruneSnapshots(const std::string& directory, size_t keep) {
+        const std::vector<uint64_t> heights = listSnapshots(directory);
+        for (size_t i = keep; i < heights.size(); ++i) {
+            std::remove(snapshotFilename(directory, heights[i]).c_str());
+        }
+    }
+} // namespace SPHINXStore
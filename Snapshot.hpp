@@ -0,0 +1,85 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXSNAPSHOT_HPP
+#define SPHINXSNAPSHOT_HPP
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Ledger.hpp"
+
+namespace SPHINXStore {
+
+    // Magic bytes at the start of every snapshot file.
+    constexpr char SNAPSHOT_MAGIC[8] = {'S', 'P', 'X', 'S', 'N', 'P', '0', '1'};
+
+    // Account state of a chain at one height.
+    struct StateSnapshot {
+        uint64_t height = 0;  // Number of blocks covered; the tip is the block at height - 1
+        std::string tipHash;  // Hash of the tip block, ties the state to one history
+        SPHINXLedger::Ledger balances;  // Balances of the chain
+        std::vector<std::pair<std::string, SPHINXLedger::Ledger>> shards;  // Shard name -> balances of the shard
+        std::string commitment;  // stateCommitment of the above, set by writeSnapshot and readSnapshot
+    };
+
+    // Periodic snapshot policy of a chain.
+    struct SnapshotOptions {
+        std::string directory;  // Where snapshot files are written; empty disables periodic snapshots
+        size_t interval = 10000;  // Take a snapshot whenever the chain length is a multiple of this
+        size_t keep = 2;  // Number of most recent snapshots kept in the directory
+    };
+
+    // Outcome of the periodic snapshots of a chain. A snapshot that cannot be written is counted here; the block that
+    // triggered it is added all the same.
+    struct SnapshotStats {
+        uint64_t taken = 0;
+        uint64_t failed = 0;
+        std::string lastError;  // Message of the latest failure, empty if none
+    };
+
+    // Canonical encoding of the state of a snapshot (everything but the commitment). Accounts and shards are sorted
+    // by name, so equal state always encodes to equal bytes whatever order the addresses were first seen in.
+    //   u64 height | u16 length + tip hash | accounts | u32 shard count | per shard: u16 length + name | accounts
+    //   accounts = u32 count | per account: u16 length + address | i64 balance
+    std::string encodeState(const StateSnapshot& snapshot);
+
+    // Commitment to the state of a snapshot: SPHINX_256 of encodeState. It is not keyed, so the copy stored in a snapshot
+    // file only detects damage: whoever can write the file can recompute it. Compare it with a commitment from a trusted
+    // source before relying on the state.
+    std::string stateCommitment(const StateSnapshot& snapshot);
+
+    // Write a snapshot file (temporary file, fsync, rename) and return its commitment:
+    //   magic | u32 state length | encodeState | u16 length + commitment
+    std::string writeSnapshot(const std::string& filename, const StateSnapshot& snapshot);
+
+    // Read a snapshot file; throws std::runtime_error if it is truncated or its commitment does not match its state.
+    StateSnapshot readSnapshot(const std::string& filename);
+
+    // Name of the snapshot file of a height inside a directory.
+    std::string snapshotFilename(const std::string& directory, uint64_t height);
+
+    // Heights of the snapshot files in a directory, highest first (empty if the directory does not exist).
+    std::vector<uint64_t> listSnapshots(const std::string& directory);
+
+    // Delete all but the `keep` highest snapshots of a directory.
+    void pruneSnapshots(const std::string& directory, size_t keep);
+} // namespace SPHINXStore
+
+#endif // SPHINXSNAPSHOT_HPP
@@ -0,0 +1,239 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the sparse Merkle commitment over account balances.
+
+// Tree Shape:
+    // An account sits under the bits of its key, SPHINX_256(address), read from the most significant bit down.
+    // A subtree with one account is stored as that account's leaf, and an empty subtree is not stored at all, so the tree is about log2(accounts) deep. The shape only depends on the set of keys, which makes the root independent of the update order.
+
+// Hashing:
+    // leaf = SPHINX_256(0x00 | key | balance as 8 little-endian bytes), inner = SPHINX_256(0x01 | left | right), empty = 32 zero bytes.
+    // The one-byte prefixes keep leaves and inner nodes apart, so a proof cannot pass an inner node off as a leaf.
+
+// Proofs:
+    // A proof is the leaf (or empty subtree) at the end of the address's path plus the sibling hash at every level.
+    // An exclusion proof ends at an empty subtree or at the leaf of another key with the same path prefix; the verifier checks that prefix.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <stdexcept>
+
+#include "StateTree.hpp"
+#include "Hash.hpp"
+
+namespace SPHINXLedger {
+
+    namespace {
+        constexpr StateDigest EMPTY_HASH{};
+        constexpr size_t KEY_BITS = 256;
+
+        int bitAt(const StateDigest& key, size_t depth) {
+            return (key[depth >> 3] >> (7 - (depth & 7))) & 1;
+        }
+
+        StateDigest leafHash(const StateDigest& key, int64_t balance) {
+            std::string data(1, '\x00');
+            data.append(reinterpret_cast<const char*>(key.data()), key.size());
+            for (int i = 0; i < 8; ++i) {
+                data.push_back(static_cast<char>(static_cast<uint64_t>(balance) >> (8 * i)));
+            }
+            return SPHINXIndex::toDigest(SPHINXHash::SPHINX_256(data));
+        }
+
+        StateDigest innerHash(const StateDigest& left, const StateDigest& right) {
+            std::string data(1, '\x01');
+            data.append(reinterpret_cast<const char*>(left.data()), left.size());
+            data.append(reinterpret_cast<const char*>(right.data()), right.size());
+            return SPHINXIndex::toDigest(SPHINXHash::SPHINX_256(data));
+        }
+
+        std::string toHex(const StateDigest& digest) {
+            static const char digits[] = "0123456789abcdef";
+            std::string hex;
+            hex.reserve(digest.size() * 2);
+            for (uint8_t byte : digest) {
+                hex.push_back(digits[byte >> 4]);
+                hex.push_back(digits[byte & 0x0F]);
+            }
+            return hex;
+        }
+    } // namespace
+
+    // Serialize a proof for transport to another chain
+    nlohmann::json StateProof::toJson() const {
+        nlohmann::json proofJson;
+        proofJson["hasLeaf"] = hasLeaf;
+        proofJson["leafKey"] = toHex(leafKey);
+        proofJson["leafBalance"] = leafBalance;
+        nlohmann::json siblingsJson = nlohmann::json::array();
+        for (const StateDigest& sibling : siblings) {
+            siblingsJson.push_back(toHex(sibling));
+        }
+        proofJson["siblings"] = siblingsJson;
+        return proofJson;
+    }
+
+    // Deserialize a proof
+    StateProof StateProof::fromJson(const nlohmann::json& proofJson) {
+        StateProof proof;
+        proof.hasLeaf = proofJson.at("hasLeaf").get<bool>();
+        proof.leafKey = SPHINXIndex::toDigest(proofJson.at("leafKey").get<std::string>());
+        proof.leafBalance = proofJson.at("leafBalance").get<int64_t>();
+        for (const nlohmann::json& sibling : proofJson.at("siblings")) {
+            proof.siblings.push_back(SPHINXIndex::toDigest(sibling.get<std::string>()));
+        }
+        return proof;
+    }
+
+    // Hash an address into its tree key
+    StateDigest StateTree::keyOf(std::string_view address) {
+        return SPHINXIndex::toDigest(SPHINXHash::SPHINX_256(std::string(address)));
+    }
+
+    uint32_t StateTree::addNode(Node node) {
+        if (nodes_.size() >= NO_NODE) {
+            throw std::length_error("State tree is full");
+        }
+        nodes_.push_back(node);
+        return static_cast<uint32_t>(nodes_.size() - 1);
+    }
+
+    StateDigest StateTree::hashOf(uint32_t index) const {
+        return index == NO_NODE ? EMPTY_HASH : nodes_[index].hash;
+    }
+
+    void StateTree::update(std::string_view address, int64_t balance) {
+        update(keyOf(address), balance);
+    }
+
+    // Set the balance of a key and rehash its path
+    void StateTree::update(const StateDigest& key, int64_t balance) {
+        std::vector<uint32_t> path;  // Inner nodes from the root down, rehashed bottom-up at the end
+        uint32_t parent = NO_NODE;
+        int side = 0;
+        size_t depth = 0;
+        uint32_t current = root_;
+        while (current != NO_NODE && !nodes_[current].leaf) {
+            path.push_back(current);
+            parent = current;
+            side = bitAt(key, depth);
+            current = nodes_[current].children[side];
+            ++depth;
+        }
+
+        // Indices stay valid across addNode, references into nodes_ do not
+        auto link = [&](uint32_t child) {
+            if (parent == NO_NODE) {
+                root_ = child;
+            } else {
+                nodes_[parent].children[side] = child;
+            }
+        };
+
+        if (current != NO_NODE && nodes_[current].key == key) {
+            nodes_[current].balance = balance;
+            nodes_[current].hash = leafHash(key, balance);
+        } else {
+            Node leafNode;
+            leafNode.leaf = true;
+            leafNode.key = key;
+            leafNode.balance = balance;
+            leafNode.hash = leafHash(key, balance);
+            const uint32_t leaf = addNode(leafNode);
+            ++leafCount_;
+            if (current == NO_NODE) {
+                link(leaf);
+            } else {
+                // Another leaf owns this subtree: push both down until their keys diverge
+                const StateDigest existingKey = nodes_[current].key;
+                for (; depth < KEY_BITS; ++depth) {
+                    const uint32_t inner = addNode(Node{});
+                    link(inner);
+                    path.push_back(inner);
+                    const int newBit = bitAt(key, depth);
+                    const int existingBit = bitAt(existingKey, depth);
+                    if (newBit != existingBit) {
+                        nodes_[inner].children[newBit] = leaf;
+                        nodes_[inner].children[existingBit] = current;
+                        break;
+                    }
+                    parent = inner;
+                    side = newBit;
+                }
+            }
+        }
+
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            Node& node = nodes_[*it];
+            node.hash = innerHash(hashOf(node.children[0]), hashOf(node.children[1]));
+        }
+    }
+
+    // Get the root hash
+    std::string StateTree::root() const {
+        return toHex(hashOf(root_));
+    }
+
+    // Collect the siblings along the path of an address
+    StateProof StateTree::prove(std::string_view address) const {
+        const StateDigest key = keyOf(address);
+        StateProof proof;
+        uint32_t current = root_;
+        for (size_t depth = 0; current != NO_NODE && !nodes_[current].leaf; ++depth) {
+            const int bit = bitAt(key, depth);
+            proof.siblings.push_back(hashOf(nodes_[current].children[1 - bit]));
+            current = nodes_[current].children[bit];
+        }
+        if (current != NO_NODE) {
+            proof.hasLeaf = true;
+            proof.leafKey = nodes_[current].key;
+            proof.leafBalance = nodes_[current].balance;
+        }
+        return proof;
+    }
+
+    // Recompute the root from a proof and compare
+    std::optional<int64_t> StateTree::verify(std::string_view root, std::string_view address, const StateProof& proof) {
+        const StateDigest key = keyOf(address);
+        const size_t depth = proof.siblings.size();
+        if (depth > KEY_BITS) {
+            return std::nullopt;
+        }
+        const bool included = proof.hasLeaf && proof.leafKey == key;
+        if (proof.hasLeaf && !included) {
+            for (size_t i = 0; i < depth; ++i) {
+                if (bitAt(proof.leafKey, i) != bitAt(key, i)) {
+                    return std::nullopt;  // The other leaf is not on this address's path
+                }
+            }
+        }
+
+        StateDigest hash = proof.hasLeaf ? leafHash(proof.leafKey, proof.leafBalance) : EMPTY_HASH;
+        for (size_t i = depth; i-- > 0;) {
+            hash = bitAt(key, i) ? innerHash(proof.siblings[i], hash) : innerHash(hash, proof.siblings[i]);
+        }
+        if (toHex(hash) != root) {
+            return std::nullopt;
+        }
+        return included ? proof.leafBalance : 0;
+    }
+
+    void StateTree::clear() {
+        nodes_.clear();
+        root_ = NO_NODE;
+        leafCount_ = 0;
+    }
+} // namespace SPHINXLedger
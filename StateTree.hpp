@@ -0,0 +1,94 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXSTATETREE_HPP
+#define SPHINXSTATETREE_HPP
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json.hpp"
+#include "BlockIndex.hpp"
+
+namespace SPHINXLedger {
+
+    // 32-byte node hash or account key of the state tree.
+    using StateDigest = SPHINXIndex::BlockDigest;
+
+    // Proof of the balance of one address against a state root. The path ends either at the leaf of the address
+    // (inclusion), at the leaf of another address sharing the path (exclusion) or at an empty subtree (exclusion).
+    struct StateProof {
+        bool hasLeaf = false;  // The path ends at a leaf rather than an empty subtree
+        StateDigest leafKey{};  // Key of that leaf
+        int64_t leafBalance = 0;  // Balance of that leaf in fixed-point units
+        std::vector<StateDigest> siblings;  // Sibling hashes along the path, from the root down
+
+        nlohmann::json toJson() const;
+        static StateProof fromJson(const nlohmann::json& proofJson);
+    };
+
+    // Compact sparse Merkle tree over address -> balance. Keys are SPHINX_256(address) and a subtree holding a single
+    // leaf is replaced by that leaf, so paths are about log2(accounts) deep instead of 256, and so are proofs and
+    // updates. The root only depends on the set of (address, balance) pairs, not on the order of the updates.
+    class StateTree {
+    public:
+        // Key of an address in the tree.
+        static StateDigest keyOf(std::string_view address);
+
+        // Set the balance of an address; O(depth) hashes.
+        void update(std::string_view address, int64_t balance);
+        void update(const StateDigest& key, int64_t balance);
+
+        // Root hash as 64 hex characters (all zeros for an empty tree).
+        std::string root() const;
+
+        // Build a proof for the balance of an address.
+        StateProof prove(std::string_view address) const;
+
+        // Check a proof against a root and return the proven balance (0 for a proven absent address), or nothing if the proof is invalid.
+        static std::optional<int64_t> verify(std::string_view root, std::string_view address, const StateProof& proof);
+
+        // Number of leaves.
+        size_t size() const { return leafCount_; }
+
+        // Remove every leaf.
+        void clear();
+
+    private:
+        static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+        struct Node {
+            uint32_t children[2] = {NO_NODE, NO_NODE};  // Internal nodes only
+            bool leaf = false;
+            StateDigest key{};  // Leaves only
+            int64_t balance = 0;  // Leaves only
+            StateDigest hash{};
+        };
+
+        uint32_t addNode(Node node);
+        StateDigest hashOf(uint32_t index) const;
+
+        std::vector<Node> nodes_;  // Nodes are never freed: leaves are only ever added or updated
+        uint32_t root_ = NO_NODE;
+        size_t leafCount_ = 0;
+    };
+} // namespace SPHINXLedger
+
+#endif // SPHINXSTATETREE_HPP
@@ -0,0 +1,184 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the work-stealing thread pool used by the SPHINX chain for parallel work.
+
+// Work Queues:
+    // Every worker owns a deque protected by its own mutex, so workers rarely contend with each other.
+    // A worker pops the newest task from the back of its own deque (good cache locality) and, when its deque is empty, steals the oldest task from the front of another worker's deque.
+
+// parallelFor:
+    // parallelFor splits a range into chunks that the calling thread and up to one helper task per worker claim from a shared counter.
+    // The calling thread only ever runs chunks of its own call, never unrelated queued tasks, and once none are left to claim it sleeps on a condition variable until the claimed ones finish.
+    // A call from inside a pool task cannot deadlock: the caller can run every chunk itself, and it only waits for chunks that are already running.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+#include "ThreadPool.hpp"
+
+namespace SPHINXPool {
+
+    namespace {
+        // One parallelFor call. Helper tasks share it with the caller, so a helper that starts after the call has
+        // returned finds no chunk left and never touches fn.
+        struct ForJob {
+            ForJob(size_t first, size_t last, size_t grain, const std::function<void(size_t, size_t)>& fn)
+                : first(first), last(last), grain(grain), chunks((last - first + grain - 1) / grain), fn(fn) {}
+
+            // Claim and run chunks until none are left
+            void runChunks() {
+                for (size_t chunk = next.fetch_add(1, std::memory_order_relaxed); chunk < chunks;
+                     chunk = next.fetch_add(1, std::memory_order_relaxed)) {
+                    const size_t begin = first + chunk * grain;
+                    std::exception_ptr failure;
+                    try {
+                        fn(begin, std::min(last, begin + grain));
+                    } catch (...) {
+                        failure = std::current_exception();
+                    }
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (failure && !error) {
+                        error = std::move(failure);  // Keep the first failure, rethrown on the caller
+                    }
+                    if (++done == chunks) {
+                        finished.notify_all();
+                    }
+                }
+            }
+
+            const size_t first;
+            const size_t last;
+            const size_t grain;
+            const size_t chunks;
+            const std::function<void(size_t, size_t)>& fn;  // Only called for a claimed chunk, and the caller waits for those
+            std::atomic<size_t> next{0};  // Next chunk to claim
+            std::mutex mutex;
+            std::condition_variable finished;
+            size_t done = 0;  // Chunks finished, guarded by mutex
+            std::exception_ptr error;  // Guarded by mutex
+        };
+    } // namespace
+
+    ThreadPool::ThreadPool(size_t workerCount) {
+        if (workerCount == 0) {
+            workerCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+        for (size_t i = 0; i < workerCount; ++i) {
+            queues_.push_back(std::make_unique<WorkQueue>());
+        }
+        for (size_t i = 0; i < workerCount; ++i) {
+            workers_.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            stopping_ = true;
+        }
+        wakeup_.notify_all();
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    // Get the process-wide pool
+    ThreadPool& ThreadPool::shared() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    // Queue a task on the next worker deque
+    void ThreadPool::submit(Task task) {
+        size_t index = nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+        {
+            std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+            queues_[index]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            pending_.fetch_add(1, std::memory_order_release);
+        }
+        wakeup_.notify_one();
+    }
+
+    // Take a task from the own deque (back) or steal one from another deque (front)
+    bool ThreadPool::popTask(size_t index, Task& task) {
+        const size_t count = queues_.size();
+        for (size_t offset = 0; offset < count; ++offset) {
+            WorkQueue& queue = *queues_[(index + offset) % count];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            if (offset == 0) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            pending_.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+        return false;
+    }
+
+    void ThreadPool::workerLoop(size_t index) {
+        for (;;) {
+            Task task;
+            if (popTask(index, task)) {
+                task();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex_);
+            wakeup_.wait(lock, [this] { return stopping_ || pending_.load(std::memory_order_acquire) > 0; });
+            if (stopping_ && pending_.load(std::memory_order_acquire) == 0) {
+                return;
+            }
+        }
+    }
+
+    // Split [first, last) into chunks, run them on the pool and wait for completion
+    void ThreadPool::parallelFor(size_t first, size_t last, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+        if (first >= last) {
+            return;
+        }
+        grain = std::max<size_t>(1, grain);
+        const size_t chunks = (last - first + grain - 1) / grain;
+        if (chunks == 1) {
+            fn(first, last);  // Not worth a round trip through the queues
+            return;
+        }
+
+        // One helper per worker at most; a helper runs as many chunks as it can claim
+        const std::shared_ptr<ForJob> job = std::make_shared<ForJob>(first, last, grain, fn);
+        const size_t helpers = std::min(chunks - 1, size());
+        for (size_t i = 0; i < helpers; ++i) {
+            submit([job] { job->runChunks(); });
+        }
+        job->runChunks();  // The caller helps with its own chunks only
+
+        std::unique_lock<std::mutex> lock(job->mutex);
+        job->finished.wait(lock, [&] { return job->done == job->chunks; });  // Only chunks other threads are running are left
+        if (job->error) {
+            std::rethrow_exception(job->error);
+        }
+    }
+} // namespace SPHINXPool
@@ -0,0 +1,78 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXTHREADPOOL_HPP
+#define SPHINXTHREADPOOL_HPP
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SPHINXPool {
+
+    // Work-stealing thread pool used by the chain for CPU-bound fan-out work (validation, verification, decoding).
+    // Every worker owns a deque: it pops its own tasks from the back and steals from the front of the others.
+    class ThreadPool {
+    public:
+        using Task = std::function<void()>;
+
+        // Create a pool with the given number of workers (0 means one per hardware thread).
+        explicit ThreadPool(size_t workerCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Process-wide pool shared by all chains.
+        static ThreadPool& shared();
+
+        // Queue a task; tasks are spread round-robin over the worker deques.
+        void submit(Task task);
+
+        // Run fn(begin, end) over [first, last) split into chunks of at most grain items and wait for all of them.
+        // The calling thread runs chunks of this call alongside the workers and then sleeps until the rest finish; it never
+        // runs unrelated queued tasks. Nested calls cannot deadlock, since the caller can run every chunk itself.
+        void parallelFor(size_t first, size_t last, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+        // Number of worker threads.
+        size_t size() const { return queues_.size(); }
+
+    private:
+        struct WorkQueue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void workerLoop(size_t index);
+        bool popTask(size_t index, Task& task);  // Own queue first, then steal from the others
+
+        std::vector<std::unique_ptr<WorkQueue>> queues_;  // One deque per worker
+        std::vector<std::thread> workers_;  // Worker threads
+        std::atomic<size_t> nextQueue_{0};  // Round-robin submission cursor
+        std::atomic<size_t> pending_{0};  // Tasks queued but not yet taken
+        std::mutex sleepMutex_;  // Guards idle workers sleeping on wakeup_
+        std::condition_variable wakeup_;
+        bool stopping_ = false;
+    };
+} // namespace SPHINXPool
+
+#endif // SPHINXTHREADPOOL_HPP
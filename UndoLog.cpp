@@ -0,0 +1,115 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code implements the per-block undo history of a ledger.
+
+// Records:
+    // A record belongs to the height of the next block at the time of the change, so it holds the changes made between two blocks together with the changes of the later block itself. Only the first change of an account per record is saved; a per-account stamp of the newest record holding it makes that check O(1).
+    // Records are only opened for blocks that change something, and the oldest ones are dropped once they fall more than the depth behind the newest, which moves the floor up.
+
+// Rollback and redo:
+    // Rolling back swaps the saved balances with the current ones, newest record first. The records then hold the balances that were undone, so swapping them back oldest first restores the ledger exactly; reorgs use this to return to the old chain when a branch fails.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "UndoLog.hpp"
+
+namespace SPHINXLedger {
+
+    void UndoLog::reset(uint32_t height) {
+        records_.clear();
+        saved_.clear();
+        floor_ = height;
+    }
+
+    // Save a balance into the record of height, opening it if needed
+    void UndoLog::save(const Ledger& ledger, AddressId id, uint32_t height) {
+        if (height < floor_ || (!records_.empty() && height < records_.back().height)) {
+            throw std::logic_error("Undo records must be saved in block order");
+        }
+        if (records_.empty() || records_.back().height != height) {
+            records_.push_back(UndoRecord{height, {}, {}});
+            trim(height);
+        }
+        if (id >= saved_.size()) {
+            saved_.resize(std::max<size_t>(id + 1, ledger.accountCount()), 0);
+        }
+        if (saved_[id] == height + 1) {
+            return;  // Already saved for this block
+        }
+        saved_[id] = height + 1;
+        records_.back().ids.push_back(id);
+        records_.back().balances.push_back(ledger.balance(id));
+    }
+
+    void UndoLog::save(Ledger& ledger, std::span<const BalanceDelta> deltas, uint32_t height) {
+        for (const BalanceDelta& delta : deltas) {
+            save(ledger, ledger.intern(delta.first), height);
+        }
+    }
+
+    // Drop the records that fell out of the depth
+    void UndoLog::trim(uint32_t height) {
+        while (!records_.empty() && records_.front().height + depth_ < height) {
+            floor_ = std::max(floor_, records_.front().height + 1);
+            records_.pop_front();
+        }
+    }
+
+    // Swap the saved balances back in, newest record first
+    std::vector<UndoRecord> UndoLog::rollback(Ledger& ledger, uint32_t height) {
+        if (height < floor_) {
+            throw std::out_of_range("No undo records below height " + std::to_string(floor_));
+        }
+        std::vector<UndoRecord> undone;
+        while (!records_.empty() && records_.back().height >= height) {
+            UndoRecord& record = records_.back();
+            for (size_t i = 0; i < record.ids.size(); ++i) {
+                const Amount current = ledger.balance(record.ids[i]);
+                ledger.set(record.ids[i], record.balances[i]);
+                record.balances[i] = current;
+                saved_[record.ids[i]] = 0;
+            }
+            undone.push_back(std::move(record));
+            records_.pop_back();
+        }
+        std::reverse(undone.begin(), undone.end());
+        return undone;
+    }
+
+    // Swap the undone balances back in, oldest record first
+    void UndoLog::redo(Ledger& ledger, std::vector<UndoRecord> records) {
+        for (UndoRecord& record : records) {
+            if (!records_.empty() && record.height <= records_.back().height) {
+                throw std::logic_error("Undo records must be redone in block order");
+            }
+            for (size_t i = 0; i < record.ids.size(); ++i) {
+                const Amount current = ledger.balance(record.ids[i]);
+                ledger.set(record.ids[i], record.balances[i]);
+                record.balances[i] = current;
+                if (record.ids[i] >= saved_.size()) {
+                    saved_.resize(std::max<size_t>(record.ids[i] + 1, ledger.accountCount()), 0);
+                }
+                saved_[record.ids[i]] = record.height + 1;
+            }
+            records_.push_back(std::move(record));
+        }
+    }
+} // namespace SPHINXLedger
@@ -0,0 +1,85 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+
+#ifndef SPHINXUNDOLOG_HPP
+#define SPHINXUNDOLOG_HPP
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+
+#include "Ledger.hpp"
+
+namespace SPHINXLedger {
+
+    // Blocks of undo history kept by default.
+    constexpr size_t UNDO_DEPTH = 100;
+
+    // Balances of the accounts changed on the way to one block, as they were before the first change.
+    struct UndoRecord {
+        uint32_t height = 0;  // Height of the next block when the changes were made: the changes after block height - 1, up to and including block height
+        std::vector<AddressId> ids;
+        std::vector<Amount> balances;  // Balance of ids[i] before the change
+    };
+
+    // Per-block undo history of a ledger. Before an account changes, its balance is saved into the record of the block
+    // being built, once per block, so rolling back costs the accounts that changed rather than a replay of the chain.
+    // Records older than the depth are dropped as new blocks arrive.
+    class UndoLog {
+    public:
+        explicit UndoLog(size_t depth = UNDO_DEPTH) : depth_(depth) {}
+
+        // Forget the history and take the current balances as the state before height: rollbacks go back to it and no further.
+        void reset(uint32_t height);
+
+        // Blocks of history to keep.
+        void setDepth(size_t depth) { depth_ = depth; }
+        size_t depth() const { return depth_; }
+
+        // Save the balance of an account that is about to change while height is the next block. Heights may not go
+        // back, except through rollback.
+        void save(const Ledger& ledger, AddressId id, uint32_t height);
+
+        // Save the balances of the addresses of a batch, adding the new ones to the ledger.
+        void save(Ledger& ledger, std::span<const BalanceDelta> deltas, uint32_t height);
+
+        // Lowest height rollback accepts.
+        uint32_t floor() const { return floor_; }
+
+        // Put the balances back as they were before any change saved at height or above; throws std::out_of_range below
+        // floor(). Returns the undone records, oldest first, now holding the balances they replaced, for redo.
+        // Accounts that were added since stay in the ledger with a zero balance.
+        std::vector<UndoRecord> rollback(Ledger& ledger, uint32_t height);
+
+        // Reapply what rollback returned, so the ledger and the log are back where they were before it.
+        void redo(Ledger& ledger, std::vector<UndoRecord> records);
+
+        // Number of records held.
+        size_t size() const { return records_.size(); }
+
+    private:
+        void trim(uint32_t height);
+
+        std::deque<UndoRecord> records_;  // Ascending heights; blocks without changes have no record
+        std::vector<uint32_t> saved_;  // Account id -> height + 1 of the newest record holding it, 0 if none
+        uint32_t floor_ = 0;
+        size_t depth_;
+    };
+} // namespace SPHINXLedger
+
+#endif // SPHINXUNDOLOG_HPP
@@ -0,0 +1,150 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code measures the size and the random-access reads of the compressed block archive (Archive.hpp) against the block file (BlockStore.hpp) and the JSON file save() used to write.
+
+// Workload:
+    // 20000 blocks of 20 transactions are written three ways: as a pretty-printed JSON document (the old save), as a block file and as an archive with the default frame size.
+    // 20000 blocks at random heights are then read from the block file and from the archive, and their hashes are checked against the blocks written. A JSON file has no index, so reading any block from it costs parsing the whole document, which is timed once.
+
+// Build (from the repository root, with the same include paths as the chain):
+    // g++ -std=c++20 -O2 -I. bench/ArchiveBench.cpp Archive.cpp BlockStore.cpp Compress.cpp -o archive_bench
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Archive.hpp"
+#include "BlockStore.hpp"
+#include "Hash.hpp"
+#include "json.hpp"
+
+using SPHINXStore::ArchiveWriter;
+using SPHINXStore::BlockArchive;
+using SPHINXStore::BlockStore;
+using SPHINXStore::BlockWriter;
+
+namespace {
+    constexpr size_t BLOCKS = 20000;
+    constexpr size_t TRANSACTIONS = 20;
+    constexpr size_t READS = 20000;
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+} // namespace
+
+int main() {
+    std::vector<SPHINXBlock::Block> blocks;
+    blocks.reserve(BLOCKS);
+    std::string previousHash = SPHINXHash::SPHINX_256("genesis");
+    for (size_t i = 0; i < BLOCKS; ++i) {
+        SPHINXBlock::Block block(previousHash);
+        for (size_t t = 0; t < TRANSACTIONS; ++t) {
+            block.addTransaction(SPHINXTrx::Transaction());
+        }
+        previousHash = std::string(block.getBlockHash());
+        blocks.push_back(std::move(block));
+    }
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path();
+    const std::string jsonFilename = (directory / "sphinx_archive_bench.json").string();
+    const std::string storeFilename = (directory / "sphinx_archive_bench.blk").string();
+    const std::string archiveFilename = (directory / "sphinx_archive_bench.arc").string();
+    nlohmann::json metadata;
+    metadata["SPHINXPubKey"] = "bench";
+
+    {
+        nlohmann::json chainJson;
+        chainJson["blocks"] = nlohmann::json::array();
+        for (const SPHINXBlock::Block& block : blocks) {
+            chainJson["blocks"].push_back(block.toJson());
+        }
+        std::ofstream output(jsonFilename);
+        output << chainJson.dump(4);
+    }
+    {
+        BlockWriter writer(storeFilename, metadata);
+        for (const SPHINXBlock::Block& block : blocks) {
+            writer.append(block);
+        }
+        writer.finish();
+    }
+    auto start = std::chrono::steady_clock::now();
+    ArchiveWriter archiveWriter(archiveFilename, metadata);
+    for (const SPHINXBlock::Block& block : blocks) {
+        archiveWriter.append(block);
+    }
+    archiveWriter.finish();
+    const double archiveWriteSeconds = secondsSince(start);
+
+    const uintmax_t jsonBytes = std::filesystem::file_size(jsonFilename);
+    const uintmax_t storeBytes = std::filesystem::file_size(storeFilename);
+    const uintmax_t archiveBytes = std::filesystem::file_size(archiveFilename);
+
+    // The same random heights for both readers
+    std::mt19937_64 random(1);
+    std::vector<size_t> heights(READS);
+    for (size_t& height : heights) {
+        height = random() % BLOCKS;
+    }
+    size_t mismatches = 0;
+
+    start = std::chrono::steady_clock::now();
+    const std::shared_ptr<BlockStore> store = BlockStore::open(storeFilename);
+    for (size_t height : heights) {
+        mismatches += store->decodeBlock(height).getBlockHash() != blocks[height].getBlockHash();
+    }
+    const double storeSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    const std::shared_ptr<BlockArchive> archive = BlockArchive::open(archiveFilename);
+    const double archiveOpenSeconds = secondsSince(start);
+    start = std::chrono::steady_clock::now();
+    for (size_t height : heights) {
+        mismatches += archive->decodeBlock(height).getBlockHash() != blocks[height].getBlockHash();
+    }
+    const double archiveSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    {
+        std::ifstream input(jsonFilename);
+        const nlohmann::json chainJson = nlohmann::json::parse(input);
+        SPHINXBlock::Block block("");
+        block.fromJson(chainJson["blocks"][heights[0]]);
+        mismatches += block.getBlockHash() != blocks[heights[0]].getBlockHash();
+    }
+    const double jsonSeconds = secondsSince(start);
+
+    std::printf("size:    json %.2f MB, block file %.2f MB, archive %.2f MB (%.1fx smaller than json, %zu frames, written in %.0f ms)\n",
+                jsonBytes / 1e6, storeBytes / 1e6, archiveBytes / 1e6, static_cast<double>(jsonBytes) / archiveBytes,
+                archive->frameCount(), archiveWriteSeconds * 1e3);
+    std::printf("reads:   block file %.1f us, archive %.1f us per random block (archive opened in %.2f ms)\n",
+                storeSeconds * 1e6 / READS, archiveSeconds * 1e6 / READS, archiveOpenSeconds * 1e3);
+    std::printf("json:    %.0f ms to parse the document before the first block can be read\n", jsonSeconds * 1e3);
+
+    std::filesystem::remove(jsonFilename);
+    std::filesystem::remove(storeFilename);
+    std::filesystem::remove(archiveFilename);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code measures block access by value against access by reference and by range (ChainView.hpp, SegmentedList.hpp).
+
+// Workload:
+    // 20000 blocks of 50 transactions are held in a segmented block list, the way Chain keeps the blocks in memory, and published as a ChainView.
+    // Every block is read three ways: copied out, as getBlockAt did before it stopped returning by value; by const reference through ChainView::getBlockAt; and through the shared pointer that SegmentedList::share hands out, which is what Chain::getBlockAt and the iterators of Chain::blocks(from, to) hold.
+    // Block hashes are read as SPHINXView::BlockHash and as std::string copies.
+
+// Build (from the repository root, with the same include paths as the chain):
+    // g++ -std=c++20 -O2 -I. bench/BlockAccessBench.cpp ChainView.cpp BlockStore.cpp Ledger.cpp StateTree.cpp BlockIndex.cpp -o block_access_bench
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "ChainView.hpp"
+#include "Hash.hpp"
+
+using SPHINXView::BlockList;
+using SPHINXView::ChainView;
+
+namespace {
+    constexpr size_t BLOCKS = 20000;
+    constexpr size_t TRANSACTIONS = 50;
+    constexpr size_t ROUNDS = 5;
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+} // namespace
+
+int main() {
+    BlockList blocks;
+    for (size_t i = 0; i < BLOCKS; ++i) {
+        SPHINXBlock::Block block(SPHINXHash::SPHINX_256("block" + std::to_string(i)));
+        for (size_t t = 0; t < TRANSACTIONS; ++t) {
+            block.addTransaction(SPHINXTrx::Transaction());
+        }
+        blocks.push_back(std::move(block));
+    }
+    const ChainView view(1, nullptr, blocks.snapshot(), nullptr);
+    SPHINXBlock::Block scratch("");
+
+    // Every mode sums the transaction counts, so none of the reads can be optimized away
+    size_t byValue = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < ROUNDS; ++round) {
+        for (size_t i = 0; i < BLOCKS; ++i) {
+            const SPHINXBlock::Block block = view.getBlockAt(i, scratch);  // Deep copy, transaction list included
+            byValue += block.getTransactions().size();
+        }
+    }
+    const double valueSeconds = secondsSince(start);
+
+    size_t byReference = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < ROUNDS; ++round) {
+        for (size_t i = 0; i < BLOCKS; ++i) {
+            byReference += view.getBlockAt(i, scratch).getTransactions().size();
+        }
+    }
+    const double referenceSeconds = secondsSince(start);
+
+    size_t byRange = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < ROUNDS; ++round) {
+        for (size_t i = 0; i < BLOCKS; ++i) {
+            const std::shared_ptr<const SPHINXBlock::Block> block = blocks.share(i);  // What a block iterator holds
+            byRange += block->getTransactions().size();
+        }
+    }
+    const double rangeSeconds = secondsSince(start);
+
+    size_t hashBytes = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < ROUNDS; ++round) {
+        for (size_t i = 0; i < BLOCKS; ++i) {
+            const std::string hash(view.getBlockHash(i));
+            hashBytes += hash.size();
+        }
+    }
+    const double hashCopySeconds = secondsSince(start);
+
+    size_t hashViewBytes = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < ROUNDS; ++round) {
+        for (size_t i = 0; i < BLOCKS; ++i) {
+            hashViewBytes += view.getBlockHash(i).size();
+        }
+    }
+    const double hashViewSeconds = secondsSince(start);
+
+    const double reads = static_cast<double>(BLOCKS * ROUNDS);
+    std::printf("by value:     %.0f ns per block\n", valueSeconds * 1e9 / reads);
+    std::printf("by reference: %.0f ns per block (%.0fx)\n", referenceSeconds * 1e9 / reads, valueSeconds / referenceSeconds);
+    std::printf("by range:     %.0f ns per block (%.0fx)\n", rangeSeconds * 1e9 / reads, valueSeconds / rangeSeconds);
+    std::printf("hash copy:    %.0f ns, hash view: %.0f ns\n", hashCopySeconds * 1e9 / reads, hashViewSeconds * 1e9 / reads);
+    return byValue == byReference && byValue == byRange && hashBytes == hashViewBytes ? 0 : 1;
+}
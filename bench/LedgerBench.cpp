@@ -0,0 +1,181 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code measures balance updates and lookups on the fixed-point ledger (Ledger.hpp) against std::unordered_map<std::string, double>.
+
+// Workload:
+    // 200000 accounts with 64-character hex addresses are created, then 2000000 updates of 0.1 and 2000000 lookups hit random accounts on both structures.
+    // The ledger also takes the same updates through interned ids and in block-sized batches of 1000 deltas (applyBatch), the way blocks are applied.
+    // Heap bytes per account are counted for both, and the sum of the balances is checked: the fixed-point ledger must be exact, the doubles are reported as they drift.
+
+// Build (from the repository root, with the same include paths as the chain):
+    // g++ -std=c++20 -O2 -I. bench/LedgerBench.cpp Ledger.cpp StateTree.cpp BlockIndex.cpp -o ledger_bench
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Hash.hpp"
+#include "Ledger.hpp"
+
+using SPHINXLedger::Amount;
+using SPHINXLedger::Ledger;
+
+namespace {
+    constexpr size_t ACCOUNTS = 200000;
+    constexpr size_t OPERATIONS = 2000000;
+    constexpr size_t BATCH = 1000;
+    constexpr double AMOUNT = 0.1;
+
+    size_t heapBytes = 0;  // Bytes currently allocated through operator new
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+} // namespace
+
+// Count heap bytes; the size is kept in front of every block so delete can subtract it
+void* operator new(size_t size) {
+    size_t* block = static_cast<size_t*>(std::malloc(size + sizeof(std::max_align_t)));
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    *block = size;
+    heapBytes += size;
+    return reinterpret_cast<char*>(block) + sizeof(std::max_align_t);
+}
+
+void operator delete(void* pointer) noexcept {
+    if (pointer != nullptr) {
+        size_t* block = reinterpret_cast<size_t*>(static_cast<char*>(pointer) - sizeof(std::max_align_t));
+        heapBytes -= *block;
+        std::free(block);
+    }
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    operator delete(pointer);
+}
+
+int main() {
+    std::vector<std::string> addresses;
+    addresses.reserve(ACCOUNTS);
+    for (size_t i = 0; i < ACCOUNTS; ++i) {
+        addresses.push_back(SPHINXHash::SPHINX_256("account" + std::to_string(i)));
+    }
+    std::mt19937_64 random(1);
+    std::vector<uint32_t> picks(OPERATIONS);
+    for (uint32_t& pick : picks) {
+        pick = static_cast<uint32_t>(random() % ACCOUNTS);
+    }
+    const Amount units = SPHINXLedger::toAmount(AMOUNT);
+
+    // unordered_map<string, double>, as the chain kept balances before the ledger
+    size_t before = heapBytes;
+    auto start = std::chrono::steady_clock::now();
+    std::unordered_map<std::string, double> map;
+    for (const std::string& address : addresses) {
+        map[address] = 0.0;
+    }
+    const double mapInsertSeconds = secondsSince(start);
+    const size_t mapBytes = heapBytes - before;
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t pick : picks) {
+        map[addresses[pick]] += AMOUNT;
+    }
+    const double mapUpdateSeconds = secondsSince(start);
+
+    double mapSum = 0.0;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t pick : picks) {
+        mapSum += map.find(addresses[pick])->second;
+    }
+    const double mapLookupSeconds = secondsSince(start);
+
+    // Fixed-point ledger
+    before = heapBytes;
+    start = std::chrono::steady_clock::now();
+    Ledger ledger;
+    std::vector<SPHINXLedger::AddressId> ids;
+    ids.reserve(ACCOUNTS);
+    for (const std::string& address : addresses) {
+        ids.push_back(ledger.intern(address));
+    }
+    const double ledgerInsertSeconds = secondsSince(start);
+    const size_t ledgerBytes = heapBytes - before - ids.capacity() * sizeof(SPHINXLedger::AddressId);
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t pick : picks) {
+        ledger.add(addresses[pick], units);
+    }
+    const double ledgerUpdateSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t pick : picks) {
+        ledger.add(ids[pick], units);
+    }
+    const double ledgerIdSeconds = secondsSince(start);
+
+    // Block-sized batches; addresses must be unique within a batch, so every batch walks consecutive accounts
+    std::vector<SPHINXLedger::BalanceDelta> deltas;
+    deltas.reserve(BATCH);
+    start = std::chrono::steady_clock::now();
+    for (size_t first = 0; first < OPERATIONS; first += BATCH) {
+        deltas.clear();
+        for (size_t i = first; i < first + BATCH; ++i) {
+            deltas.emplace_back(addresses[i % ACCOUNTS], units);
+        }
+        ledger.applyBatch(deltas);
+    }
+    const double ledgerBatchSeconds = secondsSince(start);
+
+    Amount ledgerSum = 0;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t pick : picks) {
+        ledgerSum += ledger.balance(addresses[pick]);
+    }
+    const double ledgerLookupSeconds = secondsSince(start);
+
+    // The accounts took 3 * OPERATIONS credits of 0.1 between them; the ledger must hold exactly that
+    Amount total = 0;
+    ledger.forEach([&](std::string_view, Amount amount) { total += amount; });
+    const Amount expected = units * static_cast<Amount>(OPERATIONS * 3);
+    double mapTotal = 0.0;
+    for (const auto& [address, balance] : map) {
+        mapTotal += balance;
+    }
+
+    const double operations = static_cast<double>(OPERATIONS);
+    std::printf("map:    insert %.0f ns, update %.0f ns, lookup %.0f ns (%.0f lookups/s), %.1f bytes per account\n",
+                mapInsertSeconds * 1e9 / ACCOUNTS, mapUpdateSeconds * 1e9 / operations, mapLookupSeconds * 1e9 / operations,
+                operations / mapLookupSeconds, static_cast<double>(mapBytes) / ACCOUNTS);
+    std::printf("ledger: insert %.0f ns, update %.0f ns (by id %.0f ns, batched %.0f ns), lookup %.0f ns (%.0f lookups/s), %.1f bytes per account (memoryUsage %.1f)\n",
+                ledgerInsertSeconds * 1e9 / ACCOUNTS, ledgerUpdateSeconds * 1e9 / operations, ledgerIdSeconds * 1e9 / operations,
+                ledgerBatchSeconds * 1e9 / operations, ledgerLookupSeconds * 1e9 / operations, operations / ledgerLookupSeconds,
+                static_cast<double>(ledgerBytes) / ACCOUNTS, static_cast<double>(ledger.memoryUsage()) / ledger.accountCount());
+    std::printf("totals: ledger %.8f (expected %.8f), map off by %.3e after %zu updates (lookup sums %.1f / %.1f)\n",
+                SPHINXLedger::toDouble(total), SPHINXLedger::toDouble(expected), mapTotal - AMOUNT * operations, OPERATIONS, mapSum,
+                SPHINXLedger::toDouble(ledgerSum));
+    return total == expected ? 0 : 1;
+}
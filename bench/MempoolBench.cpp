@@ -0,0 +1,138 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code measures the throughput of the transaction pool (Mempool.hpp).
+
+// Workload:
+    // 200000 transactions from 20000 senders with random fees and sizes go into a pool capped at 100000, so the second half of the run also pays for evictions.
+    // A 2 MB block is then selected and removed, and four threads submit with pool-assigned nonces while a fifth selects blocks, which checks that concurrent senders get distinct nonces.
+
+// Build (from the repository root, with the same include paths as the chain):
+    // g++ -std=c++20 -O2 -I. bench/MempoolBench.cpp Mempool.cpp BlockIndex.cpp -o mempool_bench -pthread
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Hash.hpp"
+#include "Mempool.hpp"
+
+using SPHINXTxPool::AddResult;
+using SPHINXTxPool::PoolEntry;
+using SPHINXTxPool::TransactionPool;
+
+namespace {
+    constexpr size_t TRANSACTIONS = 200000;
+    constexpr size_t SENDERS = 20000;
+    constexpr size_t THREADS = 4;
+    constexpr size_t PER_THREAD = 20000;
+    constexpr SPHINXLedger::Amount RICH = SPHINXLedger::Amount(1) << 40;
+
+    PoolEntry makeEntry(const std::string& seed, std::string sender, uint64_t nonce, SPHINXLedger::Amount fee, size_t size) {
+        PoolEntry entry;
+        entry.id = SPHINXHash::SPHINX_256(seed);
+        entry.sender = std::move(sender);
+        entry.nonce = nonce;
+        entry.amount = 1000;
+        entry.fee = fee;
+        entry.size = size;
+        return entry;
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+} // namespace
+
+int main() {
+    TransactionPool pool({100000, size_t(1) << 40, 10});
+
+    // Entries are built up front so only the pool is timed
+    std::mt19937_64 random(1);
+    std::vector<uint64_t> nonces(SENDERS, 0);
+    std::vector<PoolEntry> entries;
+    entries.reserve(TRANSACTIONS);
+    for (size_t i = 0; i < TRANSACTIONS; ++i) {
+        const size_t sender = random() % SENDERS;
+        entries.push_back(makeEntry("tx" + std::to_string(i), "s" + std::to_string(sender), nonces[sender]++,
+                                    1 + static_cast<SPHINXLedger::Amount>(random() % 10000), 200 + random() % 300));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t admitted = 0;
+    for (PoolEntry& entry : entries) {
+        admitted += pool.add(std::move(entry), RICH) == AddResult::Added;
+    }
+    const double addSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    const std::vector<PoolEntry> block = pool.selectForBlock(2 * 1024 * 1024);
+    const double selectSeconds = secondsSince(start);
+
+    std::vector<std::string> ids;
+    ids.reserve(block.size());
+    for (const PoolEntry& entry : block) {
+        ids.push_back(entry.id);
+    }
+    start = std::chrono::steady_clock::now();
+    pool.remove(ids);
+    const double removeSeconds = secondsSince(start);
+
+    std::printf("add:    %zu transactions, %.0f ns each, %.0f tx/s (%zu admitted, %llu evicted)\n", TRANSACTIONS,
+                addSeconds * 1e9 / TRANSACTIONS, TRANSACTIONS / addSeconds, admitted,
+                static_cast<unsigned long long>(pool.stats().evicted));
+    std::printf("select: %zu transactions in %.2f ms\n", block.size(), selectSeconds * 1e3);
+    std::printf("remove: %zu transactions in %.2f ms\n", ids.size(), removeSeconds * 1e3);
+
+    // Concurrent submissions with pool-assigned nonces against a block producer
+    std::atomic<size_t> conflicts{0};
+    std::atomic<bool> producing{true};
+    start = std::chrono::steady_clock::now();
+    std::thread producer([&] {
+        while (producing.load(std::memory_order_relaxed)) {
+            pool.selectForBlock(100000);
+        }
+    });
+    std::vector<std::thread> submitters;
+    for (size_t t = 0; t < THREADS; ++t) {
+        submitters.emplace_back([&, t] {
+            for (size_t i = 0; i < PER_THREAD; ++i) {
+                // Every thread submits for the same sender, so nonces only stay distinct if the pool assigns them
+                PoolEntry entry = makeEntry("c" + std::to_string(t) + "_" + std::to_string(i), "shared", 0, 1 + i % 7, 300);
+                if (pool.add(std::move(entry), RICH, true) == AddResult::NonceConflict) {
+                    conflicts.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    for (std::thread& submitter : submitters) {
+        submitter.join();
+    }
+    producing.store(false, std::memory_order_relaxed);
+    producer.join();
+    const double concurrentSeconds = secondsSince(start);
+
+    std::printf("shared: %zu threads, %.0f tx/s, %zu nonce conflicts, next nonce %llu\n", THREADS,
+                THREADS * PER_THREAD / concurrentSeconds, conflicts.load(),
+                static_cast<unsigned long long>(pool.nextNonce("shared")));
+    return conflicts.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+/*
+ *  Copyright (c) (2023) SPHINX_ORG
+ *  Authors:
+ *    - (C kusuma) <thekoesoemo@gmail.com>
+ *      GitHub: (https://github.com/chykusuma)
+ *  Contributors:
+ *    - (Contributor 1) <email1@example.com>
+ *      Github: (https://github.com/yourgit)
+ *    - (Contributor 2) <email2@example.com>
+ *      Github: (https://github.com/yourgit)
+ */
+
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// This code measures signing with the cached key of the key manager (KeyManager.hpp) against signing with a keypair generated per call.
+
+// Workload:
+    // 200 signatures the uncached way: a hybrid keypair is generated for every signature, as signTransaction did before the key manager.
+    // 20000 signatures through KeyManager::sign on one thread, then on four threads sharing one manager, which checks that the keypair is generated exactly once.
+
+// Build (from the repository root, with the same include paths as the chain):
+    // g++ -std=c++20 -O2 -I. bench/SigningBench.cpp KeyManager.cpp -o signing_bench -pthread
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Key.hpp"
+#include "KeyManager.hpp"
+#include "Sign.hpp"
+
+using SPHINXKeys::KeyManager;
+
+namespace {
+    constexpr size_t UNCACHED = 200;
+    constexpr size_t CACHED = 20000;
+    constexpr size_t THREADS = 4;
+
+    std::string message(size_t i) {
+        return "transfer:sender" + std::to_string(i % 1000) + ":recipient" + std::to_string(i % 777) + ":" + std::to_string(i);
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+} // namespace
+
+int main() {
+    // Uncached: keygen on every call
+    size_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < UNCACHED; ++i) {
+        SPHINXHybridKey::HybridKeypair keyPair = SPHINXKey::generate_hybrid_keypair();
+        const std::string privateKey = SPHINXKey::sphinxKeyToString(keyPair.merged_key.sphinxPrivKey);
+        bytes += SPHINXSign::signTransactionData(message(i), privateKey).size();
+    }
+    const double uncachedSeconds = secondsSince(start);
+
+    // Cached: one keygen for the lifetime of the manager
+    KeyManager keys;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < CACHED; ++i) {
+        bytes += keys.sign(message(i)).size();
+    }
+    const double cachedSeconds = secondsSince(start);
+
+    KeyManager shared;
+    start = std::chrono::steady_clock::now();
+    std::vector<std::thread> signers;
+    for (size_t t = 0; t < THREADS; ++t) {
+        signers.emplace_back([&, t] {
+            for (size_t i = t; i < CACHED; i += THREADS) {
+                shared.sign(message(i));
+            }
+        });
+    }
+    for (std::thread& signer : signers) {
+        signer.join();
+    }
+    const double sharedSeconds = secondsSince(start);
+
+    std::printf("uncached: %zu signatures, %.2f us each, %.0f sig/s\n", UNCACHED, uncachedSeconds * 1e6 / UNCACHED, UNCACHED / uncachedSeconds);
+    std::printf("cached:   %zu signatures, %.2f us each, %.0f sig/s (%.0fx)\n", CACHED, cachedSeconds * 1e6 / CACHED, CACHED / cachedSeconds,
+                (uncachedSeconds / UNCACHED) / (cachedSeconds / CACHED));
+    std::printf("shared:   %zu threads, %.0f sig/s, %llu signatures, %llu keypairs generated (%zu signature bytes)\n", THREADS,
+                CACHED / sharedSeconds, static_cast<unsigned long long>(shared.signatureCount()),
+                static_cast<unsigned long long>(shared.keyGenerations()), bytes);
+    return keys.keyGenerations() == 1 && shared.keyGenerations() == 1 && shared.signatureCount() == CACHED ? 0 : 1;
+}